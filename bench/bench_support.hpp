@@ -0,0 +1,151 @@
+#ifndef bench_bench_support_hpp
+#define bench_bench_support_hpp
+/**
+ * @file
+ *
+ * Helpers shared by the Skye benchmarks.
+ *
+ * This header replaces the global operator new and operator delete to
+ * count allocations, so it must be included by exactly one translation
+ * unit in each benchmark program.
+ *
+ * The results are printed as JSON lines, one object per scenario,
+ * so the output of several runs (or several programs) can be
+ * concatenated and compared with standard tools.
+ */
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <sstream>
+#include <string>
+
+namespace bench {
+/// The number of calls to operator new since the program started.
+inline std::atomic<std::size_t> & allocations() {
+  static std::atomic<std::size_t> counter(0);
+  return counter;
+}
+} // namespace bench
+
+// The replacements are not inlined, otherwise g++ warns about
+// mismatched new and free() calls.
+__attribute__((noinline)) void * operator new(std::size_t size) {
+  ++bench::allocations();
+  void * p = std::malloc(size == 0 ? 1 : size);
+  if (p == nullptr) {
+    throw std::bad_alloc();
+  }
+  return p;
+}
+
+__attribute__((noinline)) void operator delete(void * p) noexcept {
+  std::free(p);
+}
+
+namespace bench {
+
+/**
+ * Accumulate the measurements for a single scenario.
+ *
+ * Start the measurement with start() and stop it with stop(), the
+ * time and allocations outside those calls are not counted, so the
+ * scenario setup can be excluded.
+ */
+class measurement {
+ public:
+  measurement()
+      : elapsed_(0)
+      , allocs_(0)
+      , start_time_()
+      , start_allocs_(0)
+  {}
+
+  void start() {
+    start_allocs_ = allocations();
+    start_time_ = std::chrono::steady_clock::now();
+  }
+  void stop() {
+    auto end = std::chrono::steady_clock::now();
+    allocs_ += allocations() - start_allocs_;
+    elapsed_ += end - start_time_;
+  }
+
+  //@{
+  /**
+   * @name Accessors
+   */
+  double nanoseconds() const {
+    return std::chrono::duration<double, std::nano>(elapsed_).count();
+  }
+  std::size_t allocs() const {
+    return allocs_;
+  }
+  //@}
+
+ private:
+  std::chrono::steady_clock::duration elapsed_;
+  std::size_t allocs_;
+  std::chrono::steady_clock::time_point start_time_;
+  std::size_t start_allocs_;
+};
+
+/// Quote a string for JSON, the benchmark names only need a few escapes.
+inline std::string json_quote(std::string const & s) {
+  std::string r("\"");
+  for (char c : s) {
+    if (c == '"' or c == '\\') {
+      r += '\\';
+    }
+    r += c;
+  }
+  r += '"';
+  return r;
+}
+
+/**
+ * Build the JSON object reporting a scenario.
+ *
+ * The common fields are always present, scenarios can add more with
+ * field().
+ */
+class result {
+ public:
+  result(char const * suite, std::string const & name,
+         std::size_t iterations, measurement const & m)
+      : os_() {
+    os_ << "{\"suite\":" << json_quote(suite)
+        << ",\"name\":" << json_quote(name)
+        << ",\"iterations\":" << iterations
+        << ",\"ns_per_call\":" << m.nanoseconds() / iterations
+        << ",\"allocs_per_call\":" << double(m.allocs()) / iterations;
+  }
+
+  template<typename T>
+  result & field(char const * name, T const & value) {
+    os_ << "," << json_quote(name) << ":" << value;
+    return *this;
+  }
+
+  /// Print the object as a single line.
+  void print(std::ostream & os = std::cout) {
+    os << os_.str() << "}" << std::endl;
+  }
+
+ private:
+  std::ostringstream os_;
+};
+
+/**
+ * Keep the optimizer from discarding a value.
+ */
+template<typename T>
+void do_not_optimize(T const & value) {
+  asm volatile("" : : "g"(&value) : "memory");
+}
+
+} // namespace bench
+
+#endif // bench_bench_support_hpp
@@ -0,0 +1,128 @@
+/**
+ * @file
+ *
+ * Count the copies, moves and memory allocations performed when a
+ * mock function captures its arguments.
+ *
+ * Large strings and vectors are passed to mocks by value, by const
+ * reference and as rvalues, and the number of allocations (and, for
+ * an instrumented type, the number of copies and moves) per call is
+ * reported.  The moves include the (amortized) moves made when the
+ * vector holding the captures grows.
+ *
+ * The output is one JSON object per line, see bench_support.hpp.
+ */
+#include "bench_support.hpp"
+
+#include <skye/mock_function.hpp>
+#include <skye/mock_template_function.hpp>
+
+#include <string>
+#include <vector>
+
+namespace {
+
+char const suite[] = "capture_copy_count";
+
+/// A type that counts how many times it is copied or moved.
+struct instrumented {
+  static std::size_t copies;
+  static std::size_t moves;
+
+  instrumented() {}
+  instrumented(instrumented const &) {
+    ++copies;
+  }
+  instrumented(instrumented &&) noexcept {
+    ++moves;
+  }
+  instrumented & operator=(instrumented const &) {
+    ++copies;
+    return *this;
+  }
+  instrumented & operator=(instrumented &&) noexcept {
+    ++moves;
+    return *this;
+  }
+  bool operator==(instrumented const &) const {
+    return true;
+  }
+};
+
+std::size_t instrumented::copies = 0;
+std::size_t instrumented::moves = 0;
+
+int const calls = 10000;
+std::size_t const large = 4096;
+
+/**
+ * Run a scenario, the argument is created outside the measured
+ * region.
+ */
+template<typename mock_type, typename make_arg, typename call>
+void run(char const * name, make_arg make, call c) {
+  mock_type mock;
+  bench::measurement m;
+  std::size_t copies = 0;
+  std::size_t moves = 0;
+  for (int i = 0; i != calls; ++i) {
+    auto arg = make();
+    instrumented::copies = 0;
+    instrumented::moves = 0;
+    m.start();
+    c(mock, arg);
+    m.stop();
+    copies += instrumented::copies;
+    moves += instrumented::moves;
+  }
+  bench::result(suite, name, calls, m)
+      .field("copies_per_call", double(copies) / calls)
+      .field("moves_per_call", double(moves) / calls)
+      .print();
+}
+
+} // anonymous namespace
+
+int main() {
+  auto make_string = []() { return std::string(large, 'x'); };
+  auto make_vector = []() { return std::vector<int>(large, 7); };
+  auto make_instrumented = []() { return instrumented(); };
+
+  typedef skye::mock_function<void(std::string)> by_value_string;
+  run<by_value_string>(
+      "mock_function<void(std::string)> rvalue", make_string,
+      [](by_value_string & m, std::string & a) { m(std::move(a)); });
+  run<by_value_string>(
+      "mock_function<void(std::string)> lvalue", make_string,
+      [](by_value_string & m, std::string & a) { m(a); });
+
+  typedef skye::mock_function<void(std::string const&)> by_ref_string;
+  run<by_ref_string>(
+      "mock_function<void(std::string const&)>", make_string,
+      [](by_ref_string & m, std::string & a) { m(a); });
+
+  typedef skye::mock_function<void(std::vector<int>)> by_value_vector;
+  run<by_value_vector>(
+      "mock_function<void(std::vector<int>)> rvalue", make_vector,
+      [](by_value_vector & m, std::vector<int> & a) { m(std::move(a)); });
+
+  typedef skye::mock_function<void(instrumented)> by_value_inst;
+  run<by_value_inst>(
+      "mock_function<void(instrumented)> rvalue", make_instrumented,
+      [](by_value_inst & m, instrumented & a) { m(std::move(a)); });
+
+  typedef skye::mock_function<void(instrumented const&)> by_ref_inst;
+  run<by_ref_inst>(
+      "mock_function<void(instrumented const&)>", make_instrumented,
+      [](by_ref_inst & m, instrumented & a) { m(a); });
+
+  typedef skye::mock_template_function<void> template_mock;
+  run<template_mock>(
+      "mock_template_function<void> string rvalue", make_string,
+      [](template_mock & m, std::string & a) { m(std::move(a)); });
+  run<template_mock>(
+      "mock_template_function<void> instrumented", make_instrumented,
+      [](template_mock & m, instrumented & a) { m(std::move(a)); });
+
+  return 0;
+}
@@ -0,0 +1,112 @@
+#!/bin/sh
+#
+# Measure the time to compile and link Skye unit tests.
+#
+# Usage: compile_time.sh [iterations] [mocks]
+#
+# The first scenarios build a typical unit test, with Boost.Test and
+# with the lightweight runner in skye/lightweight_test.hpp.  The last
+# one compiles a generated file with [mocks] distinct mock_function
+# signatures (100 by default), and also reports the object size, to
+# track the cost of each instantiation.
+#
+# The compiler and flags are taken from the CXX, CXXFLAGS, CPPFLAGS,
+# LDFLAGS, BOOST_TEST_LIBS and LIBS environment variables, the
+# `make compile-bench` target sets them from the configure results.
+# The results are printed as JSON lines, one per scenario, with the
+# same common fields as the other benchmarks.
+
+set -e
+
+srcdir=${srcdir:-$(dirname "$0")/..}
+iterations=${1:-5}
+mocks=${2:-100}
+CXX=${CXX:-g++}
+CXXFLAGS=${CXXFLAGS:--O2 -std=c++11}
+BOOST_TEST_LIBS=${BOOST_TEST_LIBS:--lboost_unit_test_framework}
+LIBS=${LIBS:--lpthread}
+
+tmpdir=$(mktemp -d)
+trap 'rm -fr "${tmpdir}"' EXIT
+
+now_ns() {
+  date +%s%N
+}
+
+# measure <name> <extra-fields> <command...>
+#   Run the command ${iterations} times and print the JSON result,
+#   <extra-fields> is appended to the object, it may be empty.
+measure() {
+  name=$1
+  extra=$2
+  shift 2
+  start=$(now_ns)
+  i=0
+  while [ ${i} -lt ${iterations} ]; do
+    "$@"
+    i=$((i + 1))
+  done
+  end=$(now_ns)
+  echo "{\"suite\":\"compile_time\",\"name\":\"${name}\"," \
+       "\"iterations\":${iterations}," \
+       "\"ns_per_call\":$(( (end - start) / iterations ))${extra}}" \
+      | tr -d ' '
+}
+
+# generate_mocks <count>
+#   Print a translation unit with <count> distinct mock signatures,
+#   each one is called and checked, like a typical test.
+generate_mocks() {
+  echo "#include <skye/mock_function.hpp>"
+  echo "#include <string>"
+  echo "namespace {"
+  echo "template<int N> struct arg { int value; };"
+  echo "template<int N>"
+  echo "bool operator==(arg<N> const & a, arg<N> const & b) {"
+  echo "  return a.value == b.value;"
+  echo "}"
+  echo "} // anonymous namespace"
+  i=0
+  while [ ${i} -lt $1 ]; do
+    echo "void mock_${i}() {"
+    echo "  skye::mock_function<int(arg<${i}> const &, std::string)> f;"
+    echo "  f.returns( ${i} );"
+    echo "  f(arg<${i}>{${i}}, \"a\");"
+    echo "  f.check_called().once()"
+    echo "      .with(arg<${i}>{${i}}, std::string(\"a\"));"
+    echo "}"
+    i=$((i + 1))
+  done
+}
+
+source=${srcdir}/bench/compile_time_tu.cpp
+includes="-I${srcdir}"
+boost_flags="-DBOOST_TEST_DYN_LINK -DSKYE_USE_BOOST_UNIT_TEST_FRAMEWORK"
+boost_flags="${boost_flags} -DSKYE_COMPILE_BENCH_BOOST"
+lightweight_flags="-DSKYE_USE_LIGHTWEIGHT_TEST_FRAMEWORK"
+
+measure boost_test_compile "" \
+  ${CXX} ${CPPFLAGS} ${includes} ${boost_flags} ${CXXFLAGS} \
+  -c "${source}" -o "${tmpdir}/boost.o"
+measure boost_test_link "" \
+  ${CXX} ${CXXFLAGS} ${LDFLAGS} "${tmpdir}/boost.o" -o "${tmpdir}/boost" \
+  ${BOOST_TEST_LIBS} ${LIBS}
+
+measure lightweight_compile "" \
+  ${CXX} ${CPPFLAGS} ${includes} ${lightweight_flags} ${CXXFLAGS} \
+  -c "${source}" -o "${tmpdir}/lightweight.o"
+measure lightweight_link "" \
+  ${CXX} ${CXXFLAGS} ${LDFLAGS} "${tmpdir}/lightweight.o" \
+  -o "${tmpdir}/lightweight" ${LIBS}
+
+# ... both variants must still pass ...
+"${tmpdir}/boost" >/dev/null 2>&1
+"${tmpdir}/lightweight" >/dev/null 2>&1
+
+generate_mocks ${mocks} >"${tmpdir}/mocks.cpp"
+${CXX} ${CPPFLAGS} ${includes} ${lightweight_flags} ${CXXFLAGS} \
+  -c "${tmpdir}/mocks.cpp" -o "${tmpdir}/mocks.o"
+measure generated_mocks_compile \
+  ",\"mocks\":${mocks},\"object_bytes\":$(wc -c <"${tmpdir}/mocks.o")" \
+  ${CXX} ${CPPFLAGS} ${includes} ${lightweight_flags} ${CXXFLAGS} \
+  -c "${tmpdir}/mocks.cpp" -o "${tmpdir}/mocks.o"
@@ -0,0 +1,106 @@
+/**
+ * @file
+ *
+ * A typical Skye unit test, used to measure the build time of a test
+ * translation unit.
+ *
+ * bench/compile_time.sh compiles and links this file twice, with
+ * SKYE_COMPILE_BENCH_BOOST defined the tests use Boost.Test, otherwise
+ * they use the lightweight runner in skye/lightweight_test.hpp.  The
+ * test cases are the same in both variants.
+ */
+#if defined(SKYE_COMPILE_BENCH_BOOST)
+#  define BOOST_TEST_MAIN
+#  define BOOST_TEST_MODULE bench_compile_time_tu
+#  include <boost/test/unit_test.hpp>
+#  define BENCH_TEST_CASE(name) BOOST_AUTO_TEST_CASE(name)
+#  define BENCH_CHECK(expr) BOOST_CHECK(expr)
+#  define BENCH_CHECK_EQUAL(lhs, rhs) BOOST_CHECK_EQUAL(lhs, rhs)
+#else
+#  include <skye/lightweight_test.hpp>
+#  define BENCH_TEST_CASE(name) SKYE_TEST_CASE(name)
+#  define BENCH_CHECK(expr) SKYE_CHECK(expr)
+#  define BENCH_CHECK_EQUAL(lhs, rhs) SKYE_CHECK_EQUAL(lhs, rhs)
+#endif // SKYE_COMPILE_BENCH_BOOST
+
+#include <skye/mock_function.hpp>
+#include <skye/mock_template_function.hpp>
+
+#include <string>
+
+BENCH_TEST_CASE( bench_void_function ) {
+  skye::mock_function<void()> f;
+  f();
+  f.check_called().once();
+}
+
+BENCH_TEST_CASE( bench_int_function ) {
+  skye::mock_function<int(int,int)> f;
+  f.returns( 42 );
+  BENCH_CHECK_EQUAL(f(1, 2), 42);
+  f.check_called().once().with(1, 2);
+}
+
+BENCH_TEST_CASE( bench_string_function ) {
+  skye::mock_function<std::string(std::string const &)> f;
+  f.returns( std::string("result") );
+  BENCH_CHECK_EQUAL(f("a"), "result");
+  f.check_called().once().with(std::string("a"));
+}
+
+BENCH_TEST_CASE( bench_never_called ) {
+  skye::mock_function<void(double)> f;
+  f.check_called().never();
+}
+
+BENCH_TEST_CASE( bench_at_least ) {
+  skye::mock_function<void(int)> f;
+  for (int i = 0; i != 10; ++i) {
+    f(i);
+  }
+  f.check_called().at_least(5);
+  f.check_called().at_most(10);
+}
+
+BENCH_TEST_CASE( bench_action ) {
+  int count = 0;
+  skye::mock_function<void(int)> f;
+  f.action( [&count]() { ++count; } );
+  f(1);
+  f(2);
+  BENCH_CHECK_EQUAL(count, 2);
+}
+
+BENCH_TEST_CASE( bench_template_function ) {
+  skye::mock_template_function<void> f;
+  f(1, std::string("a"));
+  f(2.0);
+  f.check_called().exactly(2);
+  f.check_called().once().with(2.0);
+}
+
+BENCH_TEST_CASE( bench_template_returns ) {
+  skye::mock_template_function<int> f;
+  f.returns( 7 );
+  BENCH_CHECK_EQUAL(f("x", 1), 7);
+  f.check_called().once().with("x", 1);
+}
+
+BENCH_TEST_CASE( bench_call_count ) {
+  skye::mock_function<void(long)> f;
+  f(1);
+  f(2);
+  BENCH_CHECK_EQUAL(f.call_count(), 2U);
+  BENCH_CHECK(f.at(1) == std::make_tuple(2L));
+}
+
+BENCH_TEST_CASE( bench_clear ) {
+  skye::mock_function<void(char)> f;
+  f('a');
+  f.clear();
+  f.check_called().never();
+}
+
+#if not defined(SKYE_COMPILE_BENCH_BOOST)
+SKYE_LIGHTWEIGHT_TEST_MAIN
+#endif // SKYE_COMPILE_BENCH_BOOST
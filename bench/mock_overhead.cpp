@@ -0,0 +1,229 @@
+/**
+ * @file
+ *
+ * Measure the overhead of calling mocks and checking assertions.
+ *
+ * Reports the time and allocations per call for:
+ * - mock_function with 0, 1 and 4 arguments,
+ * - mock_template_function,
+ * - the when() dispatch with a growing number of rules,
+ * - check_called().with().exactly() on logs of 1K, 100K and 10M calls,
+ * - the ASIO async_read_member_function mock.
+ *
+ * The output is one JSON object per line, see bench_support.hpp.
+ */
+#include "bench_support.hpp"
+
+#include <skye/asio/async_io_member_function.hpp>
+#include <skye/mock_function.hpp>
+#include <skye/mock_template_function.hpp>
+
+#include <boost/asio/buffer.hpp>
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+namespace {
+
+char const suite[] = "mock_overhead";
+
+/// Discard the assertion results, failures abort the benchmark.
+struct null_reporting {
+  static void checkpoint(skye::detail::location const &) {
+  }
+  static bool success_logging_enabled() {
+    return false;
+  }
+  static void report_success(
+      skye::detail::location const &, std::string const &) {
+  }
+  static void report_failure(
+      skye::detail::location const & where, std::string const & msg) {
+    std::cerr << "benchmark assertion failed " << where << ": "
+              << msg << std::endl;
+    std::abort();
+  }
+};
+
+/// The scale factor set on the command line, for quick runs.
+std::size_t scale = 1;
+
+std::size_t scaled(std::size_t n) {
+  return n / scale == 0 ? 1 : n / scale;
+}
+
+/// Measure @a iterations calls to @a call, and report them.
+template<typename functor>
+void run(std::string const & name, std::size_t iterations, functor call) {
+  bench::measurement m;
+  m.start();
+  for (std::size_t i = 0; i != iterations; ++i) {
+    call(i);
+  }
+  m.stop();
+  bench::result(suite, name, iterations, m).print();
+}
+
+void mock_function_calls() {
+  std::size_t const n = scaled(1000000);
+  {
+    skye::mock_function<void()> mock;
+    run("mock_function/0 args", n, [&mock](std::size_t) { mock(); });
+  }
+  {
+    skye::mock_function<void(int)> mock;
+    run("mock_function/1 arg", n,
+        [&mock](std::size_t i) { mock(int(i)); });
+  }
+  {
+    skye::mock_function<void(int,int,std::string const&,double)> mock;
+    std::string const s("a short string");
+    run("mock_function/4 args", n,
+        [&mock,&s](std::size_t i) { mock(int(i), 2, s, 3.0); });
+  }
+  {
+    skye::mock_function<int(int)> mock;
+    mock.returns( 42 );
+    run("mock_function/1 arg with returns()", n, [&mock](std::size_t i) {
+        bench::do_not_optimize(mock(int(i)));
+      });
+  }
+}
+
+void mock_template_function_calls() {
+  std::size_t const n = scaled(1000000);
+  {
+    skye::mock_template_function<void> mock;
+    run("mock_template_function/1 arg", n,
+        [&mock](std::size_t i) { mock(int(i)); });
+  }
+  {
+    skye::mock_template_function<void> mock;
+    std::string const s("a short string");
+    run("mock_template_function/4 args", n,
+        [&mock,&s](std::size_t i) { mock(int(i), 2, s, 3.0); });
+  }
+}
+
+void when_dispatch() {
+  std::size_t const n = scaled(1000000);
+  for (int rules : {1, 10, 100, 1000}) {
+    {
+      skye::mock_function<int(int)> mock;
+      // ... only measure the dispatch, not the growth of the log ...
+      mock.set_capture_capacity(1024);
+      mock.returns( 0 );
+      for (int r = 0; r != rules; ++r) {
+        mock.when( int(r) ).returns( r );
+      }
+      run("when/exact rules=" + std::to_string(rules), n,
+          [&mock,rules](std::size_t i) {
+            bench::do_not_optimize(mock(int(i % rules)));
+          });
+    }
+    {
+      skye::mock_function<int(int)> mock;
+      mock.set_capture_capacity(1024);
+      mock.returns( 0 );
+      for (int r = 0; r != rules; ++r) {
+        mock.whenp( [r](int && x) { return x == r; } ).returns( r );
+      }
+      // ... n is already scaled, the predicates are O(rules) ...
+      run("whenp/predicate rules=" + std::to_string(rules),
+          std::max<std::size_t>(1, n / rules),
+          [&mock,rules](std::size_t i) {
+            bench::do_not_optimize(mock(int(i % rules)));
+          });
+    }
+  }
+}
+
+void assertions() {
+  for (std::size_t log_size : {1000UL, 100000UL, 10000000UL}) {
+    std::size_t const size = scaled(log_size);
+    skye::mock_function<void(int)> mock;
+    for (std::size_t i = 0; i != size; ++i) {
+      mock(int(i % 100));
+    }
+    std::size_t const expected = (size / 100) + (size % 100 > 7 ? 1 : 0);
+    std::size_t const iterations = log_size >= 10000000UL ? 5 : 100;
+
+    bench::measurement m;
+    m.start();
+    for (std::size_t i = 0; i != iterations; ++i) {
+      mock.make_assertion<null_reporting>(SKYE_LOCATION)
+          .with( 7 ).exactly( expected );
+    }
+    m.stop();
+    bench::result(suite, "check_called().with().exactly()", iterations, m)
+        .field("log_size", size)
+        .field("ns_per_capture", m.nanoseconds() / iterations / size)
+        .print();
+
+    mock.watch( 7 );
+    bench::measurement w;
+    w.start();
+    for (std::size_t i = 0; i != iterations; ++i) {
+      mock.make_assertion<null_reporting>(SKYE_LOCATION)
+          .with( 7 ).exactly( expected );
+    }
+    w.stop();
+    bench::result(
+        suite, "check_called().with().exactly() watched", iterations, w)
+        .field("log_size", size)
+        .print();
+  }
+}
+
+void async_read() {
+  std::size_t const n = scaled(1000000);
+  char raw[1024];
+  std::size_t total = 0;
+  {
+    skye::asio::async_read_member_function mock;
+    run("async_read_member_function/call", n, [&](std::size_t) {
+        mock(boost::asio::buffer(raw),
+             [&total](boost::system::error_code const &, std::size_t n) {
+               total += n;
+             });
+      });
+  }
+  {
+    skye::asio::async_read_member_function mock;
+    run("async_read_member_function/call and complete", n,
+        [&](std::size_t i) {
+          mock(boost::asio::buffer(raw),
+               [&total](boost::system::error_code const &, std::size_t n) {
+                 total += n;
+               });
+          std::memset(raw, 'x', 64);
+          mock.at(i)->call_functor(boost::system::error_code(), 64);
+        });
+  }
+  bench::do_not_optimize(total);
+}
+
+} // anonymous namespace
+
+/**
+ * Run all the scenarios.
+ *
+ * The optional argument divides the number of iterations and the log
+ * sizes, for quick smoke tests.
+ */
+int main(int argc, char * argv[]) {
+  if (argc > 1) {
+    scale = std::strtoul(argv[1], nullptr, 10);
+    if (scale == 0) {
+      scale = 1;
+    }
+  }
+  mock_function_calls();
+  mock_template_function_calls();
+  when_dispatch();
+  assertions();
+  async_read();
+  return 0;
+}
@@ -1,8 +1,9 @@
 #ifndef skye_asio_async_accept_member_function_hpp
 #define skye_asio_async_accept_member_function_hpp
 
+#include <skye/asio/async_member_function.hpp>
 #include <skye/asio/detail/async_function_argument_capture.hpp>
-#include <skye/mock_template_function.hpp>
+#include <skye/asio/fwd.hpp>
 
 #include <boost/system/error_code.hpp>
 
@@ -11,10 +12,72 @@ namespace asio {
 
 typedef detail::async_function_argument_capture<
   void(boost::system::error_code const &)> async_accept_capture;
-typedef skye::mock_template_function<
-  void, async_accept_capture> async_accept_member_function;
+
+/**
+ * Mock the async_accept() member function of an acceptor.
+ *
+ * Sockets cannot be copied, so the capture does not retain the socket
+ * passed to async_accept().  Accepting mock sockets requires access to
+ * them, so this class exposes them through a hook, called with each
+ * mock socket and its capture.  See skye::asio::loopback.
+ */
+class async_accept_member_function
+    : public async_member_function<async_accept_capture> {
+ public:
+  typedef async_member_function<async_accept_capture> base;
+  typedef std::function<void(socket &, value_type const &)> accept_hook;
+
+  async_accept_member_function()
+      : base()
+      , accept_hook_()
+  {}
+
+  using base::operator();
+
+  /// Capture a call accepting into a mock socket.
+  template<typename handler_type>
+  void operator()(socket & peer, handler_type && handler) {
+    if (not accept_hook_) {
+      base::operator()(peer, std::forward<handler_type>(handler));
+      return;
+    }
+    // ... the hook owns the operation, it is not pending, but it is
+    // recorded (in order) before the hook runs ...
+    std::size_t const call = this->call_count();
+    base::base::operator()(peer, handler);
+    if (value_type const * stored = this->find_capture(call)) {
+      // ... the copy shares the handler with the stored capture ...
+      value_type op(*stored);
+      accept_hook_(peer, op);
+      return;
+    }
+    // ... a side effect cleared the captures ...
+    accept_hook_(peer, capture_strategy::capture(
+        peer, std::forward<handler_type>(handler)));
+  }
+
+  /**
+   * Call @a hook with each socket passed to async_accept().
+   *
+   * The call is recorded before the hook runs, and the hook receives
+   * a copy of the recorded capture, which shares the handler and the
+   * completion state with it.  The hook can complete the operation at
+   * any time, and the operation is not tracked as pending.  Pass a
+   * null hook to remove it.
+   */
+  void set_accept_hook(accept_hook hook) {
+    accept_hook_ = std::move(hook);
+  }
+
+ private:
+  accept_hook accept_hook_;
+};
 
 } // namespace asio
 } // namespace skye
 
+#if defined(SKYE_USE_COMPILED_LIBRARY)
+#  include <skye/asio/detail/extern_templates.hpp>
+#endif // SKYE_USE_COMPILED_LIBRARY
+
 #endif // skye_asio_async_accept_member_function_hpp
@@ -17,4 +17,8 @@ typedef skye::mock_template_function<
 } // namespace asio
 } // namespace skye
 
+#if defined(SKYE_USE_COMPILED_LIBRARY)
+#  include <skye/asio/detail/extern_templates.hpp>
+#endif // SKYE_USE_COMPILED_LIBRARY
+
 #endif // skye_asio_async_connect_member_function_hpp
@@ -1,8 +1,8 @@
 #ifndef skye_asio_async_io_member_function_hpp
 #define skye_asio_async_io_member_function_hpp
 
+#include <skye/asio/async_member_function.hpp>
 #include <skye/asio/detail/async_function_argument_capture.hpp>
-#include <skye/mock_template_function.hpp>
 
 #include <boost/system/error_code.hpp>
 
@@ -12,13 +12,15 @@ namespace asio {
 typedef detail::async_function_argument_capture<
   void(boost::system::error_code const &,std::size_t)> async_io_capture;
 
-typedef skye::mock_template_function<
-  void, async_io_capture> async_read_member_function;
+typedef async_member_function<async_io_capture> async_read_member_function;
 
-typedef skye::mock_template_function<
-  void, async_io_capture> async_write_member_function;
+typedef async_member_function<async_io_capture> async_write_member_function;
 
 } // namespace asio
 } // namespace skye
 
+#if defined(SKYE_USE_COMPILED_LIBRARY)
+#  include <skye/asio/detail/extern_templates.hpp>
+#endif // SKYE_USE_COMPILED_LIBRARY
+
 #endif // skye_asio_async_io_member_function_hpp
@@ -0,0 +1,365 @@
+#ifndef skye_asio_async_member_function_hpp
+#define skye_asio_async_member_function_hpp
+
+#include <skye/mock_template_function.hpp>
+
+#include <boost/asio/buffer.hpp>
+
+#include <deque>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace skye {
+namespace asio {
+namespace detail {
+
+//@{
+/**
+ * @name SFINAE protected functions to snapshot buffer contents.
+ *
+ * Append the contents of the first argument to an arena if it is a
+ * buffer sequence, or raise an exception otherwise.
+ */
+template<typename buffers, typename... rest>
+auto safeish_append_buffers(
+    std::string & arena, bool, buffers const & b, rest const &...)
+    -> decltype(boost::asio::const_buffer(*b.begin()), void()) {
+  std::size_t const offset = arena.size();
+  arena.resize(offset + boost::asio::buffer_size(b));
+  boost::asio::buffer_copy(
+      boost::asio::buffer(&arena[offset], arena.size() - offset), b);
+}
+
+template<typename... arg_types>
+void safeish_append_buffers(std::string &, arg_types const &...) {
+  throw std::runtime_error(
+      "Captured argument does not seem to be an ASIO buffer");
+}
+//@}
+
+} // namespace detail
+
+/**
+ * Mock an async_* member function, tracking the pending operations.
+ *
+ * Each call is captured as in any other mock_template_function, in
+ * addition the operation is pending until it is completed with one
+ * of the complete_*() member functions.  Each completion takes O(1)
+ * time, and no operation is completed twice by these functions:
+ *
+ * @code
+ * skye::asio::socket s;
+ * start_many_reads(s);
+ * s.async_read_some.complete_all(boost::system::error_code(), 0);
+ * @endcode
+ *
+ * The operations are completed synchronously, by calling their
+ * handlers directly, and only the operations pending when the
+ * complete_*() function is called are completed, new operations
+ * started by the handlers remain pending.
+ *
+ * Each pending operation is tracked through the completion state of
+ * its capture, which all the copies of the capture share, so
+ * completing any copy, for example with at(i)->call_functor(), also
+ * removes the operation from the pending operations, and no handler
+ * is called twice.  The complete_*() functions call the handlers in
+ * place, without copying the captures, the handlers may start new
+ * operations, which can move the captures around.  Operations whose
+ * capture was dropped (see set_capture_capacity()) remain pending,
+ * but are not passed to the complete_if() predicates.  Calls handled
+ * by a capture hook (for example, a skye::asio::stream_engine) are
+ * not tracked, the hook owns them.
+ *
+ * Optionally, the mock can also copy the contents of the buffers
+ * passed to each call, see set_snapshot_buffers().
+ *
+ * The pending operations and the snapshots are not thread-safe.
+ *
+ * @tparam capture_strategy_T how the arguments are captured, usually
+ *   a detail::async_function_argument_capture.
+ */
+template<typename capture_strategy_T>
+class async_member_function
+    : public skye::mock_template_function<void, capture_strategy_T> {
+ public:
+  typedef skye::mock_template_function<void, capture_strategy_T> base;
+  typedef typename base::capture_strategy capture_strategy;
+  typedef typename base::value_type value_type;
+
+  async_member_function()
+      : base()
+      , pending_()
+      , pending_count_(std::make_shared<std::size_t>(0))
+      , snapshot_(false)
+      , arena_()
+      , snapshot_offsets_()
+  {}
+
+  /// Capture the call and start tracking the operation.
+  template<typename... arg_types>
+  void operator()(arg_types&&... args) {
+    if (snapshot_) {
+      std::size_t const offset = arena_.size();
+      detail::safeish_append_buffers(arena_, true, args...);
+      // ... only record the snapshot once the append succeeded ...
+      snapshot_offsets_.push_back(offset);
+    }
+    if (this->has_capture_hook()) {
+      base::operator()(std::forward<arg_types>(args)...);
+      return;
+    }
+    std::size_t const call = this->call_count();
+    base::operator()(std::forward<arg_types>(args)...);
+    track(call);
+  }
+
+  /**
+   * Complete all the pending operations, in the order they were
+   * issued, using @a args as the handler arguments.
+   *
+   * @returns the number of operations completed.
+   */
+  template<typename... functor_args>
+  std::size_t complete_all(functor_args&&... args) {
+    std::deque<pending_operation> completing;
+    completing.swap(pending_);
+    std::size_t n = 0;
+    for (auto const & op : completing) {
+      if (complete(op, args...)) {
+        ++n;
+      }
+    }
+    return n;
+  }
+
+  /**
+   * Complete the pending operations matching @a pred, in the order
+   * they were issued.
+   *
+   * @param pred a functor called with each pending capture
+   *   (value_type const&), returns true to complete it.
+   * @returns the number of operations completed.
+   */
+  template<typename predicate, typename... functor_args>
+  std::size_t complete_if(predicate pred, functor_args&&... args) {
+    std::deque<pending_operation> completing;
+    std::deque<pending_operation> remaining;
+    for (auto const & op : pending_) {
+      if (op.completion->completed()) {
+        continue;
+      }
+      value_type const * capture = find_capture(op.call);
+      if (capture != nullptr and pred(*capture)) {
+        completing.push_back(op);
+      } else {
+        remaining.push_back(op);
+      }
+    }
+    pending_.swap(remaining);
+    std::size_t n = 0;
+    for (auto const & op : completing) {
+      if (complete(op, args...)) {
+        ++n;
+      }
+    }
+    return n;
+  }
+
+  /**
+   * Complete up to @a count of the oldest pending operations.
+   *
+   * @returns the number of operations completed.
+   */
+  template<typename... functor_args>
+  std::size_t complete_in_order_of_issue(
+      std::size_t count, functor_args&&... args) {
+    std::size_t n = 0;
+    while (n != count and not pending_.empty()) {
+      pending_operation const op = pending_.front();
+      pending_.pop_front();
+      if (complete(op, args...)) {
+        ++n;
+      }
+    }
+    return n;
+  }
+
+  /**
+   * Complete the oldest pending operation.
+   *
+   * @returns false if there are no pending operations.
+   */
+  template<typename... functor_args>
+  bool complete_next(functor_args&&... args) {
+    return complete_in_order_of_issue(
+        1, std::forward<functor_args>(args)...) == 1;
+  }
+
+  /// Forget the pending operations without completing them.
+  void clear_pending() {
+    pending_.clear();
+    // ... operations completed later must not change the new count ...
+    pending_count_ = std::make_shared<std::size_t>(0);
+  }
+
+  /**
+   * Copy (or stop copying) the buffer contents passed to each call.
+   *
+   * Captures only retain the buffer addresses, and the caller may
+   * reuse or release the buffers as soon as the operation completes,
+   * often before the test examines them.  In this mode each call
+   * copies its data, once, to the end of a single arena owned by the
+   * mock, which makes the transcript of all the writes available as
+   * a single contiguous buffer.  The mode is intended for writes, the
+   * contents of read buffers are captured before the read completes.
+   */
+  void set_snapshot_buffers(bool enable) {
+    snapshot_ = enable;
+  }
+
+  /// Discard the snapshots.
+  void clear_snapshots() {
+    arena_.clear();
+    snapshot_offsets_.clear();
+  }
+
+  /// Reset the mock, including the pending operations and snapshots.
+  void clear() {
+    base::clear();
+    clear_pending();
+    clear_snapshots();
+  }
+
+  /// Remove the captures, the pending operations and the snapshots.
+  void clear_captures() {
+    base::clear_captures();
+    clear_pending();
+    clear_snapshots();
+  }
+
+  //@{
+  /**
+   * @name Accessors
+   */
+  /// The number of operations not completed yet.
+  std::size_t pending() const {
+    return *pending_count_;
+  }
+  /**
+   * The oldest pending operation.
+   *
+   * Operations whose capture was dropped are skipped.
+   */
+  value_type const & next_pending() const {
+    // ... forget the operations completed since the last call, they
+    // are at the front in the common case ...
+    while (not pending_.empty() and pending_.front().completion->completed()) {
+      pending_.pop_front();
+    }
+    for (auto const & op : pending_) {
+      if (op.completion->completed()) {
+        continue;
+      }
+      if (value_type const * capture = find_capture(op.call)) {
+        return *capture;
+      }
+    }
+    throw std::out_of_range("async_member_function: no pending operations");
+  }
+  bool snapshot_buffers() const {
+    return snapshot_;
+  }
+  /// The number of calls with a snapshot.
+  std::size_t snapshot_count() const {
+    return snapshot_offsets_.size();
+  }
+  /// The contents of the buffers in the @a i-th call with a snapshot.
+  boost::asio::const_buffer snapshot(std::size_t i) const {
+    std::size_t const begin = snapshot_offsets_.at(i);
+    std::size_t const end = i + 1 == snapshot_offsets_.size()
+        ? arena_.size() : snapshot_offsets_[i + 1];
+    return boost::asio::const_buffer(arena_.data() + begin, end - begin);
+  }
+  /// The contents of all the snapshots, concatenated.
+  boost::asio::const_buffer transcript() const {
+    return boost::asio::const_buffer(arena_.data(), arena_.size());
+  }
+  //@}
+
+ protected:
+  /**
+   * Return the capture of the @a call-th call, or nullptr if it was
+   * dropped or cleared.
+   */
+  value_type const * find_capture(std::size_t call) const {
+    std::size_t const dropped = this->dropped_calls();
+    if (call < dropped or call >= this->call_count()) {
+      return nullptr;
+    }
+    return &this->at(call - dropped);
+  }
+
+ private:
+  typedef typename capture_strategy::completion_pointer completion_pointer;
+
+  /// A pending operation, and the call that started it.
+  struct pending_operation {
+    std::size_t call;
+    completion_pointer completion;
+  };
+
+  /// Start tracking the @a call-th call, unless it is already completed.
+  void track(std::size_t call) {
+    value_type const * capture = find_capture(call);
+    if (capture == nullptr) {
+      return;
+    }
+    completion_pointer completion = (*capture)->completion();
+    if (completion->completed()) {
+      return;
+    }
+    completion->track(pending_count_);
+    // ... the side effects of the call may have started (and tracked)
+    // new operations, keep the operations in the order of issue ...
+    auto i = pending_.end();
+    while (i != pending_.begin() and std::prev(i)->call > call) {
+      --i;
+    }
+    pending_.insert(i, pending_operation{call, std::move(completion)});
+  }
+
+  /// Complete the operation, return false if it is not pending.
+  template<typename... functor_args>
+  bool complete(pending_operation const & op, functor_args&... args) {
+    // ... the handler may clear the mock, hold on to the state ...
+    completion_pointer completion = op.completion;
+    if (completion->completed()) {
+      return false;
+    }
+    completion->call(args...);
+    return true;
+  }
+
+ private:
+  /// The operations not completed yet, in the order of issue.  The
+  /// operations completed through copies of their captures are
+  /// removed lazily.
+  mutable std::deque<pending_operation> pending_;
+  /// The number of operations not completed yet, shared with their
+  /// completion states.
+  std::shared_ptr<std::size_t> pending_count_;
+  bool snapshot_;
+  /// The snapshots are stored by offset, so they remain valid as the
+  /// arena grows.
+  std::string arena_;
+  std::vector<std::size_t> snapshot_offsets_;
+};
+
+} // namespace asio
+} // namespace skye
+
+#endif // skye_asio_async_member_function_hpp
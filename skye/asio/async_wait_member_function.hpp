@@ -0,0 +1,24 @@
+#ifndef skye_asio_async_wait_member_function_hpp
+#define skye_asio_async_wait_member_function_hpp
+
+#include <skye/asio/detail/async_function_argument_capture.hpp>
+#include <skye/mock_template_function.hpp>
+
+#include <boost/system/error_code.hpp>
+
+namespace skye {
+namespace asio {
+
+typedef detail::async_function_argument_capture<
+  void(boost::system::error_code const &)> async_wait_capture;
+typedef skye::mock_template_function<
+  void, async_wait_capture> async_wait_member_function;
+
+} // namespace asio
+} // namespace skye
+
+#if defined(SKYE_USE_COMPILED_LIBRARY)
+#  include <skye/asio/detail/extern_templates.hpp>
+#endif // SKYE_USE_COMPILED_LIBRARY
+
+#endif // skye_asio_async_wait_member_function_hpp
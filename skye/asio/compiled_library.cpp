@@ -0,0 +1,12 @@
+/**
+ * @file
+ *
+ * Define the explicit instantiations declared in
+ * skye/asio/detail/extern_templates.hpp.
+ */
+#define SKYE_COMPILING_ASIO_LIBRARY
+#if not defined(SKYE_USE_COMPILED_LIBRARY)
+#  define SKYE_USE_COMPILED_LIBRARY
+#endif // SKYE_USE_COMPILED_LIBRARY
+
+#include <skye/asio/detail/extern_templates.hpp>
@@ -0,0 +1,290 @@
+#ifndef skye_asio_connection_generator_hpp
+#define skye_asio_connection_generator_hpp
+
+#include <skye/asio/acceptor.hpp>
+#include <skye/asio/stream_engine.hpp>
+#include <skye/asio/virtual_clock.hpp>
+
+#include <boost/asio/steady_timer.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <vector>
+
+namespace skye {
+namespace asio {
+
+/**
+ * Configure the connections created by a connection_generator.
+ */
+struct connection_schedule {
+  connection_schedule()
+      : connections(1)
+      , rate(0.0)
+      , real_time(false)
+  {}
+
+  /// The total number of connections.
+  std::size_t connections;
+  /// The connections arriving per second, 0 means all at once.
+  double rate;
+  /// Use the real clock instead of the virtual_clock of the io_service.
+  bool real_time;
+};
+
+/**
+ * Generate incoming connections for a mock acceptor.
+ *
+ * The connections arrive at a fixed rate, and wait in a backlog until
+ * the code under test calls async_accept().  Each accepted socket is
+ * connected to a stream_engine owned by the generator, which a script
+ * prepares with the traffic for the connection:
+ *
+ * @code
+ * skye::asio::acceptor a(io);
+ * skye::asio::connection_schedule schedule;
+ * schedule.connections = 50000;
+ * schedule.rate = 10000;
+ * skye::asio::connection_generator generator(a, schedule);
+ * generator.set_script([](std::size_t, skye::asio::stream_engine & e) {
+ *     e.feed("GET / HTTP/1.0\r\n\r\n");
+ *     e.close_input();
+ *   });
+ * my_server server(a);
+ * server.start();
+ * generator.start();
+ * skye::asio::virtual_clock::get(io).run();
+ * std::cout << generator.accept_rate() << "\n";
+ * @endcode
+ *
+ * By default the arrivals follow the virtual_clock of the io_service,
+ * so an accept storm runs as fast as the server can accept, and the
+ * rates are reported in virtual time.  With real_time the arrivals
+ * follow the steady clock, and io_service::run() drives them.  In
+ * both cases the setup cost, the time spent by the generator to
+ * create each connection (including the script), is measured with
+ * the steady clock.
+ *
+ * The generator replaces any accept hook in the acceptor, so it
+ * cannot be combined with a skye::asio::loopback.  It owns the
+ * engines for all the connections, the sockets must outlive it.
+ */
+class connection_generator : private detail::virtual_timer {
+ public:
+  typedef async_accept_member_function::value_type operation;
+  typedef std::chrono::steady_clock::duration duration;
+  typedef std::chrono::steady_clock::time_point time_point;
+  typedef std::function<void(std::size_t, stream_engine &)> script;
+
+  connection_generator(acceptor & a, connection_schedule const & schedule)
+      : acceptor_(a)
+      , io_(a.get_io_service())
+      , schedule_(schedule)
+      , clock_(virtual_clock::get(io_))
+      , timer_(io_)
+      , scheduled_(false)
+      , handle_()
+      , script_()
+      , start_()
+      , last_accept_()
+      , arrived_(0)
+      , backlog_(0)
+      , max_backlog_(0)
+      , pending_accepts_()
+      , engines_()
+      , setup_cost_(0)
+      , max_setup_cost_(0) {
+    acceptor_.async_accept.set_accept_hook(
+        [this](socket & peer, operation const & op) {
+          on_accept(peer, op);
+        });
+  }
+
+  ~connection_generator() {
+    acceptor_.async_accept.set_accept_hook(nullptr);
+    if (scheduled_) {
+      clock_.unschedule(handle_);
+    }
+    timer_.cancel();
+  }
+
+  connection_generator(connection_generator const &) = delete;
+  connection_generator & operator=(
+      connection_generator const &) = delete;
+
+  /// Call @a s to prepare the engine of each accepted connection.
+  void set_script(script s) {
+    script_ = std::move(s);
+  }
+
+  /// Start generating connections, the first one arrives immediately.
+  void start() {
+    start_ = now();
+    last_accept_ = start_;
+    arrive_due();
+  }
+
+  //@{
+  /**
+   * @name Accessors
+   */
+  /// The number of connections that arrived so far.
+  std::size_t arrived() const {
+    return arrived_;
+  }
+  /// The number of connections accepted so far.
+  std::size_t accepted() const {
+    return engines_.size();
+  }
+  /// True once all the connections were accepted.
+  bool finished() const {
+    return accepted() == schedule_.connections;
+  }
+  /// The number of connections waiting for async_accept().
+  std::size_t backlog() const {
+    return backlog_;
+  }
+  std::size_t max_backlog() const {
+    return max_backlog_;
+  }
+  /// The number of async_accept() calls waiting for a connection.
+  std::size_t pending_accepts() const {
+    return pending_accepts_.size();
+  }
+  /// The engine for the @a i-th accepted connection.
+  stream_engine & engine(std::size_t i) {
+    return *engines_.at(i);
+  }
+  /// The time from start() to the last accepted connection.
+  duration elapsed() const {
+    return last_accept_ - start_;
+  }
+  /**
+   * The accepted connections per second, from start() to the last
+   * accepted connection.
+   *
+   * Infinite if all the connections were accepted at once.
+   */
+  double accept_rate() const {
+    double const seconds =
+        std::chrono::duration_cast<std::chrono::duration<double>>(
+            elapsed()).count();
+    if (seconds == 0) {
+      return accepted() == 0
+          ? 0.0 : std::numeric_limits<double>::infinity();
+    }
+    return accepted() / seconds;
+  }
+  /// The average time to set up each connection, in the real clock.
+  duration mean_setup_cost() const {
+    return engines_.empty()
+        ? duration(0)
+        : setup_cost_ / static_cast<duration::rep>(engines_.size());
+  }
+  duration max_setup_cost() const {
+    return max_setup_cost_;
+  }
+  //@}
+
+ private:
+  time_point now() const {
+    return schedule_.real_time
+        ? std::chrono::steady_clock::now() : clock_.now();
+  }
+
+  /// The arrival time of the @a i-th connection.
+  time_point due(std::size_t i) const {
+    if (schedule_.rate <= 0) {
+      return start_;
+    }
+    return start_ + std::chrono::duration_cast<duration>(
+        std::chrono::duration<double>(i / schedule_.rate));
+  }
+
+  /// Accept all the connections due, and wait for the next one.
+  void arrive_due() {
+    time_point const t = now();
+    while (arrived_ != schedule_.connections and due(arrived_) <= t) {
+      ++arrived_;
+      if (pending_accepts_.empty()) {
+        max_backlog_ = std::max(max_backlog_, ++backlog_);
+        continue;
+      }
+      auto & accept = pending_accepts_.front();
+      establish(*accept.first, std::move(accept.second));
+      pending_accepts_.pop_front();
+    }
+    if (arrived_ == schedule_.connections) {
+      return;
+    }
+    if (not schedule_.real_time) {
+      handle_ = clock_.schedule(due(arrived_), this);
+      scheduled_ = true;
+      return;
+    }
+    timer_.expires_at(due(arrived_));
+    timer_.async_wait([this](boost::system::error_code const & ec) {
+        if (ec == boost::asio::error::operation_aborted) {
+          return;
+        }
+        arrive_due();
+      });
+  }
+
+  virtual void expire() override {
+    scheduled_ = false;
+    arrive_due();
+  }
+
+  void on_accept(socket & peer, operation const & op) {
+    if (backlog_ == 0) {
+      pending_accepts_.emplace_back(&peer, op);
+      return;
+    }
+    --backlog_;
+    establish(peer, op);
+  }
+
+  void establish(socket & peer, operation op) {
+    auto const setup_start = std::chrono::steady_clock::now();
+    engines_.emplace_back(new stream_engine(peer));
+    if (script_) {
+      script_(engines_.size() - 1, *engines_.back());
+    }
+    io_.post([op]() mutable {
+        op->call_functor(boost::system::error_code());
+      });
+    duration const cost = std::chrono::steady_clock::now() - setup_start;
+    setup_cost_ += cost;
+    max_setup_cost_ = std::max(max_setup_cost_, cost);
+    last_accept_ = now();
+  }
+
+ private:
+  acceptor & acceptor_;
+  boost::asio::io_service & io_;
+  connection_schedule schedule_;
+  virtual_clock & clock_;
+  boost::asio::steady_timer timer_;
+  bool scheduled_;
+  virtual_clock::handle handle_;
+  script script_;
+  time_point start_;
+  time_point last_accept_;
+  std::size_t arrived_;
+  std::size_t backlog_;
+  std::size_t max_backlog_;
+  std::deque<std::pair<socket*, operation>> pending_accepts_;
+  std::vector<std::unique_ptr<stream_engine>> engines_;
+  duration setup_cost_;
+  duration max_setup_cost_;
+};
+
+} // namespace asio
+} // namespace skye
+
+#endif // skye_asio_connection_generator_hpp
@@ -2,16 +2,166 @@
 #define skye_asio_detail_async_function_argument_capture_hpp
 
 #include <skye/detail/argument_wrapper.hpp>
+#include <skye/detail/index_list.hpp>
+#include <skye/detail/small_holder.hpp>
 
 #include <boost/asio/buffer.hpp>
 
+#include <iterator>
 #include <memory>
 #include <stdexcept>
+#include <type_traits>
+#include <utility>
 
 namespace skye {
 namespace asio {
 namespace detail {
 
+/**
+ * Unimplemented general version.
+ *
+ * Only the partial specialization for function types is expected to
+ * be used.
+ */
+template<typename signature>
+class async_completion;
+
+/**
+ * The completion state of an asynchronous operation.
+ *
+ * All the copies of a capture share this object, which holds the
+ * handler and records if the operation was completed, no matter
+ * which copy completed it.
+ */
+template<typename return_type, typename... functor_args>
+class async_completion<return_type(functor_args...)> {
+ public:
+  virtual ~async_completion() {}
+
+  /// Mark the operation as completed and call the handler.
+  return_type call(functor_args... args) {
+    set_completed();
+    return invoke(args...);
+  }
+
+  /// Return true if the operation was completed.
+  bool completed() const {
+    return completed_;
+  }
+
+  /// Mark the operation as completed, without calling the handler.
+  void set_completed() {
+    if (completed_) {
+      return;
+    }
+    completed_ = true;
+    if (pending_count_) {
+      --*pending_count_;
+    }
+  }
+
+  /// Count the operation in @a counter until it is completed.
+  void track(std::shared_ptr<std::size_t> counter) {
+    if (completed_) {
+      return;
+    }
+    ++*counter;
+    pending_count_ = std::move(counter);
+  }
+
+ protected:
+  async_completion()
+      : completed_(false)
+      , pending_count_()
+  {}
+
+ private:
+  virtual return_type invoke(functor_args... args) = 0;
+
+ private:
+  bool completed_;
+  std::shared_ptr<std::size_t> pending_count_;
+};
+
+/**
+ * Unimplemented general version.
+ *
+ * Only the partial specialization for function types is expected to
+ * be used.
+ */
+template<typename handler_type, typename signature>
+class async_completion_handler;
+
+/**
+ * Implement async_completion for a specific handler type.
+ */
+template<typename handler_type, typename return_type, typename... functor_args>
+class async_completion_handler<handler_type, return_type(functor_args...)>
+    : public async_completion<return_type(functor_args...)> {
+ public:
+  template<typename handler_arg>
+  explicit async_completion_handler(handler_arg && handler)
+      : handler_(std::forward<handler_arg>(handler))
+  {}
+
+ private:
+  virtual return_type invoke(functor_args... args) override {
+    return handler_(args...);
+  }
+
+ private:
+  handler_type handler_;
+};
+
+/**
+ * Unimplemented general version.
+ *
+ * Only the partial specialization for function types is expected to
+ * be used.
+ */
+template<typename signature>
+class shared_completion;
+
+/**
+ * Hold the handler of a captured call.
+ *
+ * The captures hold the other arguments by value, and the handler
+ * through this object, so all the copies of a capture call the same
+ * handler and share its completion state.
+ */
+template<typename return_type, typename... functor_args>
+class shared_completion<return_type(functor_args...)> {
+ public:
+  typedef async_completion<return_type(functor_args...)> state_type;
+
+  /// Create a new completion state holding a copy of @a handler.
+  template<typename handler_type>
+  static shared_completion create(handler_type && handler) {
+    typedef async_completion_handler<
+      typename std::decay<handler_type>::type,
+      return_type(functor_args...)> completion_type;
+    return shared_completion(std::make_shared<completion_type>(
+        std::forward<handler_type>(handler)));
+  }
+
+  /// Call the handler, and mark the operation as completed.
+  return_type operator()(functor_args... args) const {
+    return state_->call(args...);
+  }
+
+  std::shared_ptr<state_type> const & state() const {
+    return state_;
+  }
+
+ private:
+  explicit shared_completion(std::shared_ptr<state_type> state)
+      : state_(std::move(state))
+  {}
+
+ private:
+  std::shared_ptr<state_type> state_;
+};
+
 /**
  * Unimplemented general version.
  *
@@ -43,15 +193,26 @@ template<typename return_type, typename... functor_args>
 class async_function_argument_capture_holder<return_type(functor_args...)>
 {
  public:
-  /// These objects are held through a shared_ptr<> often, so define
-  /// an typedef for it.
-  typedef std::shared_ptr<async_function_argument_capture_holder> pointer;
+  /// These objects are held by value, small ones without allocating
+  /// any memory, so define a typedef for the holder.
+  typedef skye::detail::small_holder<
+    async_function_argument_capture_holder> value;
 
   /// Destructor.
   virtual ~async_function_argument_capture_holder() {}
 
   /// Compare two holders for equality.
-  virtual bool equals(pointer const & other) const = 0;
+  virtual bool equals(
+      async_function_argument_capture_holder const & other) const = 0;
+
+  /// Return a tag unique to the concrete type of the holder.
+  virtual void const * type() const = 0;
+
+  /// Return true if the argument values can be hashed.
+  virtual bool hashable() const = 0;
+
+  /// Hash the argument values, only meaningful if hashable() is true.
+  virtual std::size_t hash() const = 0;
 
   /// Print the argument values using iostreams.
   virtual void stream(std::ostream & os) const = 0;
@@ -59,6 +220,23 @@ class async_function_argument_capture_holder<return_type(functor_args...)>
   /// Call (invoke) the captured functor using the argument provided.
   virtual return_type call_functor(functor_args... args) = 0;
 
+  /// The completion state, shared by all the copies of the capture.
+  typedef std::shared_ptr<async_completion<return_type(functor_args...)>>
+      completion_pointer;
+
+  /// Return the completion state of the operation.
+  virtual completion_pointer completion() const = 0;
+
+  /**
+   * Return true if the operation was completed.
+   *
+   * call_functor() completes the operation, through this capture or
+   * any copy of it.
+   */
+  bool completed() const {
+    return completion()->completed();
+  }
+
   /// Return the number of arguments in the call.
   virtual std::size_t argument_count() const = 0;
 
@@ -78,6 +256,24 @@ class async_function_argument_capture_holder<return_type(functor_args...)>
   virtual void const * get_buffer_data() const = 0;
   virtual void set_buffer_data(void const * data, std::size_t size) = 0;
   //@}
+
+  //@{
+  /**
+   * Buffer sequence operations.
+   *
+   * Scatter/gather operations receive a sequence of buffers, such as
+   * a std::vector<boost::asio::const_buffer>.  get_buffer_size() and
+   * set_buffer_data() operate on the whole sequence, while
+   * get_buffer_data() only returns the address of the first buffer.
+   * These functions give access to each buffer in the sequence.
+   */
+  /// The number of buffers in the sequence.
+  virtual std::size_t get_buffer_count() const = 0;
+  /// The @a i-th buffer in the sequence.
+  virtual boost::asio::const_buffer get_buffer(std::size_t i) const = 0;
+  /// Copy (gather) up to @a size bytes of the sequence into @a data.
+  virtual std::size_t copy_buffer_data(void * data, std::size_t size) const = 0;
+  //@}
 };
 
 //@{
@@ -103,13 +299,16 @@ std::size_t safeish_get_buffer_size(arg_types...) {
       "Captured argument does not seem to be an ASIO buffer");
 }
 
-/// Get the buffer size.
+/// Get the address of the first buffer.
 template<typename wrapper>
 auto safeish_get_buffer_data(wrapper const & w, bool)
-    -> decltype(
-        boost::asio::const_buffer(*w.value.begin()),
-        boost::asio::buffer_cast<void const*>(w.value)) {
-  return boost::asio::buffer_cast<void const*>(w.value);
+    -> decltype(boost::asio::const_buffer(*w.value.begin()),
+                static_cast<void const*>(nullptr)) {
+  if (w.value.begin() == w.value.end()) {
+    return nullptr;
+  }
+  return boost::asio::buffer_cast<void const*>(
+      boost::asio::const_buffer(*w.value.begin()));
 }
 
 /// Fallback case for get_buffer_size()
@@ -132,6 +331,55 @@ void safeish_set_buffer_data(arg_types...) {
   throw std::runtime_error(
       "Captured argument does not seem to be an ASIO buffer");
 }
+
+/// Get the number of buffers in the sequence.
+template<typename wrapper>
+auto safeish_get_buffer_count(wrapper const & w, bool)
+    -> decltype(boost::asio::const_buffer(*w.value.begin()), std::size_t()) {
+  return std::distance(w.value.begin(), w.value.end());
+}
+
+/// Fallback case for get_buffer_count()
+template<typename... arg_types>
+std::size_t safeish_get_buffer_count(arg_types...) {
+  throw std::runtime_error(
+      "Captured argument does not seem to be an ASIO buffer");
+}
+
+/// Get one of the buffers in the sequence.
+template<typename wrapper>
+auto safeish_get_buffer(wrapper const & w, std::size_t i, bool)
+    -> decltype(boost::asio::const_buffer(*w.value.begin())) {
+  auto b = w.value.begin();
+  for (; b != w.value.end() and i != 0; ++b, --i) {
+  }
+  if (b == w.value.end()) {
+    throw std::out_of_range("Buffer index out of range");
+  }
+  return boost::asio::const_buffer(*b);
+}
+
+/// Fallback case for get_buffer()
+template<typename... arg_types>
+boost::asio::const_buffer safeish_get_buffer(arg_types...) {
+  throw std::runtime_error(
+      "Captured argument does not seem to be an ASIO buffer");
+}
+
+/// Gather the contents of the buffer sequence.
+template<typename wrapper>
+auto safeish_copy_buffer_data(
+    wrapper const & w, void * data, std::size_t size, bool)
+    -> decltype(boost::asio::const_buffer(*w.value.begin()), std::size_t()) {
+  return boost::asio::buffer_copy(boost::asio::buffer(data, size), w.value);
+}
+
+/// Fallback case for copy_buffer_data()
+template<typename... arg_types>
+std::size_t safeish_copy_buffer_data(arg_types...) {
+  throw std::runtime_error(
+      "Captured argument does not seem to be an ASIO buffer");
+}
 //@}
 
 /**
@@ -150,25 +398,44 @@ class async_function_argument_capture_tuple<
  public:
   typedef async_function_argument_capture_holder<
     return_type(functor_args...)> base;
-  typedef typename base::pointer pointer;
+  typedef typename base::value value;
 
   async_function_argument_capture_tuple() = default;
   async_function_argument_capture_tuple(
       async_function_argument_capture_tuple const &) = default;
+  async_function_argument_capture_tuple(
+      async_function_argument_capture_tuple &&) = default;
+
+  /// Constructor.
+  explicit async_function_argument_capture_tuple(tuple_type && tuple)
+      : tuple_(std::move(tuple))
+  {}
 
   /// Create a new object given a tuple rvalue reference.
-  static pointer create(tuple_type && t) {
-    return pointer(new async_function_argument_capture_tuple(
-        std::forward<tuple_type>(t)));
+  static value create(tuple_type && t) {
+    return value::template create<async_function_argument_capture_tuple>(
+        std::move(t));
   }
 
-  virtual bool equals(pointer const & other) const override {
-    auto rhs = dynamic_cast<
-      async_function_argument_capture_tuple const*>(other.get());
-    if (rhs == nullptr) {
+  virtual bool equals(base const & other) const override {
+    if (other.type() != type()) {
       return false;
     }
-    return tuple_ == rhs->tuple_;
+    auto const & rhs =
+        static_cast<async_function_argument_capture_tuple const &>(other);
+    return tuple_ == rhs.tuple_;
+  }
+
+  virtual void const * type() const override {
+    return &skye::detail::type_tag<async_function_argument_capture_tuple>::id;
+  }
+
+  virtual bool hashable() const override {
+    return skye::detail::wrapped_tuple_hash<tuple_type>::hashable;
+  }
+
+  virtual std::size_t hash() const override {
+    return skye::detail::wrapped_tuple_hash<tuple_type>::hash(tuple_);
   }
 
   virtual void stream(std::ostream & os) const override {
@@ -180,6 +447,11 @@ class async_function_argument_capture_tuple<
     return std::get<N-1>(tuple_).value(args...);
   }
 
+  virtual typename base::completion_pointer completion() const override {
+    std::size_t const N = std::tuple_size<tuple_type>::value;
+    return std::get<N-1>(tuple_).value.state();
+  }
+
   virtual std::size_t argument_count() const override {
     return std::tuple_size<tuple_type>::value;
   }
@@ -195,16 +467,41 @@ class async_function_argument_capture_tuple<
     return safeish_set_buffer_data(
         std::get<0>(tuple_), boost::asio::buffer(data, size));
   }
+  virtual std::size_t get_buffer_count() const override {
+    return safeish_get_buffer_count(std::get<0>(tuple_), true);
+  }
+  virtual boost::asio::const_buffer get_buffer(std::size_t i) const override {
+    return safeish_get_buffer(std::get<0>(tuple_), i, true);
+  }
+  virtual std::size_t copy_buffer_data(
+      void * data, std::size_t size) const override {
+    return safeish_copy_buffer_data(std::get<0>(tuple_), data, size, true);
+  }
 
  private:
-  /// Constructor.
-  async_function_argument_capture_tuple(tuple_type && tuple)
-      : tuple_(tuple)
-  {}
+  tuple_type tuple_;
+};
 
+/**
+ * Select how each argument of an async_* call is captured.
+ *
+ * The last argument is the handler, it is held by a
+ * shared_completion, the other arguments are captured as usual.
+ */
+template<bool is_handler, typename signature, typename T>
+struct async_argument_slot {
+  typedef T type;
+  static T && convert(T && x) {
+    return std::forward<T>(x);
+  }
+};
 
- private:
-  tuple_type tuple_;
+template<typename signature, typename T>
+struct async_argument_slot<true, signature, T> {
+  typedef shared_completion<signature> type;
+  static type convert(T && handler) {
+    return type::create(std::forward<T>(handler));
+  }
 };
 
 /**
@@ -228,7 +525,12 @@ class async_function_argument_capture<return_type(arg_types...)>
  public:
   /// A single argument capture.
   typedef typename async_function_argument_capture_holder<
-    return_type(arg_types...)>::pointer value_type;
+    return_type(arg_types...)>::value value_type;
+
+  /// The completion state of a captured call, see
+  /// async_function_argument_capture_holder::completion().
+  typedef typename async_function_argument_capture_holder<
+    return_type(arg_types...)>::completion_pointer completion_pointer;
 
   /// The type representing a sequence of argument captures.
   typedef std::vector<value_type> capture_sequence;
@@ -236,22 +538,54 @@ class async_function_argument_capture<return_type(arg_types...)>
   /// Capture a set of arguments.
   template<typename... call_types>
   static value_type capture(call_types&&... args) {
-    auto t = skye::detail::wrap_args_as_tuple(args...);
-    return async_function_argument_capture_tuple<
-      decltype(t),return_type(arg_types...)>::create(std::move(t));
+    return capture_indexed(
+        typename skye::detail::make_index_list<
+          sizeof...(call_types)>::type(),
+        std::forward<call_types>(args)...);
   }
 
-  static bool equals(value_type lhs, value_type rhs) {
-    return lhs->equals(rhs);
+  /// Capture a set of arguments directly into a capture_buffer.
+  template<typename buffer_type, typename... call_types>
+  static value_type & capture_into(
+      buffer_type & buffer, call_types&&... args) {
+    return buffer.push_back(capture(std::forward<call_types>(args)...));
   }
 
-  static void stream(std::ostream & os, value_type x) {
+  static bool equals(value_type const & lhs, value_type const & rhs) {
+    return lhs->equals(*rhs);
+  }
+
+  static bool hashable(value_type const & x) {
+    return x->hashable();
+  }
+
+  static std::size_t hash(value_type const & x) {
+    return x->hash();
+  }
+
+  static void stream(std::ostream & os, value_type const & x) {
     x->stream(os);
   }
 
-  static return_type call_functor(value_type value, arg_types... args) {
+  static return_type call_functor(value_type & value, arg_types... args) {
     return value->call_functor(args...);
   }
+
+ private:
+  template<std::size_t... I, typename... call_types>
+  static value_type capture_indexed(
+      skye::detail::index_list<I...>, call_types&&... args) {
+    typedef typename skye::detail::wrapped_tuple<
+      typename async_argument_slot<
+        I + 1 == sizeof...(call_types), return_type(arg_types...),
+        call_types>::type...>::type tuple_type;
+    return async_function_argument_capture_tuple<
+      tuple_type,return_type(arg_types...)>::create(
+          tuple_type(async_argument_slot<
+                     I + 1 == sizeof...(call_types), return_type(arg_types...),
+                     call_types>::convert(
+                         std::forward<call_types>(args))...));
+  }
 };
 
 } // namespace detail
@@ -0,0 +1,59 @@
+#ifndef skye_asio_detail_extern_templates_hpp
+#define skye_asio_detail_extern_templates_hpp
+
+/**
+ * @file
+ *
+ * Explicit instantiations for the Boost.ASIO mocks.
+ *
+ * The mock sockets, acceptors and timers use a handful of template
+ * instantiations, this file declares them as extern templates when
+ * SKYE_USE_COMPILED_LIBRARY is defined, and
+ * skye/asio/compiled_library.cpp defines them in skye/asio/lib_skye.a.
+ * That file defines SKYE_COMPILING_ASIO_LIBRARY, the instantiations
+ * in skye/lib_skye.a remain extern templates.
+ *
+ * @see skye/detail/extern_templates.hpp for the details.
+ */
+
+#if defined(SKYE_COMPILING_ASIO_LIBRARY)
+#  define SKYE_ASIO_EXTERN_TEMPLATE template
+#else
+#  define SKYE_ASIO_EXTERN_TEMPLATE extern template
+#endif // SKYE_COMPILING_ASIO_LIBRARY
+
+#include <skye/detail/extern_templates.hpp>
+#include <skye/asio/async_accept_member_function.hpp>
+#include <skye/asio/async_connect_member_function.hpp>
+#include <skye/asio/async_io_member_function.hpp>
+#include <skye/asio/async_wait_member_function.hpp>
+#include <skye/asio/virtual_clock.hpp>
+
+namespace skye {
+
+// ... async_connect_member_function and async_wait_member_function
+// are the same type ...
+SKYE_ASIO_EXTERN_TEMPLATE class mock_template_function<
+  void, asio::async_accept_capture>;
+SKYE_ASIO_EXTERN_TEMPLATE class mock_template_function<
+  void, asio::async_io_capture>;
+
+namespace detail {
+
+SKYE_EXTERN_TEMPLATE_CAPTURE(
+    SKYE_ASIO_EXTERN_TEMPLATE, asio::async_accept_capture);
+SKYE_EXTERN_TEMPLATE_CAPTURE(
+    SKYE_ASIO_EXTERN_TEMPLATE, asio::async_io_capture);
+
+} // namespace detail
+
+namespace asio {
+
+SKYE_ASIO_EXTERN_TEMPLATE class async_member_function<async_accept_capture>;
+SKYE_ASIO_EXTERN_TEMPLATE class async_member_function<async_io_capture>;
+SKYE_ASIO_EXTERN_TEMPLATE class basic_virtual_clock<true>;
+
+} // namespace asio
+} // namespace skye
+
+#endif // skye_asio_detail_extern_templates_hpp
@@ -0,0 +1,125 @@
+#ifndef skye_asio_detail_io_service_pool_hpp
+#define skye_asio_detail_io_service_pool_hpp
+
+#include <skye/asio/virtual_clock.hpp>
+
+#include <boost/asio/io_service.hpp>
+
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace skye {
+namespace asio {
+namespace detail {
+
+/**
+ * A process-wide pool of io_service objects, shared by all threads.
+ *
+ * Only io_service objects drained of all their work are recycled,
+ * whether they ran or not, see release().
+ */
+class io_service_pool {
+ public:
+  /// The maximum number of idle io_service objects kept by the pool.
+  static std::size_t const max_size = 64;
+
+  /// Return an idle io_service, or a new one if there are none.
+  static std::unique_ptr<boost::asio::io_service> acquire() {
+    {
+      std::lock_guard<std::mutex> lock(mu());
+      auto & idle = idle_services();
+      if (not idle.empty()) {
+        std::unique_ptr<boost::asio::io_service> io(std::move(idle.back()));
+        idle.pop_back();
+        return io;
+      }
+    }
+    return std::unique_ptr<boost::asio::io_service>(
+        new boost::asio::io_service);
+  }
+
+  /// The maximum number of calls to poll() to drain an io_service.
+  static int const max_drain_rounds = 4;
+
+  /**
+   * Return @a io to the pool.
+   *
+   * The io_service may still have handlers queued, for example, if
+   * the test never called run(), or if stop() was called explicitly.
+   * Those must not run in an unrelated test, so release() runs them
+   * first, with poll().  The io_service is recycled only if that
+   * leaves it out of work, otherwise, for example if it has pending
+   * operations, it is destroyed along with its handlers.  The Skye
+   * services in a recycled io_service are reset to their initial
+   * state, for example, the virtual_clock starts again at
+   * time_point().
+   */
+  static void release(std::unique_ptr<boost::asio::io_service> io) {
+    if (not io or not drain(*io) or not reset_services(*io)) {
+      return;
+    }
+    io->reset();
+    std::lock_guard<std::mutex> lock(mu());
+    auto & idle = idle_services();
+    if (idle.size() < max_size) {
+      idle.push_back(std::move(io));
+    }
+  }
+
+  /// The number of idle io_service objects in the pool.
+  static std::size_t available() {
+    std::lock_guard<std::mutex> lock(mu());
+    return idle_services().size();
+  }
+
+ private:
+  /// Run the handlers queued in @a io, return true if it ran out of work.
+  static bool drain(boost::asio::io_service & io) {
+    for (int i = 0; i != max_drain_rounds; ++i) {
+      io.reset();
+      if (io.poll() == 0) {
+        // ... poll() stops the io_service only if it has no work left ...
+        return io.stopped();
+      }
+    }
+    return false;
+  }
+
+  /**
+   * Reset the Skye services registered in @a io.
+   *
+   * @returns false if a service is still in use, and the io_service
+   *   cannot be recycled.
+   */
+  static bool reset_services(boost::asio::io_service & io) {
+    if (not boost::asio::has_service<virtual_clock>(io)) {
+      return true;
+    }
+    virtual_clock & clock = virtual_clock::get(io);
+    if (clock.pending_timers() != 0) {
+      return false;
+    }
+    clock.reset();
+    return true;
+  }
+
+ private:
+  static std::mutex & mu() {
+    static std::mutex m;
+    return m;
+  }
+
+  /// The idle io_service objects, protected by mu().
+  static std::vector<std::unique_ptr<boost::asio::io_service>> &
+  idle_services() {
+    static std::vector<std::unique_ptr<boost::asio::io_service>> idle;
+    return idle;
+  }
+};
+
+} // namespace detail
+} // namespace asio
+} // namespace skye
+
+#endif // skye_asio_detail_io_service_pool_hpp
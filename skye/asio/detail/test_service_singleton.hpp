@@ -1,9 +1,9 @@
 #ifndef skye_asio_test_service_singleton_hpp
 #define skye_asio_test_service_singleton_hpp
 
-#include <boost/asio/io_service.hpp>
+#include <skye/asio/io_service_context.hpp>
 
-#include <memory>
+#include <boost/asio/io_service.hpp>
 
 namespace skye {
 namespace asio {
@@ -12,34 +12,27 @@ namespace detail {
 /**
  * Create a pre-defined io service to make implementation of mock
  * services easier, and allow tests to reset the io_service.
+ *
+ * Despite the name, the io_service is not shared by all threads, it
+ * is the io_service of the active io_service_context in the calling
+ * thread.
  */
 template<bool unused>
 class test_service_singleton {
  public:
   /// Returns the current instance, creates one if necessary.
   static boost::asio::io_service & instance() {
-    if (not instance_) {
-      return test_service_singleton::reset_instance();
-    }
-    return *instance_;
+    return io_service_context::active().get();
   }
 
-  /// Creates a new instance and destroys the existing one
+  /// Replaces the current instance with a fresh one from the pool.
   static boost::asio::io_service & reset_instance() {
-    instance_.reset(new boost::asio::io_service);
-    return *instance_;
+    return io_service_context::active().reset();
   }
-
-  static std::unique_ptr<boost::asio::io_service> instance_;
 };
 
-template<bool unused>
-std::unique_ptr<boost::asio::io_service>
-test_service_singleton<unused>::instance_;
-
 } // namespace detail
 } // namespace asio
 } // namespace skye
 
 #endif // skye_asio_test_service_singleton_hpp
-
@@ -29,3 +29,59 @@ BOOST_AUTO_TEST_CASE( test_async_function_argument_capture ) {
   c2->call_functor(1, 2);
   BOOST_CHECK_EQUAL(x, 3);
 }
+
+/**
+ * @test Verify that typical async_read_some() captures are stored
+ * inline, and compared without RTTI.
+ */
+BOOST_AUTO_TEST_CASE( test_async_function_argument_capture_inline ) {
+  typedef async_function_argument_capture<void(int,int)> capture_strategy;
+
+  char data[16];
+  int x = 0;
+  auto c1 = capture_strategy::capture(
+      boost::asio::buffer(data), [&x](int a, int b) { x = a + b; });
+  BOOST_CHECK(c1.is_inline());
+
+  auto c2 = c1;
+  capture_strategy::call_functor(c2, 2, 3);
+  BOOST_CHECK_EQUAL(x, 5);
+
+  auto c3 = capture_strategy::capture(1, [](int, int) {});
+  BOOST_CHECK(not capture_strategy::equals(c1, c3));
+}
+
+/**
+ * @test Verify that scatter/gather buffer sequences are supported.
+ */
+BOOST_AUTO_TEST_CASE( test_async_function_argument_capture_sequence ) {
+  typedef async_function_argument_capture<void(int,int)> capture_strategy;
+
+  std::string const a("abc"), b("defgh");
+  std::vector<boost::asio::const_buffer> gather{
+    boost::asio::buffer(a), boost::asio::buffer(b)};
+  auto c1 = capture_strategy::capture(gather, [](int, int) {});
+  BOOST_CHECK_EQUAL(c1->get_buffer_size(), 8);
+  BOOST_CHECK_EQUAL(c1->get_buffer_count(), 2);
+  BOOST_CHECK_EQUAL(c1->get_buffer_data(), static_cast<void const*>(a.data()));
+  BOOST_CHECK_EQUAL(
+      boost::asio::buffer_cast<void const*>(c1->get_buffer(1)),
+      static_cast<void const*>(b.data()));
+  BOOST_CHECK_THROW(c1->get_buffer(2), std::out_of_range);
+
+  char gathered[16];
+  BOOST_CHECK_EQUAL(c1->copy_buffer_data(gathered, sizeof(gathered)), 8);
+  BOOST_CHECK_EQUAL(std::string(gathered, 8), "abcdefgh");
+
+  char x[2], y[4];
+  std::vector<boost::asio::mutable_buffer> scatter{
+    boost::asio::buffer(x), boost::asio::buffer(y)};
+  auto c2 = capture_strategy::capture(scatter, [](int, int) {});
+  c2->set_buffer_data("012345", 6);
+  BOOST_CHECK_EQUAL(std::string(x, 2), "01");
+  BOOST_CHECK_EQUAL(std::string(y, 4), "2345");
+
+  auto c3 = capture_strategy::capture(1, [](int, int) {});
+  BOOST_CHECK_THROW(c3->get_buffer_count(), std::runtime_error);
+  BOOST_CHECK_THROW(c3->copy_buffer_data(gathered, 1), std::runtime_error);
+}
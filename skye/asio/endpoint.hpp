@@ -1,13 +1,13 @@
 #ifndef skye_asio_endpoint_hpp
 #define skye_asio_endpoint_hpp
 
+#include <skye/asio/fwd.hpp>
+
 #include <iostream>
 
 namespace skye {
 namespace asio {
 
-struct protocol;
-
 /**
  * Define the endpoint class for the Boost.ASIO mocks.
  */
@@ -0,0 +1,164 @@
+#ifndef skye_asio_fault_injection_hpp
+#define skye_asio_fault_injection_hpp
+
+#include <boost/asio/error.hpp>
+#include <boost/system/error_code.hpp>
+
+#include <cstdint>
+#include <random>
+#include <vector>
+
+namespace skye {
+namespace asio {
+
+/**
+ * Configure the faults injected by a fault_injector.
+ *
+ * The default policy injects no faults.
+ */
+struct fault_policy {
+  fault_policy()
+      : seed(0)
+      , max_read_size(0)
+      , max_write_size(0)
+      , split_reads(false)
+      , short_writes(false)
+      , read_error_rate(0.0)
+      , write_error_rate(0.0)
+      , errors{boost::asio::error::connection_reset}
+  {}
+
+  /// The seed for the pseudo-random generator.
+  std::uint32_t seed;
+  /// Cap the bytes per read completion, 0 means no cap.
+  std::size_t max_read_size;
+  /// Cap the bytes per write completion, 0 means no cap.
+  std::size_t max_write_size;
+  /// Complete reads with a random number of the bytes available.
+  bool split_reads;
+  /// Complete writes with a random number of the bytes requested.
+  bool short_writes;
+  /// The probability that a read completes with an error.
+  double read_error_rate;
+  /// The probability that a write completes with an error.
+  double write_error_rate;
+  /// The errors to inject, picked at random.
+  std::vector<boost::system::error_code> errors;
+};
+
+/**
+ * Decide the faults for each I/O operation, deterministically.
+ *
+ * Given the same policy (and seed) the injector makes the same
+ * decisions for the same sequence of operations, so a failing
+ * randomized schedule can be reproduced from its seed.  The
+ * decisions only use the raw output of std::mt19937, which is fully
+ * specified by the standard, and not the distributions, which are
+ * not.
+ */
+class fault_injector {
+ public:
+  explicit fault_injector(fault_policy const & policy)
+      : policy_(policy)
+      , generator_(policy.seed)
+      , injected_errors_(0)
+      , short_reads_(0)
+      , short_writes_(0)
+  {}
+
+  /**
+   * Decide if a read fails.
+   *
+   * @returns true and sets @a ec if the read must fail.
+   */
+  bool read_error(boost::system::error_code & ec) {
+    return inject(policy_.read_error_rate, ec);
+  }
+
+  /**
+   * Decide if a write fails.
+   *
+   * @returns true and sets @a ec if the write must fail.
+   */
+  bool write_error(boost::system::error_code & ec) {
+    return inject(policy_.write_error_rate, ec);
+  }
+
+  /// Decide how many of the @a size bytes available a read returns.
+  std::size_t read_size(std::size_t size) {
+    std::size_t n = limit(size, policy_.max_read_size, policy_.split_reads);
+    if (n != size) {
+      ++short_reads_;
+    }
+    return n;
+  }
+
+  /// Decide how many of the @a size bytes requested a write takes.
+  std::size_t write_size(std::size_t size) {
+    std::size_t n =
+        limit(size, policy_.max_write_size, policy_.short_writes);
+    if (n != size) {
+      ++short_writes_;
+    }
+    return n;
+  }
+
+  //@{
+  /**
+   * @name Accessors
+   */
+  fault_policy const & policy() const {
+    return policy_;
+  }
+  std::size_t injected_errors() const {
+    return injected_errors_;
+  }
+  std::size_t short_reads() const {
+    return short_reads_;
+  }
+  std::size_t short_writes() const {
+    return short_writes_;
+  }
+  //@}
+
+ private:
+  /// Return a pseudo-random number in [0, n).
+  std::size_t uniform(std::size_t n) {
+    return static_cast<std::size_t>(generator_() % n);
+  }
+
+  bool inject(double rate, boost::system::error_code & ec) {
+    if (rate <= 0.0 or policy_.errors.empty()) {
+      return false;
+    }
+    double const r = generator_() / (double(std::mt19937::max()) + 1.0);
+    if (r >= rate) {
+      return false;
+    }
+    ec = policy_.errors[uniform(policy_.errors.size())];
+    ++injected_errors_;
+    return true;
+  }
+
+  std::size_t limit(std::size_t size, std::size_t max, bool split) {
+    if (max != 0 and size > max) {
+      size = max;
+    }
+    if (split and size > 1) {
+      size = 1 + uniform(size);
+    }
+    return size;
+  }
+
+ private:
+  fault_policy policy_;
+  std::mt19937 generator_;
+  std::size_t injected_errors_;
+  std::size_t short_reads_;
+  std::size_t short_writes_;
+};
+
+} // namespace asio
+} // namespace skye
+
+#endif // skye_asio_fault_injection_hpp
@@ -0,0 +1,50 @@
+#ifndef skye_asio_fwd_hpp
+#define skye_asio_fwd_hpp
+
+/**
+ * @file
+ *
+ * Forward declarations for the Boost.ASIO mocks.
+ *
+ * The mock headers include Boost.ASIO and the Skye mock templates,
+ * which are expensive to compile.  Headers that only name the mocks,
+ * for example to declare functions taking a skye::asio::socket&,
+ * should include this file instead.  It does not include any Boost
+ * headers.
+ */
+
+namespace skye {
+namespace asio {
+
+class acceptor;
+class connection_generator;
+struct connection_schedule;
+struct fault_policy;
+class fault_injector;
+class io_service_context;
+class iterator;
+class loopback;
+class mock_endpoint;
+struct protocol;
+class resolver;
+class service;
+class socket;
+class socket_pair;
+class stream_engine;
+class timer;
+class trace_reader;
+struct trace_record;
+class trace_replayer;
+class trace_writer;
+
+template<typename capture_strategy_T>
+class async_member_function;
+
+template<bool unused>
+class basic_virtual_clock;
+typedef basic_virtual_clock<true> virtual_clock;
+
+} // namespace asio
+} // namespace skye
+
+#endif // skye_asio_fwd_hpp
@@ -0,0 +1,110 @@
+#ifndef skye_asio_io_service_context_hpp
+#define skye_asio_io_service_context_hpp
+
+#include <skye/asio/detail/io_service_pool.hpp>
+
+#include <boost/asio/io_service.hpp>
+
+#include <memory>
+
+namespace skye {
+namespace asio {
+
+/**
+ * Select the io_service used by the mocks in the current thread.
+ *
+ * The mocks created without an explicit io_service (see
+ * skye::asio::service) use the io_service of the innermost context
+ * in their thread.  Each thread has its own default context, so test
+ * cases running in separate threads never share an io_service.  A
+ * test can also create its own context, for the duration of a scope:
+ *
+ * @code
+ * BOOST_AUTO_TEST_CASE( my_test ) {
+ *   skye::asio::io_service_context context;
+ *   skye::asio::socket s;
+ *   ...
+ *   context.get().run();
+ * }
+ * @endcode
+ *
+ * The io_service objects come from a process-wide pool, and return
+ * to it when the context is destroyed or reset, so creating a context
+ * is cheap.  The handlers still queued in the io_service, for example
+ * if the test never called run(), or after an explicit call to
+ * stop(), run when the context releases the io_service, never in
+ * another context.  Only the io_service objects that then run out of
+ * work are recycled, the rest are destroyed with their pending
+ * operations.  Destroy the objects that may post handlers (such as a
+ * skye::asio::timer with pending waits) before the last call to
+ * run(), or call reset() on a context that ends with pending
+ * operations to discard them.
+ *
+ * Contexts must be destroyed in the reverse order of construction,
+ * in the thread that created them.
+ */
+class io_service_context {
+ public:
+  typedef detail::io_service_pool pool;
+
+  /// Make a pooled io_service the current one in this thread.
+  io_service_context()
+      : io_(pool::acquire())
+      , previous_(current()) {
+    current() = this;
+  }
+
+  /// Restore the previous context and recycle the io_service.
+  ~io_service_context() {
+    current() = previous_;
+    pool::release(std::move(io_));
+  }
+
+  io_service_context(io_service_context const &) = delete;
+  io_service_context & operator=(io_service_context const &) = delete;
+
+  /// The io_service of this context.
+  boost::asio::io_service & get() {
+    return *io_;
+  }
+
+  /**
+   * Replace the io_service with another one from the pool.
+   *
+   * The handlers queued in the current io_service run first, if that
+   * does not leave it out of work it is destroyed, without completing
+   * any pending operations.
+   */
+  boost::asio::io_service & reset() {
+    pool::release(std::move(io_));
+    io_ = pool::acquire();
+    return *io_;
+  }
+
+  /// The innermost context in this thread, created if needed.
+  static io_service_context & active() {
+    if (current() == nullptr) {
+      // ... the default context registers itself as current ...
+      static thread_local io_service_context default_context;
+      if (current() == nullptr) {
+        return default_context;
+      }
+    }
+    return *current();
+  }
+
+ private:
+  static io_service_context * & current() {
+    static thread_local io_service_context * context = nullptr;
+    return context;
+  }
+
+ private:
+  std::unique_ptr<boost::asio::io_service> io_;
+  io_service_context * previous_;
+};
+
+} // namespace asio
+} // namespace skye
+
+#endif // skye_asio_io_service_context_hpp
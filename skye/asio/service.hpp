@@ -22,17 +22,34 @@ class service : public boost::asio::io_service::service {
   service()
       : boost::asio::io_service::service(
           detail::test_service_singleton<true>::instance())
+      , io_(detail::test_service_singleton<true>::instance())
   {}
   explicit service(boost::asio::io_service & io)
       : boost::asio::io_service::service(io)
+      , io_(io)
   {}
 
-  /// Returns the singleton io service for testing purposes
+  /**
+   * Return the io_service used by this object.
+   *
+   * Newer versions of Boost.ASIO only provide get_io_context() in the
+   * base class, this works with all of them.
+   */
+  boost::asio::io_service & get_io_service() {
+    return io_;
+  }
+
+  /**
+   * Returns the io service for testing purposes.
+   *
+   * Each thread has its own, see io_service_context.
+   */
   static boost::asio::io_service & io_service_for_testing() {
     return detail::test_service_singleton<true>::instance();
   }
 
-  /// Reset the singleton, usually called at the beginning of each test.
+  /// Reset the io service of this thread, usually called at the
+  /// beginning of each test.
   static boost::asio::io_service & reset_io_service_for_testing() {
     return detail::test_service_singleton<true>::reset_instance();
   }
@@ -49,6 +66,9 @@ class service : public boost::asio::io_service::service {
   virtual void shutdown_service() override {
     shutdown_service_capture();
   }
+
+ private:
+  boost::asio::io_service & io_;
 };
 
 } // namespace asio
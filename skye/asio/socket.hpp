@@ -3,14 +3,13 @@
 
 #include <skye/asio/async_io_member_function.hpp>
 #include <skye/asio/async_connect_member_function.hpp>
+#include <skye/asio/fwd.hpp>
 #include <skye/asio/service.hpp>
 #include <skye/mock_function.hpp>
 
 namespace skye {
 namespace asio {
 
-struct protocol;
-
 /**
  * A mock implementation of the socket API in Boost.ASIO.
  */
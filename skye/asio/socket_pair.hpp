@@ -0,0 +1,199 @@
+#ifndef skye_asio_socket_pair_hpp
+#define skye_asio_socket_pair_hpp
+
+#include <skye/asio/acceptor.hpp>
+#include <skye/asio/stream_engine.hpp>
+
+#include <deque>
+#include <memory>
+#include <vector>
+
+namespace skye {
+namespace asio {
+
+/**
+ * Two mock sockets connected to each other.
+ *
+ * The data written to either socket is readable from the other one,
+ * and the completion handlers are posted to the io_service, so a
+ * client and a server can run against each other in a single process:
+ *
+ * @code
+ * boost::asio::io_service io;
+ * skye::asio::socket_pair p(io);
+ * my_server server(p.server());
+ * my_client client(p.client());
+ * client.start();
+ * io.run();
+ * @endcode
+ */
+class socket_pair {
+ public:
+  explicit socket_pair(boost::asio::io_service & io)
+      : client_(io)
+      , server_(io)
+      , client_engine_(client_)
+      , server_engine_(server_) {
+    client_engine_.connect(server_engine_);
+  }
+
+  //@{
+  /**
+   * @name Accessors
+   */
+  socket & client() {
+    return client_;
+  }
+  socket & server() {
+    return server_;
+  }
+  stream_engine & client_engine() {
+    return client_engine_;
+  }
+  stream_engine & server_engine() {
+    return server_engine_;
+  }
+  //@}
+
+ private:
+  socket client_;
+  socket server_;
+  stream_engine client_engine_;
+  stream_engine server_engine_;
+};
+
+/**
+ * Connect mock client sockets to a mock acceptor.
+ *
+ * Each call to connect() is matched with a call to async_accept() on
+ * the acceptor, in order.  The accept operation completes
+ * successfully, and the socket passed to async_accept() is connected
+ * with the client socket.  Like with a real listening socket, the
+ * client can connect (and write) before the server accepts the
+ * connection:
+ *
+ * @code
+ * skye::asio::acceptor a(io);
+ * skye::asio::loopback network(a);
+ * my_server server(a);
+ * server.start();
+ * for (auto & s : clients) {
+ *   network.connect(s).feed(...);
+ * }
+ * io.run();
+ * @endcode
+ *
+ * The loopback owns the engines for all the connections, it must
+ * outlive the sockets' pending operations, and the sockets must
+ * outlive the loopback.
+ */
+class loopback {
+ public:
+  typedef async_accept_member_function::value_type operation;
+
+  explicit loopback(acceptor & a)
+      : acceptor_(a)
+      , io_(a.get_io_service())
+      , pending_accepts_()
+      , pending_connects_()
+      , connections_() {
+    acceptor_.async_accept.set_accept_hook(
+        [this](socket & peer, operation const & op) {
+          on_accept(peer, op);
+        });
+  }
+  ~loopback() {
+    acceptor_.async_accept.set_accept_hook(nullptr);
+  }
+
+  loopback(loopback const &) = delete;
+  loopback & operator=(loopback const &) = delete;
+
+  /**
+   * Connect @a client to the acceptor.
+   *
+   * @returns the engine for the client socket.
+   */
+  stream_engine & connect(socket & client) {
+    connections_.emplace_back(new connection(client));
+    connection & c = *connections_.back();
+    if (pending_accepts_.empty()) {
+      pending_connects_.push_back(&c);
+      return c.client;
+    }
+    auto & accept = pending_accepts_.front();
+    establish(c, *accept.first, std::move(accept.second));
+    pending_accepts_.pop_front();
+    return c.client;
+  }
+
+  //@{
+  /**
+   * @name Accessors
+   */
+  /// The number of async_accept() calls waiting for a connection.
+  std::size_t pending_accepts() const {
+    return pending_accepts_.size();
+  }
+  /// The number of connections waiting for an async_accept() call.
+  std::size_t pending_connects() const {
+    return pending_connects_.size();
+  }
+  /// The number of connections, accepted or not.
+  std::size_t connections() const {
+    return connections_.size();
+  }
+  stream_engine & client_engine(std::size_t i) {
+    return connections_.at(i)->client;
+  }
+  /// The engine for the server side, null if not accepted yet.
+  stream_engine * server_engine(std::size_t i) {
+    return connections_.at(i)->server.get();
+  }
+  //@}
+
+ private:
+  /// The state for each connection.
+  struct connection {
+    explicit connection(socket & c)
+        : client(c)
+        , server()
+    {}
+
+    stream_engine client;
+    std::unique_ptr<stream_engine> server;
+  };
+
+  void on_accept(socket & peer, operation const & op) {
+    if (pending_connects_.empty()) {
+      pending_accepts_.emplace_back(&peer, op);
+      return;
+    }
+    establish(*pending_connects_.front(), peer, op);
+    pending_connects_.pop_front();
+  }
+
+  void establish(connection & c, socket & peer, operation op) {
+    c.server.reset(new stream_engine(peer));
+    // ... the data written before the connection was accepted is
+    // waiting for the server ...
+    c.server->feed(c.client.output());
+    c.client.clear_output();
+    c.client.connect(*c.server);
+    io_.post([op]() mutable {
+        op->call_functor(boost::system::error_code());
+      });
+  }
+
+ private:
+  acceptor & acceptor_;
+  boost::asio::io_service & io_;
+  std::deque<std::pair<socket*, operation>> pending_accepts_;
+  std::deque<connection*> pending_connects_;
+  std::vector<std::unique_ptr<connection>> connections_;
+};
+
+} // namespace asio
+} // namespace skye
+
+#endif // skye_asio_socket_pair_hpp
@@ -0,0 +1,322 @@
+#ifndef skye_asio_stream_engine_hpp
+#define skye_asio_stream_engine_hpp
+
+#include <skye/asio/fault_injection.hpp>
+#include <skye/asio/socket.hpp>
+
+#include <boost/asio/error.hpp>
+#include <boost/asio/io_service.hpp>
+
+#include <algorithm>
+#include <deque>
+#include <memory>
+#include <string>
+
+namespace skye {
+namespace asio {
+
+/**
+ * Complete the reads and writes on a mock socket using in-memory data.
+ *
+ * By default the async_read_some() and async_write_some() mocks in
+ * skye::asio::socket only capture their arguments, and the test must
+ * complete each operation by hand.  Once a stream_engine is attached
+ * to a socket, reads consume the bytes provided to feed(), and
+ * writes are appended to output().  The completion handlers are
+ * posted to the io_service of the socket, so they run as the test
+ * runs the io_service, just like a real socket:
+ *
+ * @code
+ * skye::asio::socket s(io);
+ * skye::asio::stream_engine engine(s);
+ * engine.feed("HELLO\n");
+ * engine.close_input();
+ * my_protocol p(s);
+ * p.start();
+ * io.run();
+ * BOOST_CHECK_EQUAL(engine.output(), "WORLD\n");
+ * @endcode
+ *
+ * The mocks still capture every call, so the usual assertions work.
+ * The test must not complete the captured operations by hand.
+ *
+ * Reads complete with the bytes available, up to the size of the
+ * buffer, if no bytes are available they wait for the next call to
+ * feed().  After close_input() and once all the bytes are consumed,
+ * reads complete with an error (boost::asio::error::eof by
+ * default).  Writes always complete in full.
+ *
+ * Two engines can be connected with connect(), then the data written
+ * to either socket becomes readable on the other, see
+ * skye::asio::socket_pair.  The data is copied only once when the
+ * peer has a read pending: directly from the write buffer to the
+ * read buffer.
+ *
+ * With set_fault_policy() the engine also injects short reads, short
+ * writes and errors, deterministically for a given seed, see
+ * fault_policy.
+ *
+ * The engine is not thread-safe, and must outlive any pending
+ * operation on the socket.
+ */
+class stream_engine {
+ public:
+  typedef async_io_capture::value_type operation;
+
+  /// Attach the engine to @a s.
+  explicit stream_engine(socket & s)
+      : socket_(s)
+      , io_(s.get_io_service())
+      , input_()
+      , input_offset_(0)
+      , input_closed_(false)
+      , input_error_()
+      , pending_reads_()
+      , output_()
+      , bytes_read_(0)
+      , bytes_written_(0)
+      , peer_(nullptr)
+      , faults_() {
+    socket_.async_read_some.set_capture_hook(
+        [this](operation const & op) { on_read(op); });
+    socket_.async_write_some.set_capture_hook(
+        [this](operation const & op) { on_write(op); });
+  }
+
+  /// Detach the engine from the socket and its peer.
+  ~stream_engine() {
+    if (peer_ != nullptr) {
+      peer_->peer_ = nullptr;
+    }
+    socket_.async_read_some.set_capture_hook(nullptr);
+    socket_.async_write_some.set_capture_hook(nullptr);
+  }
+
+  stream_engine(stream_engine const &) = delete;
+  stream_engine & operator=(stream_engine const &) = delete;
+
+  /// Append @a size bytes to the data returned by future reads.
+  void feed(void const * data, std::size_t size) {
+    char const * bytes = static_cast<char const*>(data);
+    // ... if reads are waiting there is no data buffered, copy
+    // directly into their buffers ...
+    while (size != 0 and not pending_reads_.empty()) {
+      std::size_t const n =
+          complete_read(std::move(pending_reads_.front()), bytes, size);
+      pending_reads_.pop_front();
+      bytes += n;
+      size -= n;
+    }
+    if (size == 0) {
+      return;
+    }
+    compact();
+    input_.append(bytes, size);
+  }
+
+  /// Append @a data to the data returned by future reads.
+  void feed(std::string const & data) {
+    feed(data.data(), data.size());
+  }
+
+  /**
+   * Complete the reads with @a ec once all the data is consumed.
+   *
+   * The default simulates the peer closing the connection.
+   */
+  void close_input(
+      boost::system::error_code const & ec = boost::asio::error::eof) {
+    input_closed_ = true;
+    input_error_ = ec;
+    complete_reads();
+  }
+
+  /// Discard the data written so far.
+  void clear_output() {
+    output_.clear();
+  }
+
+  /**
+   * Inject faults in the following reads and writes.
+   *
+   * Reads return at most the bytes allowed by the policy, writes
+   * consume at most the bytes allowed, and either may fail with one
+   * of the policy errors.  A failed operation transfers no data, the
+   * following operations are not affected.
+   */
+  void set_fault_policy(fault_policy const & policy) {
+    faults_.reset(new fault_injector(policy));
+  }
+
+  /// Stop injecting faults.
+  void clear_fault_policy() {
+    faults_.reset();
+  }
+
+  /**
+   * Connect this engine with @a peer.
+   *
+   * The data written to either socket is fed to the other engine,
+   * and is not recorded in output().
+   */
+  void connect(stream_engine & peer) {
+    peer_ = &peer;
+    peer.peer_ = this;
+  }
+
+  /**
+   * Close the peer's input, as if this socket was shutdown for
+   * writing.
+   */
+  void shutdown_output(
+      boost::system::error_code const & ec = boost::asio::error::eof) {
+    if (peer_ != nullptr) {
+      peer_->close_input(ec);
+    }
+  }
+
+  //@{
+  /**
+   * @name Accessors
+   */
+  /// The bytes written to the socket, concatenated, unless connected.
+  std::string const & output() const {
+    return output_;
+  }
+  /// The number of bytes fed but not yet read.
+  std::size_t available() const {
+    return input_.size() - input_offset_;
+  }
+  /// The number of reads waiting for data.
+  std::size_t pending_reads() const {
+    return pending_reads_.size();
+  }
+  std::size_t bytes_read() const {
+    return bytes_read_;
+  }
+  std::size_t bytes_written() const {
+    return bytes_written_;
+  }
+  bool connected() const {
+    return peer_ != nullptr;
+  }
+  /// The fault injector, null if no faults are injected.
+  fault_injector const * faults() const {
+    return faults_.get();
+  }
+  //@}
+
+ private:
+  void on_read(operation const & op) {
+    pending_reads_.push_back(op);
+    complete_reads();
+  }
+
+  void on_write(operation const & op) {
+    boost::system::error_code ec;
+    if (faults_ and faults_->write_error(ec)) {
+      post(op, ec, 0);
+      return;
+    }
+    std::size_t size = op->get_buffer_size();
+    if (faults_) {
+      size = faults_->write_size(size);
+    }
+    if (peer_ != nullptr) {
+      // ... gather writes are fed one buffer at a time, without
+      // coalescing them first ...
+      std::size_t const count = op->get_buffer_count();
+      std::size_t remaining = size;
+      for (std::size_t i = 0; i != count and remaining != 0; ++i) {
+        boost::asio::const_buffer b = op->get_buffer(i);
+        std::size_t const n = std::min(remaining, boost::asio::buffer_size(b));
+        peer_->feed(boost::asio::buffer_cast<void const*>(b), n);
+        remaining -= n;
+      }
+    } else {
+      std::size_t const offset = output_.size();
+      output_.resize(offset + size);
+      op->copy_buffer_data(&output_[offset], size);
+    }
+    bytes_written_ += size;
+    post(op, boost::system::error_code(), size);
+  }
+
+  /// Complete as many pending reads as the available data allows.
+  void complete_reads() {
+    while (not pending_reads_.empty()) {
+      operation & op = pending_reads_.front();
+      std::size_t const size = op->get_buffer_size();
+      if (size == 0) {
+        // ... like real sockets, empty reads complete immediately ...
+        post(std::move(op), boost::system::error_code(), 0);
+      } else if (available() != 0) {
+        input_offset_ += complete_read(
+            std::move(op), input_.data() + input_offset_, available());
+      } else if (input_closed_) {
+        post(std::move(op), input_error_, 0);
+      } else {
+        return;
+      }
+      pending_reads_.pop_front();
+    }
+  }
+
+  /**
+   * Complete @a op with up to @a size bytes from @a data.
+   *
+   * @returns the number of bytes consumed.
+   */
+  std::size_t complete_read(
+      operation op, char const * data, std::size_t size) {
+    boost::system::error_code ec;
+    if (faults_ and faults_->read_error(ec)) {
+      post(std::move(op), ec, 0);
+      return 0;
+    }
+    std::size_t n = std::min(size, op->get_buffer_size());
+    if (faults_) {
+      n = faults_->read_size(n);
+    }
+    op->set_buffer_data(data, n);
+    bytes_read_ += n;
+    post(std::move(op), ec, n);
+    return n;
+  }
+
+  /// Discard the data already read, if that is most of the buffer.
+  void compact() {
+    if (input_offset_ == 0 or input_offset_ < input_.size() / 2) {
+      return;
+    }
+    input_.erase(0, input_offset_);
+    input_offset_ = 0;
+  }
+
+  void post(
+      operation completion, boost::system::error_code const & ec,
+      std::size_t n) {
+    io_.post([completion, ec, n]() mutable {
+        completion->call_functor(ec, n);
+      });
+  }
+
+ private:
+  socket & socket_;
+  boost::asio::io_service & io_;
+  std::string input_;
+  std::size_t input_offset_;
+  bool input_closed_;
+  boost::system::error_code input_error_;
+  std::deque<operation> pending_reads_;
+  std::string output_;
+  std::size_t bytes_read_;
+  std::size_t bytes_written_;
+  stream_engine * peer_;
+  std::unique_ptr<fault_injector> faults_;
+};
+
+} // namespace asio
+} // namespace skye
+
+#endif // skye_asio_stream_engine_hpp
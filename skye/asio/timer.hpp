@@ -0,0 +1,161 @@
+#ifndef skye_asio_timer_hpp
+#define skye_asio_timer_hpp
+
+#include <skye/asio/async_wait_member_function.hpp>
+#include <skye/asio/service.hpp>
+#include <skye/asio/virtual_clock.hpp>
+
+#include <boost/asio/error.hpp>
+
+#include <vector>
+
+namespace skye {
+namespace asio {
+
+/**
+ * A mock implementation of the waitable timers in Boost.ASIO.
+ *
+ * The timer uses the virtual clock of its io_service (see
+ * virtual_clock), so the tests control the passage of time.  Like the
+ * other mocks, async_wait() captures its arguments, and the usual
+ * assertions work on it.  In addition, the handlers are posted to the
+ * io_service when the virtual clock reaches the timer expiration, or
+ * with boost::asio::error::operation_aborted if the timer is
+ * cancelled, its expiration changed, or it is destroyed.
+ *
+ * Only the std::chrono based interface is supported.
+ */
+class timer : public service, private detail::virtual_timer {
+ public:
+  typedef virtual_clock clock_type;
+  typedef virtual_clock::duration duration;
+  typedef virtual_clock::time_point time_point;
+  typedef async_wait_capture::value_type operation;
+
+  timer()
+      : service()
+      , clock_(virtual_clock::get(get_io_service()))
+      , expiry_(clock_.now())
+      , waits_()
+      , scheduled_(false)
+      , handle_() {
+    hook();
+  }
+  explicit timer(boost::asio::io_service & io)
+      : service(io)
+      , clock_(virtual_clock::get(io))
+      , expiry_(clock_.now())
+      , waits_()
+      , scheduled_(false)
+      , handle_() {
+    hook();
+  }
+  timer(boost::asio::io_service & io, duration d)
+      : timer(io) {
+    expiry_ = clock_.now() + d;
+  }
+  ~timer() {
+    cancel();
+  }
+
+  mutable skye::asio::async_wait_member_function async_wait;
+
+  /**
+   * Cancel all the pending waits.
+   *
+   * @returns the number of waits cancelled.
+   */
+  std::size_t cancel() {
+    if (scheduled_) {
+      clock_.unschedule(handle_);
+      scheduled_ = false;
+    }
+    return complete(boost::asio::error::operation_aborted);
+  }
+
+  //@{
+  /**
+   * @name Set the expiration time, cancelling any pending waits.
+   *
+   * @returns the number of waits cancelled.
+   */
+  std::size_t expires_at(time_point t) {
+    std::size_t const n = cancel();
+    expiry_ = t;
+    return n;
+  }
+  std::size_t expires_from_now(duration d) {
+    return expires_at(clock_.now() + d);
+  }
+  std::size_t expires_after(duration d) {
+    return expires_from_now(d);
+  }
+  //@}
+
+  //@{
+  /**
+   * @name Accessors
+   */
+  time_point expires_at() const {
+    return expiry_;
+  }
+  time_point expiry() const {
+    return expiry_;
+  }
+  duration expires_from_now() const {
+    return expiry_ - clock_.now();
+  }
+  /// The number of async_wait() calls not completed yet.
+  std::size_t pending_waits() const {
+    return waits_.size();
+  }
+  //@}
+
+ private:
+  void hook() {
+    async_wait.set_capture_hook(
+        [this](operation const & op) { on_wait(op); });
+  }
+
+  void on_wait(operation const & op) {
+    waits_.push_back(op);
+    if (expiry_ <= clock_.now()) {
+      complete(boost::system::error_code());
+      return;
+    }
+    if (not scheduled_) {
+      handle_ = clock_.schedule(expiry_, this);
+      scheduled_ = true;
+    }
+  }
+
+  virtual void expire() override {
+    scheduled_ = false;
+    complete(boost::system::error_code());
+  }
+
+  /// Post the completion of all the pending waits.
+  std::size_t complete(boost::system::error_code const & ec) {
+    std::size_t const n = waits_.size();
+    for (auto & op : waits_) {
+      operation completion(std::move(op));
+      get_io_service().post([completion, ec]() mutable {
+          completion->call_functor(ec);
+        });
+    }
+    waits_.clear();
+    return n;
+  }
+
+ private:
+  virtual_clock & clock_;
+  time_point expiry_;
+  std::vector<operation> waits_;
+  bool scheduled_;
+  virtual_clock::handle handle_;
+};
+
+} // namespace asio
+} // namespace skye
+
+#endif // skye_asio_timer_hpp
@@ -0,0 +1,233 @@
+#ifndef skye_asio_trace_hpp
+#define skye_asio_trace_hpp
+
+#include <boost/asio/error.hpp>
+#include <boost/system/error_code.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <istream>
+#include <limits>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+
+namespace skye {
+namespace asio {
+
+/**
+ * One I/O operation in a trace.
+ */
+struct trace_record {
+  enum direction_type { read = 0, write = 1 };
+  typedef std::chrono::nanoseconds duration;
+
+  trace_record()
+      : direction(read)
+      , error()
+      , delay(0)
+      , data()
+  {}
+
+  /// If the operation was a read or a write.
+  direction_type direction;
+  /// The error code the operation completed with.
+  boost::system::error_code error;
+  /// The time elapsed since the previous operation in the trace.
+  duration delay;
+  /// The bytes transferred by the operation.
+  std::string data;
+};
+
+namespace detail {
+
+/// The first bytes of any trace, including the format version.
+char const trace_magic[8] = {'S', 'K', 'Y', 'E', 'T', 'R', 'C', '1'};
+
+/// The size of the fixed part of each record.
+std::size_t const trace_record_header_size = 1 + 1 + 4 + 8 + 4;
+
+//@{
+/**
+ * @name Error categories that can be stored in a trace.
+ *
+ * Error codes are stored as a (category, value) pair, only the
+ * categories used by Boost.ASIO are supported.
+ */
+inline boost::system::error_category const & trace_category(
+    std::uint8_t c) {
+  switch (c) {
+    case 0: return boost::system::system_category();
+    case 1: return boost::system::generic_category();
+    case 2: return boost::asio::error::get_misc_category();
+    case 3: return boost::asio::error::get_netdb_category();
+    case 4: return boost::asio::error::get_addrinfo_category();
+  }
+  throw std::runtime_error("Unknown error category in trace");
+}
+
+inline std::uint8_t trace_category_id(
+    boost::system::error_category const & category) {
+  for (std::uint8_t c = 0; c != 5; ++c) {
+    if (category == trace_category(c)) {
+      return c;
+    }
+  }
+  throw std::invalid_argument("Error category cannot be traced");
+}
+//@}
+
+//@{
+/**
+ * @name Encode integers in little-endian order, on any platform.
+ */
+template<typename integer>
+void trace_encode(char * p, integer value) {
+  for (std::size_t i = 0; i != sizeof(integer); ++i) {
+    p[i] = static_cast<char>((value >> (8 * i)) & 0xff);
+  }
+}
+
+template<typename integer>
+integer trace_decode(char const * p) {
+  integer value = 0;
+  for (std::size_t i = 0; i != sizeof(integer); ++i) {
+    value |= static_cast<integer>(static_cast<unsigned char>(p[i]))
+        << (8 * i);
+  }
+  return value;
+}
+//@}
+
+} // namespace detail
+
+/**
+ * Write a trace of socket operations to a stream.
+ *
+ * The format is compact and portable: a fixed header, followed by
+ * one record per operation, each one a fixed size header with the
+ * direction, error, delay and size, followed by the data.  All
+ * integers are little-endian.  The records are written as they
+ * arrive, so the trace can be captured from a long running program.
+ */
+class trace_writer {
+ public:
+  /// Write the trace header to @a os.
+  explicit trace_writer(std::ostream & os)
+      : os_(os)
+      , records_(0) {
+    os_.write(detail::trace_magic, sizeof(detail::trace_magic));
+  }
+
+  /// Append a record to the trace.
+  void write(trace_record const & r) {
+    write(r.direction, r.error, r.delay, r.data.data(), r.data.size());
+  }
+
+  /**
+   * Append a record to the trace, without copying the data.
+   *
+   * @throws std::length_error if @a size does not fit in a record.
+   */
+  void write(
+      trace_record::direction_type direction,
+      boost::system::error_code const & error,
+      trace_record::duration delay,
+      void const * data, std::size_t size) {
+    if (size > std::numeric_limits<std::uint32_t>::max()) {
+      throw std::length_error("Trace record data is too large");
+    }
+    char header[detail::trace_record_header_size];
+    header[0] = static_cast<char>(direction);
+    header[1] = static_cast<char>(
+        detail::trace_category_id(error.category()));
+    detail::trace_encode<std::uint32_t>(&header[2], error.value());
+    detail::trace_encode<std::uint64_t>(&header[6], delay.count());
+    detail::trace_encode<std::uint32_t>(&header[14], size);
+    os_.write(header, sizeof(header));
+    os_.write(static_cast<char const*>(data), size);
+    if (not os_) {
+      throw std::runtime_error("Error writing trace record");
+    }
+    ++records_;
+  }
+
+  /// The number of records written.
+  std::size_t records() const {
+    return records_;
+  }
+
+ private:
+  std::ostream & os_;
+  std::size_t records_;
+};
+
+/**
+ * Read a trace of socket operations from a stream, one record at a
+ * time.
+ *
+ * Only the current record is held in memory, so the size of the
+ * trace is limited only by the storage.
+ */
+class trace_reader {
+ public:
+  /// Read and validate the trace header from @a is.
+  explicit trace_reader(std::istream & is)
+      : is_(is)
+      , records_(0) {
+    char magic[sizeof(detail::trace_magic)];
+    if (not is_.read(magic, sizeof(magic))
+        or not std::equal(magic, magic + sizeof(magic),
+                          detail::trace_magic)) {
+      throw std::runtime_error("Invalid trace header");
+    }
+  }
+
+  /**
+   * Read the next record into @a r, reusing its memory.
+   *
+   * @returns false at the end of the trace.
+   * @throws std::runtime_error if the trace is truncated or invalid.
+   */
+  bool next(trace_record & r) {
+    char header[detail::trace_record_header_size];
+    is_.read(header, sizeof(header));
+    if (is_.gcount() == 0 and is_.eof()) {
+      return false;
+    }
+    if (not is_) {
+      throw std::runtime_error("Truncated trace record header");
+    }
+    if (header[0] != trace_record::read
+        and header[0] != trace_record::write) {
+      throw std::runtime_error("Invalid direction in trace record");
+    }
+    r.direction = static_cast<trace_record::direction_type>(header[0]);
+    r.error.assign(
+        static_cast<int>(detail::trace_decode<std::uint32_t>(&header[2])),
+        detail::trace_category(static_cast<std::uint8_t>(header[1])));
+    r.delay = trace_record::duration(
+        detail::trace_decode<std::uint64_t>(&header[6]));
+    r.data.resize(detail::trace_decode<std::uint32_t>(&header[14]));
+    if (not r.data.empty() and not is_.read(&r.data[0], r.data.size())) {
+      throw std::runtime_error("Truncated trace record data");
+    }
+    ++records_;
+    return true;
+  }
+
+  /// The number of records read.
+  std::size_t records() const {
+    return records_;
+  }
+
+ private:
+  std::istream & is_;
+  std::size_t records_;
+};
+
+} // namespace asio
+} // namespace skye
+
+#endif // skye_asio_trace_hpp
@@ -0,0 +1,288 @@
+#ifndef skye_asio_trace_replayer_hpp
+#define skye_asio_trace_replayer_hpp
+
+#include <skye/asio/socket.hpp>
+#include <skye/asio/trace.hpp>
+#include <skye/asio/virtual_clock.hpp>
+
+#include <boost/asio/io_service.hpp>
+
+#include <algorithm>
+#include <deque>
+#include <sstream>
+#include <string>
+
+namespace skye {
+namespace asio {
+
+/**
+ * Replay a trace against the code under test, through a mock socket.
+ *
+ * Each read record in the trace completes one async_read_some() call,
+ * with the recorded data and error.  If the read buffer is too small
+ * the rest of the record completes the following reads, while the
+ * writes are matched against the records after it.  Each write
+ * record is the data the code under test is expected to write, the
+ * writes are compared against it and complete successfully, unless
+ * the record has an error.  The writes may be split or coalesced
+ * differently than in the recording, only the byte stream matters:
+ *
+ * @code
+ * std::ifstream is("session.trace", std::ios::binary);
+ * skye::asio::trace_reader trace(is);
+ * skye::asio::socket s(io);
+ * skye::asio::trace_replayer replayer(s, trace);
+ * my_protocol p(s);
+ * p.start();
+ * io.run();
+ * BOOST_CHECK_MESSAGE(replayer.mismatches() == 0,
+ *                     replayer.first_mismatch());
+ * @endcode
+ *
+ * The trace order is preserved: a read record is not delivered until
+ * the code under test has written the data of all the write records
+ * before it.  Once the trace is exhausted the reads complete with
+ * boost::asio::error::eof.
+ *
+ * The records are pulled from the reader as they are needed, so the
+ * trace is never loaded in memory.  The recorded delays are ignored,
+ * so the trace replays as fast as possible, unless a virtual_clock is
+ * provided, then the clock advances by each delay as the records are
+ * consumed.
+ *
+ * Like stream_engine the replayer attaches to the socket via capture
+ * hooks, is not thread-safe, and must outlive any pending operation
+ * on the socket.
+ */
+class trace_replayer {
+ public:
+  typedef async_io_capture::value_type operation;
+
+  /// Replay @a trace through @a s.
+  trace_replayer(socket & s, trace_reader & trace)
+      : socket_(s)
+      , io_(s.get_io_service())
+      , trace_(trace)
+      , clock_(nullptr)
+      , current_()
+      , offset_(0)
+      , has_current_(false)
+      , finished_(false)
+      , input_()
+      , input_offset_(0)
+      , input_error_()
+      , input_ready_(false)
+      , pending_reads_()
+      , bytes_read_(0)
+      , bytes_written_(0)
+      , mismatches_(0)
+      , first_mismatch_() {
+    socket_.async_read_some.set_capture_hook(
+        [this](operation const & op) { on_read(op); });
+    socket_.async_write_some.set_capture_hook(
+        [this](operation const & op) { on_write(op); });
+  }
+
+  /// Detach the replayer from the socket.
+  ~trace_replayer() {
+    socket_.async_read_some.set_capture_hook(nullptr);
+    socket_.async_write_some.set_capture_hook(nullptr);
+  }
+
+  trace_replayer(trace_replayer const &) = delete;
+  trace_replayer & operator=(trace_replayer const &) = delete;
+
+  /// Advance @a clock by the recorded delays, null to ignore them.
+  void set_clock(virtual_clock * clock) {
+    clock_ = clock;
+  }
+
+  //@{
+  /**
+   * @name Accessors
+   */
+  /// True once all the records in the trace were fetched.
+  bool finished() const {
+    return finished_;
+  }
+  /// The number of reads waiting for the code under test to write.
+  std::size_t pending_reads() const {
+    return pending_reads_.size();
+  }
+  std::size_t bytes_read() const {
+    return bytes_read_;
+  }
+  std::size_t bytes_written() const {
+    return bytes_written_;
+  }
+  /// The number of writes that did not match the trace.
+  std::size_t mismatches() const {
+    return mismatches_;
+  }
+  /// A description of the first mismatch, empty if there is none.
+  std::string const & first_mismatch() const {
+    return first_mismatch_;
+  }
+  //@}
+
+ private:
+  void on_read(operation const & op) {
+    pending_reads_.push_back(op);
+    complete_reads();
+  }
+
+  void on_write(operation const & op) {
+    std::size_t const size = op->get_buffer_size();
+    std::string data(size, '\0');
+    op->copy_buffer_data(&data[0], size);
+
+    std::size_t matched = 0;
+    bool matches = true;
+    while (matched != size) {
+      if (not fetch() or current_.direction != trace_record::write) {
+        mismatch(
+            matches, "unexpected write", bytes_written_ + matched,
+            data.substr(matched), std::string());
+        break;
+      }
+      if (current_.error and current_.data.empty()) {
+        // ... the recorded write failed, so does this one ...
+        consume(0);
+        bytes_written_ += matched;
+        post(op, current_.error, matched);
+        complete_reads();
+        return;
+      }
+      std::size_t const n =
+          std::min(size - matched, current_.data.size() - offset_);
+      if (data.compare(matched, n, current_.data, offset_, n) != 0) {
+        mismatch(
+            matches, "write mismatch", bytes_written_ + matched,
+            data.substr(matched, n),
+            current_.data.substr(offset_, n));
+      }
+      matched += n;
+      consume(n);
+    }
+    bytes_written_ += size;
+    post(op, boost::system::error_code(), size);
+    complete_reads();
+  }
+
+  /// Complete the pending reads, as long as the trace allows.
+  void complete_reads() {
+    while (not pending_reads_.empty()) {
+      operation & op = pending_reads_.front();
+      if (not input_ready_) {
+        if (not fetch()) {
+          post(std::move(op), boost::asio::error::eof, 0);
+          pending_reads_.pop_front();
+          continue;
+        }
+        if (current_.direction != trace_record::read) {
+          return;
+        }
+        // ... the record is available to the reads, the writes are
+        // matched against the following records ...
+        input_.swap(current_.data);
+        input_offset_ = 0;
+        input_error_ = current_.error;
+        input_ready_ = true;
+        has_current_ = false;
+      }
+      std::size_t const n =
+          std::min(op->get_buffer_size(), input_.size() - input_offset_);
+      op->set_buffer_data(input_.data() + input_offset_, n);
+      input_offset_ += n;
+      bytes_read_ += n;
+      // ... the recorded error is reported with the last bytes of the
+      // record ...
+      boost::system::error_code ec;
+      if (input_offset_ == input_.size()) {
+        ec = input_error_;
+        input_ready_ = false;
+      }
+      post(std::move(op), ec, n);
+      pending_reads_.pop_front();
+    }
+  }
+
+  /**
+   * Make sure there is a current record with data left.
+   *
+   * @returns false if the trace is exhausted.
+   */
+  bool fetch() {
+    if (has_current_) {
+      return true;
+    }
+    if (finished_ or not trace_.next(current_)) {
+      finished_ = true;
+      return false;
+    }
+    offset_ = 0;
+    has_current_ = true;
+    if (clock_ != nullptr) {
+      clock_->advance(current_.delay);
+    }
+    return true;
+  }
+
+  /// Consume @a n bytes of the current record.
+  void consume(std::size_t n) {
+    offset_ += n;
+    if (offset_ >= current_.data.size()) {
+      has_current_ = false;
+    }
+  }
+
+  /// Report a mismatch, at most once per write.
+  void mismatch(
+      bool & matches, char const * what, std::size_t position,
+      std::string const & actual, std::string const & expected) {
+    if (not matches) {
+      return;
+    }
+    matches = false;
+    if (mismatches_++ != 0) {
+      return;
+    }
+    std::ostringstream os;
+    os << what << " at byte " << position
+       << " of the output, in trace record " << trace_.records()
+       << ", expected=<" << expected << ">, actual=<" << actual << ">";
+    first_mismatch_ = os.str();
+  }
+
+  void post(
+      operation completion, boost::system::error_code const & ec,
+      std::size_t n) {
+    io_.post([completion, ec, n]() mutable {
+        completion->call_functor(ec, n);
+      });
+  }
+
+ private:
+  socket & socket_;
+  boost::asio::io_service & io_;
+  trace_reader & trace_;
+  virtual_clock * clock_;
+  trace_record current_;
+  std::size_t offset_;
+  bool has_current_;
+  bool finished_;
+  std::string input_;
+  std::size_t input_offset_;
+  boost::system::error_code input_error_;
+  bool input_ready_;
+  std::deque<operation> pending_reads_;
+  std::size_t bytes_read_;
+  std::size_t bytes_written_;
+  std::size_t mismatches_;
+  std::string first_mismatch_;
+};
+
+} // namespace asio
+} // namespace skye
+
+#endif // skye_asio_trace_replayer_hpp
@@ -2,6 +2,8 @@
 #include <boost/test/unit_test.hpp>
 #include <boost/asio/streambuf.hpp>
 
+#include <cstring>
+
 
 // We normally do not write test code for test code, but these mock
 // classes are complicated, and we want them to at least compile
@@ -75,3 +77,216 @@ BOOST_AUTO_TEST_CASE( async_read_member_function_with_calls ) {
   BOOST_CHECK_EQUAL(std::string(raw), std::string(msg));
 }
 
+
+/**
+ * @test Verify that all the pending operations can be completed.
+ */
+BOOST_AUTO_TEST_CASE( async_read_member_function_complete_all ) {
+  char raw[16];
+  async_read_member_function amf;
+  std::vector<int> completed;
+  for (int i = 0; i != 100; ++i) {
+    amf(boost::asio::buffer(raw),
+        [i,&completed](boost::system::error_code const &, std::size_t) {
+          completed.push_back(i);
+        });
+  }
+  BOOST_CHECK_EQUAL(amf.pending(), 100);
+
+  BOOST_CHECK_EQUAL(amf.complete_all(boost::system::error_code(), 0), 100);
+  BOOST_CHECK_EQUAL(amf.pending(), 0);
+  BOOST_REQUIRE_EQUAL(completed.size(), 100);
+  for (int i = 0; i != 100; ++i) {
+    BOOST_CHECK_EQUAL(completed[i], i);
+  }
+
+  // ... nothing is completed twice ...
+  BOOST_CHECK_EQUAL(amf.complete_all(boost::system::error_code(), 0), 0);
+  BOOST_CHECK_EQUAL(completed.size(), 100);
+  amf.check_called().exactly( 100 );
+}
+
+/**
+ * @test Verify that operations started by the handlers stay pending.
+ */
+BOOST_AUTO_TEST_CASE( async_read_member_function_complete_reissue ) {
+  char raw[16];
+  async_read_member_function amf;
+  int count = 0;
+  std::function<void(boost::system::error_code const &, std::size_t)> h;
+  h = [&](boost::system::error_code const &, std::size_t) {
+    ++count;
+    amf(boost::asio::buffer(raw), h);
+  };
+  amf(boost::asio::buffer(raw), h);
+  BOOST_CHECK_EQUAL(amf.complete_all(boost::system::error_code(), 1), 1);
+  BOOST_CHECK_EQUAL(amf.pending(), 1);
+  BOOST_CHECK(amf.complete_next(boost::system::error_code(), 1));
+  BOOST_CHECK_EQUAL(count, 2);
+  BOOST_CHECK_EQUAL(amf.pending(), 1);
+  amf.clear_pending();
+  BOOST_CHECK(not amf.complete_next(boost::system::error_code(), 1));
+}
+
+/**
+ * @test Verify that operations completed through the captures are no
+ * longer pending, and that clear() forgets the pending operations.
+ */
+BOOST_AUTO_TEST_CASE( async_read_member_function_complete_capture ) {
+  char raw[16];
+  async_read_member_function amf;
+  int count = 0;
+  auto h = [&count](boost::system::error_code const &, std::size_t) {
+    ++count;
+  };
+  amf(boost::asio::buffer(raw), h);
+  amf(boost::asio::buffer(raw), h);
+  amf.at(0)->call_functor(boost::system::error_code(), 0);
+  BOOST_CHECK_EQUAL(count, 1);
+  BOOST_CHECK_EQUAL(amf.pending(), 1);
+  BOOST_CHECK_EQUAL(amf.complete_all(boost::system::error_code(), 0), 1);
+  BOOST_CHECK_EQUAL(count, 2);
+  BOOST_CHECK(amf.at(1)->completed());
+
+  amf.set_snapshot_buffers(true);
+  amf(boost::asio::buffer(raw), h);
+  BOOST_CHECK_EQUAL(amf.pending(), 1);
+  BOOST_CHECK_EQUAL(amf.snapshot_count(), 1);
+  amf.clear_captures();
+  BOOST_CHECK_EQUAL(amf.pending(), 0);
+  BOOST_CHECK_EQUAL(amf.snapshot_count(), 0);
+  BOOST_CHECK(not amf.complete_next(boost::system::error_code(), 0));
+  BOOST_CHECK_EQUAL(count, 2);
+}
+
+/**
+ * @test Verify that copies of a capture share the handler, and
+ * completing a copy completes the operation.
+ */
+BOOST_AUTO_TEST_CASE( async_read_member_function_complete_copy ) {
+  char raw[16];
+  async_read_member_function amf;
+  int count = 0;
+  amf(boost::asio::buffer(raw),
+      [&count](boost::system::error_code const &, std::size_t) {
+        ++count;
+      });
+  auto op = amf.at(0);
+  BOOST_CHECK(not op->completed());
+  op->call_functor(boost::system::error_code(), 1);
+  BOOST_CHECK_EQUAL(count, 1);
+  BOOST_CHECK(op->completed());
+  BOOST_CHECK(amf.at(0)->completed());
+  BOOST_CHECK_EQUAL(amf.complete_all(boost::system::error_code(), 2), 0);
+  BOOST_CHECK_EQUAL(count, 1);
+}
+
+/**
+ * @test Verify that the pending operations account for the operations
+ * completed through copies of the captures.
+ */
+BOOST_AUTO_TEST_CASE( async_read_member_function_pending_copy ) {
+  char raw[16];
+  async_read_member_function amf;
+  int count = 0;
+  auto h = [&count](boost::system::error_code const &, std::size_t) {
+    ++count;
+  };
+  for (int i = 0; i != 3; ++i) {
+    amf(boost::asio::buffer(raw, i + 1), h);
+  }
+  BOOST_CHECK_EQUAL(amf.pending(), 3);
+  auto op = amf.at(0);
+  op->call_functor(boost::system::error_code(), 0);
+  BOOST_CHECK_EQUAL(amf.pending(), 2);
+  BOOST_CHECK_EQUAL(amf.next_pending()->get_buffer_size(), 2);
+
+  auto last = amf.at(2);
+  amf.clear_pending();
+  BOOST_CHECK_EQUAL(amf.pending(), 0);
+  last->call_functor(boost::system::error_code(), 0);
+  BOOST_CHECK_EQUAL(amf.pending(), 0);
+  BOOST_CHECK_EQUAL(count, 2);
+}
+
+/**
+ * @test Verify that pending operations can be completed selectively.
+ */
+BOOST_AUTO_TEST_CASE( async_write_member_function_complete_if ) {
+  char const a[] = "aaaa";
+  char const b[] = "bb";
+  async_write_member_function amf;
+  std::size_t total = 0;
+  auto h = [&total](boost::system::error_code const &, std::size_t n) {
+    total += n;
+  };
+  for (int i = 0; i != 10; ++i) {
+    amf(boost::asio::buffer(a, 4), h);
+    amf(boost::asio::buffer(b, 2), h);
+  }
+  std::size_t n = amf.complete_if(
+      [](async_write_member_function::value_type const & op) {
+        return op->get_buffer_size() == 2;
+      }, boost::system::error_code(), 2);
+  BOOST_CHECK_EQUAL(n, 10);
+  BOOST_CHECK_EQUAL(total, 20);
+  BOOST_CHECK_EQUAL(amf.pending(), 10);
+  BOOST_CHECK_EQUAL(amf.next_pending()->get_buffer_size(), 4);
+
+  n = amf.complete_in_order_of_issue(3, boost::system::error_code(), 4);
+  BOOST_CHECK_EQUAL(n, 3);
+  BOOST_CHECK_EQUAL(total, 32);
+  BOOST_CHECK_EQUAL(amf.pending(), 7);
+}
+
+/**
+ * @test Verify that the written data can be snapshot.
+ */
+BOOST_AUTO_TEST_CASE( async_write_member_function_snapshot ) {
+  async_write_member_function amf;
+  auto h = [](boost::system::error_code const &, std::size_t) {};
+
+  char buf[8];
+  std::strcpy(buf, "abc");
+  amf(boost::asio::buffer(buf, 3), h);
+  BOOST_CHECK_EQUAL(amf.snapshot_count(), 0);
+
+  amf.set_snapshot_buffers(true);
+  amf(boost::asio::buffer(buf, 3), h);
+  // ... reuse the buffer, the snapshot retains the old contents ...
+  std::strcpy(buf, "defgh");
+  amf(boost::asio::buffer(buf, 5), h);
+  amf(boost::asio::const_buffers_1(nullptr, 0), h);
+
+  BOOST_REQUIRE_EQUAL(amf.snapshot_count(), 3);
+  auto s0 = amf.snapshot(0);
+  BOOST_CHECK_EQUAL(
+      std::string(boost::asio::buffer_cast<char const*>(s0),
+                  boost::asio::buffer_size(s0)), "abc");
+  BOOST_CHECK_EQUAL(boost::asio::buffer_size(amf.snapshot(1)), 5);
+  BOOST_CHECK_EQUAL(boost::asio::buffer_size(amf.snapshot(2)), 0);
+
+  auto t = amf.transcript();
+  BOOST_CHECK_EQUAL(
+      std::string(boost::asio::buffer_cast<char const*>(t),
+                  boost::asio::buffer_size(t)), "abcdefgh");
+
+  amf.clear_snapshots();
+  BOOST_CHECK_EQUAL(amf.snapshot_count(), 0);
+  BOOST_CHECK_EQUAL(boost::asio::buffer_size(amf.transcript()), 0);
+  amf.check_called().exactly( 4 );
+}
+
+/**
+ * @test Verify that calls without buffers do not record a snapshot.
+ */
+BOOST_AUTO_TEST_CASE( async_member_function_snapshot_not_buffer ) {
+  async_member_function<
+    detail::async_function_argument_capture<void(int)>> amf;
+  auto h = [](int) {};
+  amf.set_snapshot_buffers(true);
+  BOOST_CHECK_THROW(amf(42, h), std::runtime_error);
+  BOOST_CHECK_EQUAL(amf.snapshot_count(), 0);
+  BOOST_CHECK_EQUAL(boost::asio::buffer_size(amf.transcript()), 0);
+  amf.check_called().never();
+}
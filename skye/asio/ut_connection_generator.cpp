@@ -0,0 +1,163 @@
+#include <skye/asio/connection_generator.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <boost/asio/buffer.hpp>
+
+#include <array>
+#include <deque>
+
+using skye::asio::connection_generator;
+using skye::asio::connection_schedule;
+using skye::asio::stream_engine;
+
+namespace {
+/// A trivial server, accepts connections and reads until EOF.
+class server {
+ public:
+  server(skye::asio::acceptor & a, std::size_t max_connections)
+      : acceptor_(a)
+      , max_connections_(max_connections)
+      , sockets_()
+      , buffers_()
+      , bytes_(0)
+      , closed_(0)
+  {}
+
+  void accept() {
+    sockets_.emplace_back(acceptor_.get_io_service());
+    buffers_.emplace_back();
+    std::size_t const i = sockets_.size() - 1;
+    acceptor_.async_accept(
+        sockets_.back(), [this, i](boost::system::error_code const & ec) {
+          if (ec) {
+            return;
+          }
+          read(i);
+          if (sockets_.size() < max_connections_) {
+            accept();
+          }
+        });
+  }
+
+  std::size_t bytes() const {
+    return bytes_;
+  }
+  std::size_t closed() const {
+    return closed_;
+  }
+
+ private:
+  void read(std::size_t i) {
+    sockets_[i].async_read_some(
+        boost::asio::buffer(buffers_[i]),
+        [this, i](boost::system::error_code const & ec, std::size_t n) {
+          bytes_ += n;
+          if (ec) {
+            ++closed_;
+            return;
+          }
+          read(i);
+        });
+  }
+
+ private:
+  skye::asio::acceptor & acceptor_;
+  std::size_t max_connections_;
+  std::deque<skye::asio::socket> sockets_;
+  std::deque<std::array<char, 16>> buffers_;
+  std::size_t bytes_;
+  std::size_t closed_;
+};
+
+void hello_script(std::size_t, stream_engine & engine) {
+  engine.feed(std::string("hello"));
+  engine.close_input();
+}
+} // anonymous namespace
+
+/**
+ * @test Verify that connections arrive at the configured rate, in
+ * virtual time.
+ */
+BOOST_AUTO_TEST_CASE( connection_generator_virtual_time ) {
+  boost::asio::io_service io;
+  skye::asio::acceptor a(io);
+  connection_schedule schedule;
+  schedule.connections = 5000;
+  schedule.rate = 10000;
+  // ... the sockets must outlive the generator ...
+  server s(a, schedule.connections);
+  connection_generator generator(a, schedule);
+  generator.set_script(hello_script);
+
+  s.accept();
+  BOOST_CHECK_EQUAL(generator.pending_accepts(), 1);
+  generator.start();
+  skye::asio::virtual_clock::get(io).run();
+
+  BOOST_CHECK(generator.finished());
+  BOOST_CHECK_EQUAL(generator.accepted(), schedule.connections);
+  BOOST_CHECK_EQUAL(s.bytes(), 5 * schedule.connections);
+  BOOST_CHECK_EQUAL(s.closed(), schedule.connections);
+  // ... the server keeps up, the last connection arrives 0.4999s after
+  // the first one ...
+  BOOST_CHECK_EQUAL(generator.max_backlog(), 0);
+  BOOST_CHECK(generator.elapsed() > std::chrono::milliseconds(499));
+  BOOST_CHECK(generator.elapsed() < std::chrono::milliseconds(501));
+  BOOST_CHECK_CLOSE(generator.accept_rate(), 10000, 1.0);
+  BOOST_CHECK(generator.mean_setup_cost().count() > 0);
+  BOOST_CHECK(generator.max_setup_cost() >= generator.mean_setup_cost());
+  BOOST_CHECK_EQUAL(generator.engine(0).bytes_read(), 5);
+}
+
+/**
+ * @test Verify that a burst of connections waits in the backlog.
+ */
+BOOST_AUTO_TEST_CASE( connection_generator_burst ) {
+  boost::asio::io_service io;
+  skye::asio::acceptor a(io);
+  connection_schedule schedule;
+  schedule.connections = 1000;
+  server s(a, schedule.connections);
+  connection_generator generator(a, schedule);
+  generator.set_script(hello_script);
+
+  generator.start();
+  BOOST_CHECK_EQUAL(generator.arrived(), schedule.connections);
+  BOOST_CHECK_EQUAL(generator.backlog(), schedule.connections);
+  BOOST_CHECK_EQUAL(generator.accepted(), 0);
+
+  s.accept();
+  io.run();
+  BOOST_CHECK(generator.finished());
+  BOOST_CHECK_EQUAL(generator.backlog(), 0);
+  BOOST_CHECK_EQUAL(generator.max_backlog(), schedule.connections);
+  BOOST_CHECK_EQUAL(s.closed(), schedule.connections);
+}
+
+/**
+ * @test Verify that connections can arrive in real time.
+ */
+BOOST_AUTO_TEST_CASE( connection_generator_real_time ) {
+  boost::asio::io_service io;
+  skye::asio::acceptor a(io);
+  connection_schedule schedule;
+  schedule.connections = 20;
+  schedule.rate = 2000;
+  schedule.real_time = true;
+  server s(a, schedule.connections);
+  connection_generator generator(a, schedule);
+
+  s.accept();
+  auto const start = std::chrono::steady_clock::now();
+  generator.start();
+  io.run();
+  BOOST_CHECK(generator.finished());
+  BOOST_CHECK(
+      std::chrono::steady_clock::now() - start
+      >= std::chrono::microseconds(9500));
+  BOOST_CHECK(generator.elapsed() >= std::chrono::microseconds(9500));
+  BOOST_CHECK_GT(generator.accept_rate(), 0);
+  // ... no script, the connections remain open ...
+  BOOST_CHECK_EQUAL(s.closed(), 0);
+}
@@ -0,0 +1,145 @@
+#include <skye/asio/stream_engine.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <boost/asio/buffer.hpp>
+
+using skye::asio::fault_injector;
+using skye::asio::fault_policy;
+using skye::asio::stream_engine;
+
+/**
+ * @test Verify that the default policy injects no faults.
+ */
+BOOST_AUTO_TEST_CASE( fault_injector_default ) {
+  fault_injector injector{fault_policy()};
+  boost::system::error_code ec;
+  for (int i = 0; i != 1000; ++i) {
+    BOOST_CHECK(not injector.read_error(ec));
+    BOOST_CHECK(not injector.write_error(ec));
+    BOOST_CHECK_EQUAL(injector.read_size(100), 100);
+    BOOST_CHECK_EQUAL(injector.write_size(100), 100);
+  }
+  BOOST_CHECK_EQUAL(injector.injected_errors(), 0);
+  BOOST_CHECK_EQUAL(injector.short_reads(), 0);
+}
+
+/**
+ * @test Verify that the decisions depend only on the seed.
+ */
+BOOST_AUTO_TEST_CASE( fault_injector_deterministic ) {
+  fault_policy policy;
+  policy.seed = 42;
+  policy.split_reads = true;
+  policy.max_write_size = 10;
+  policy.read_error_rate = 0.25;
+  policy.errors.push_back(boost::asio::error::would_block);
+
+  fault_injector a(policy);
+  fault_injector b(policy);
+  boost::system::error_code ea, eb;
+  for (int i = 0; i != 1000; ++i) {
+    bool const fa = a.read_error(ea);
+    BOOST_CHECK_EQUAL(fa, b.read_error(eb));
+    BOOST_CHECK_EQUAL(ea, eb);
+    std::size_t const n = a.read_size(100);
+    BOOST_CHECK_EQUAL(n, b.read_size(100));
+    BOOST_CHECK(1 <= n and n <= 100);
+    BOOST_CHECK_EQUAL(a.write_size(100), 10);
+  }
+  // ... with 1000 samples the rate is roughly respected ...
+  BOOST_CHECK_GT(a.injected_errors(), 150);
+  BOOST_CHECK_LT(a.injected_errors(), 350);
+}
+
+/**
+ * @test Verify that a read loop reassembles the stream under
+ * random short reads and errors, for many seeds.
+ */
+BOOST_AUTO_TEST_CASE( stream_engine_random_reads ) {
+  std::string data(10000, ' ');
+  for (std::size_t i = 0; i != data.size(); ++i) {
+    data[i] = char('a' + i % 26);
+  }
+
+  for (std::uint32_t seed = 0; seed != 100; ++seed) {
+    boost::asio::io_service io;
+    skye::asio::socket s(io);
+    stream_engine engine(s);
+    fault_policy policy;
+    policy.seed = seed;
+    policy.split_reads = true;
+    policy.max_read_size = 512;
+    policy.read_error_rate = 0.1;
+    policy.errors.assign(1, boost::asio::error::try_again);
+    engine.set_fault_policy(policy);
+    engine.feed(data);
+    engine.close_input();
+
+    std::string received;
+    int errors = 0;
+    char buf[1024];
+    std::function<void(boost::system::error_code const &, std::size_t)> h;
+    h = [&](boost::system::error_code const & ec, std::size_t n) {
+      received.append(buf, n);
+      if (ec == boost::asio::error::try_again) {
+        ++errors;
+      } else if (ec) {
+        return;
+      }
+      s.async_read_some(boost::asio::buffer(buf), h);
+    };
+    s.async_read_some(boost::asio::buffer(buf), h);
+    io.run();
+    BOOST_CHECK(received == data);
+    BOOST_CHECK_EQUAL(
+        std::size_t(errors), engine.faults()->injected_errors());
+    BOOST_CHECK_GT(engine.faults()->short_reads(), 0);
+  }
+}
+
+/**
+ * @test Verify that short writes and write errors are injected.
+ */
+BOOST_AUTO_TEST_CASE( stream_engine_short_writes ) {
+  boost::asio::io_service io;
+  skye::asio::socket s(io);
+  stream_engine engine(s);
+  fault_policy policy;
+  policy.seed = 7;
+  policy.short_writes = true;
+  policy.max_write_size = 100;
+  engine.set_fault_policy(policy);
+
+  std::string const data(1000, 'x');
+  std::size_t written = 0;
+  std::function<void(boost::system::error_code const &, std::size_t)> h;
+  h = [&](boost::system::error_code const & ec, std::size_t n) {
+    BOOST_REQUIRE(not ec);
+    written += n;
+    if (written < data.size()) {
+      s.async_write_some(
+          boost::asio::buffer(&data[written], data.size() - written), h);
+    }
+  };
+  s.async_write_some(boost::asio::buffer(data), h);
+  io.run();
+  io.reset();
+  BOOST_CHECK_EQUAL(written, data.size());
+  BOOST_CHECK(engine.output() == data);
+  BOOST_CHECK_GE(s.async_write_some.call_count(), 10);
+
+  policy.write_error_rate = 1.0;
+  engine.set_fault_policy(policy);
+  boost::system::error_code result;
+  s.async_write_some(
+      boost::asio::buffer(data),
+      [&result](boost::system::error_code const & ec, std::size_t) {
+        result = ec;
+      });
+  io.run();
+  BOOST_CHECK_EQUAL(result, boost::asio::error::connection_reset);
+  BOOST_CHECK_EQUAL(engine.output().size(), data.size());
+
+  engine.clear_fault_policy();
+  BOOST_CHECK(engine.faults() == nullptr);
+}
@@ -0,0 +1,183 @@
+#include <skye/asio/io_service_context.hpp>
+#include <skye/asio/stream_engine.hpp>
+#include <skye/asio/virtual_clock.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <boost/asio/buffer.hpp>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+using skye::asio::io_service_context;
+
+/**
+ * @test Verify that each thread has its own default io_service.
+ */
+BOOST_AUTO_TEST_CASE( io_service_context_per_thread ) {
+  boost::asio::io_service * main_io =
+      &skye::asio::service::io_service_for_testing();
+  BOOST_CHECK_EQUAL(main_io, &skye::asio::service::io_service_for_testing());
+
+  boost::asio::io_service * thread_io = nullptr;
+  std::thread t([&thread_io]() {
+      thread_io = &skye::asio::service::io_service_for_testing();
+    });
+  t.join();
+  BOOST_CHECK(thread_io != nullptr);
+  BOOST_CHECK(thread_io != main_io);
+
+  skye::asio::socket s;
+  BOOST_CHECK_EQUAL(&s.get_io_service(), main_io);
+}
+
+/**
+ * @test Verify that contexts nest, and the mocks use the innermost
+ * one.
+ */
+BOOST_AUTO_TEST_CASE( io_service_context_nested ) {
+  boost::asio::io_service * outer =
+      &skye::asio::service::io_service_for_testing();
+  {
+    io_service_context context;
+    BOOST_CHECK(&context.get() != outer);
+    skye::asio::socket s;
+    BOOST_CHECK_EQUAL(&s.get_io_service(), &context.get());
+    BOOST_CHECK_EQUAL(
+        &skye::asio::service::io_service_for_testing(), &context.get());
+  }
+  BOOST_CHECK_EQUAL(&skye::asio::service::io_service_for_testing(), outer);
+}
+
+/**
+ * @test Verify that only the io_service objects that ran out of work
+ * are recycled.
+ */
+BOOST_AUTO_TEST_CASE( io_service_context_recycle ) {
+  boost::asio::io_service * drained = nullptr;
+  {
+    io_service_context context;
+    drained = &context.get();
+    int count = 0;
+    context.get().post([&count]() { ++count; });
+    context.get().run();
+    BOOST_CHECK_EQUAL(count, 1);
+  }
+  BOOST_CHECK_GE(io_service_context::pool::available(), 1);
+  {
+    io_service_context context;
+    BOOST_CHECK_EQUAL(&context.get(), drained);
+    BOOST_CHECK(not context.get().stopped());
+
+    int called = 0;
+    context.get().post([&called]() { ++called; });
+    context.reset();
+    // ... the queued handler runs when the io_service is released ...
+    BOOST_CHECK_EQUAL(called, 1);
+    context.get().run();
+    BOOST_CHECK_EQUAL(called, 1);
+  }
+}
+
+/**
+ * @test Verify that io_service objects are recycled even if they
+ * never ran, for example in tests that only use the mocks.
+ */
+BOOST_AUTO_TEST_CASE( io_service_context_recycle_never_run ) {
+  boost::asio::io_service * recycled = nullptr;
+  int count = 0;
+  {
+    io_service_context context;
+    recycled = &context.get();
+    skye::asio::socket s;
+    char buf[4];
+    s.async_read_some(
+        boost::asio::buffer(buf),
+        [&count](boost::system::error_code const &, std::size_t) {
+          ++count;
+        });
+  }
+  // ... recycle the same io_service a second time, still without
+  // calling run() ...
+  for (int i = 0; i != 2; ++i) {
+    io_service_context context;
+    BOOST_CHECK_EQUAL(&context.get(), recycled);
+    BOOST_CHECK(not context.get().stopped());
+  }
+  BOOST_CHECK_EQUAL(count, 0);
+}
+
+/**
+ * @test Verify that handlers queued in a stopped io_service do not run
+ * in the next context.
+ */
+BOOST_AUTO_TEST_CASE( io_service_context_recycle_stopped ) {
+  int count = 0;
+  {
+    io_service_context context;
+    context.get().post([&count]() { ++count; });
+    context.get().stop();
+    BOOST_CHECK(context.get().stopped());
+  }
+  // ... the handler runs when the io_service is released ...
+  BOOST_CHECK_EQUAL(count, 1);
+  {
+    io_service_context context;
+    context.get().run();
+    BOOST_CHECK_EQUAL(count, 1);
+  }
+}
+
+/**
+ * @test Verify that a recycled io_service does not keep the virtual
+ * clock of the previous context.
+ */
+BOOST_AUTO_TEST_CASE( io_service_context_recycle_clock ) {
+  typedef skye::asio::virtual_clock virtual_clock;
+  boost::asio::io_service * recycled = nullptr;
+  {
+    io_service_context context;
+    recycled = &context.get();
+    virtual_clock::get(context.get()).advance(std::chrono::hours(1));
+    context.get().run();
+  }
+  io_service_context context;
+  BOOST_CHECK_EQUAL(&context.get(), recycled);
+  BOOST_CHECK(
+      virtual_clock::get(context.get()).now() == virtual_clock::time_point());
+}
+
+/**
+ * @test Verify that test cases can run in parallel threads.
+ */
+BOOST_AUTO_TEST_CASE( io_service_context_parallel ) {
+  int const thread_count = 8;
+  int const iterations = 100;
+  std::atomic<int> failures(0);
+  std::vector<std::thread> threads;
+  for (int t = 0; t != thread_count; ++t) {
+    threads.emplace_back([&failures]() {
+        for (int i = 0; i != iterations; ++i) {
+          io_service_context context;
+          skye::asio::socket s;
+          skye::asio::stream_engine engine(s);
+          engine.feed(std::string("ping"));
+          char buf[4];
+          std::size_t received = 0;
+          s.async_read_some(
+              boost::asio::buffer(buf),
+              [&received](boost::system::error_code const &, std::size_t n) {
+                received = n;
+              });
+          context.get().run();
+          if (received != 4 or std::string(buf, 4) != "ping") {
+            ++failures;
+          }
+        }
+      });
+  }
+  for (auto & t : threads) {
+    t.join();
+  }
+  BOOST_CHECK_EQUAL(failures.load(), 0);
+}
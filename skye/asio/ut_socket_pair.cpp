@@ -0,0 +1,165 @@
+#include <skye/asio/socket_pair.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <boost/asio/buffer.hpp>
+
+using skye::asio::loopback;
+using skye::asio::socket_pair;
+
+namespace {
+typedef std::function<
+  void(boost::system::error_code const &, std::size_t)> io_handler;
+
+/// A trivial server, echoes everything it reads.
+struct echo_session {
+  explicit echo_session(skye::asio::socket & s)
+      : sock(s)
+      , buf()
+      , bytes(0)
+  {}
+
+  void start() {
+    sock.async_read_some(
+        boost::asio::buffer(buf),
+        [this](boost::system::error_code const & ec, std::size_t n) {
+          if (ec) {
+            return;
+          }
+          bytes += n;
+          sock.async_write_some(
+              boost::asio::buffer(buf, n),
+              [this](boost::system::error_code const & ec, std::size_t) {
+                if (not ec) {
+                  start();
+                }
+              });
+        });
+  }
+
+  skye::asio::socket & sock;
+  char buf[64];
+  std::size_t bytes;
+};
+} // anonymous namespace
+
+/**
+ * @test Verify that the data written on one end is read on the other.
+ */
+BOOST_AUTO_TEST_CASE( socket_pair_echo ) {
+  boost::asio::io_service io;
+  socket_pair p(io);
+  BOOST_CHECK(p.client_engine().connected());
+
+  echo_session server(p.server());
+  server.start();
+
+  std::string const msg("ping\n");
+  char reply[16];
+  std::size_t received = 0;
+  p.client().async_write_some(
+      boost::asio::buffer(msg),
+      [](boost::system::error_code const &, std::size_t) {});
+  p.client().async_read_some(
+      boost::asio::buffer(reply),
+      [&received](boost::system::error_code const & ec, std::size_t n) {
+        received = n;
+      });
+  io.run();
+  BOOST_CHECK_EQUAL(received, msg.size());
+  BOOST_CHECK_EQUAL(std::string(reply, received), msg);
+  BOOST_CHECK_EQUAL(server.bytes, msg.size());
+  BOOST_CHECK_EQUAL(p.client_engine().bytes_written(), msg.size());
+  BOOST_CHECK_EQUAL(p.server_engine().bytes_read(), msg.size());
+  // ... the connected engines do not record the data ...
+  BOOST_CHECK_EQUAL(p.client_engine().output(), "");
+}
+
+/**
+ * @test Verify that shutting down one end closes the other.
+ */
+BOOST_AUTO_TEST_CASE( socket_pair_shutdown ) {
+  boost::asio::io_service io;
+  socket_pair p(io);
+
+  char buf[16];
+  boost::system::error_code result;
+  p.server().async_read_some(
+      boost::asio::buffer(buf),
+      [&result](boost::system::error_code const & ec, std::size_t) {
+        result = ec;
+      });
+  p.client_engine().shutdown_output();
+  io.run();
+  BOOST_CHECK_EQUAL(result, boost::asio::error::eof);
+}
+
+/**
+ * @test Verify that client sockets are connected to the acceptor.
+ */
+BOOST_AUTO_TEST_CASE( loopback_accept ) {
+  boost::asio::io_service io;
+  skye::asio::acceptor a(io);
+  loopback network(a);
+
+  int const count = 100;
+  std::vector<std::unique_ptr<skye::asio::socket>> clients;
+  std::vector<std::unique_ptr<skye::asio::socket>> servers;
+  std::vector<std::unique_ptr<echo_session>> sessions;
+  for (int i = 0; i != count; ++i) {
+    clients.emplace_back(new skye::asio::socket(io));
+  }
+
+  // ... the first half of the clients connect and write before the
+  // server accepts any connection ...
+  std::string const msg("hello");
+  for (int i = 0; i != count / 2; ++i) {
+    network.connect(*clients[i]);
+    clients[i]->async_write_some(
+        boost::asio::buffer(msg),
+        [](boost::system::error_code const &, std::size_t) {});
+  }
+  BOOST_CHECK_EQUAL(network.pending_connects(), count / 2);
+
+  std::function<void()> accept_next = [&]() {
+    servers.emplace_back(new skye::asio::socket(io));
+    auto & s = *servers.back();
+    a.async_accept(s, [&](boost::system::error_code const & ec) {
+        if (ec) {
+          return;
+        }
+        sessions.emplace_back(new echo_session(s));
+        sessions.back()->start();
+        if (int(servers.size()) < count) {
+          accept_next();
+        }
+      });
+  };
+  accept_next();
+  io.run();
+  io.reset();
+  BOOST_CHECK_EQUAL(network.pending_connects(), 0);
+  BOOST_CHECK_EQUAL(network.pending_accepts(), 1);
+
+  for (int i = count / 2; i != count; ++i) {
+    network.connect(*clients[i]);
+    clients[i]->async_write_some(
+        boost::asio::buffer(msg),
+        [](boost::system::error_code const &, std::size_t) {});
+    io.run();
+    io.reset();
+  }
+  BOOST_CHECK_EQUAL(network.connections(), count);
+  BOOST_CHECK_EQUAL(sessions.size(), count);
+  for (int i = 0; i != count; ++i) {
+    BOOST_REQUIRE(network.server_engine(i) != nullptr);
+    BOOST_CHECK_EQUAL(network.server_engine(i)->bytes_read(), msg.size());
+    // ... the echo is waiting in the client engine ...
+    BOOST_CHECK_EQUAL(network.client_engine(i).available(), msg.size());
+  }
+  a.async_accept.check_called().exactly( count );
+  // ... the loopback completes the recorded captures ...
+  for (int i = 0; i != count; ++i) {
+    BOOST_CHECK(a.async_accept.at(i)->completed());
+  }
+  BOOST_CHECK_EQUAL(a.async_accept.pending(), 0);
+}
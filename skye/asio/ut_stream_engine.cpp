@@ -0,0 +1,211 @@
+#include <skye/asio/stream_engine.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <boost/asio/buffer.hpp>
+
+using skye::asio::stream_engine;
+
+namespace {
+/// Record the results of a completion handler.
+struct result {
+  result()
+      : called(0)
+      , ec()
+      , bytes(0)
+  {}
+
+  int called;
+  boost::system::error_code ec;
+  std::size_t bytes;
+};
+
+/// Create a handler that records its results in @a r.
+std::function<void(boost::system::error_code const &, std::size_t)>
+record(result & r) {
+  return [&r](boost::system::error_code const & ec, std::size_t n) {
+    ++r.called;
+    r.ec = ec;
+    r.bytes = n;
+  };
+}
+} // anonymous namespace
+
+/**
+ * @test Verify that reads consume the data fed to the engine.
+ */
+BOOST_AUTO_TEST_CASE( stream_engine_read ) {
+  boost::asio::io_service io;
+  skye::asio::socket s(io);
+  stream_engine engine(s);
+
+  engine.feed(std::string("HELLO WORLD\n"));
+  BOOST_CHECK_EQUAL(engine.available(), 12);
+
+  char buf[6];
+  result r;
+  s.async_read_some(boost::asio::buffer(buf), record(r));
+  // ... the handler runs only when the io_service runs ...
+  BOOST_CHECK_EQUAL(r.called, 0);
+  io.run();
+  BOOST_CHECK_EQUAL(r.called, 1);
+  BOOST_CHECK(not r.ec);
+  BOOST_CHECK_EQUAL(r.bytes, 6);
+  BOOST_CHECK_EQUAL(std::string(buf, 6), "HELLO ");
+  BOOST_CHECK_EQUAL(engine.available(), 6);
+  BOOST_CHECK_EQUAL(engine.bytes_read(), 6);
+
+  s.async_read_some.check_called().once();
+}
+
+/**
+ * @test Verify that reads wait for data, and complete with eof once
+ * the input is closed.
+ */
+BOOST_AUTO_TEST_CASE( stream_engine_pending_read ) {
+  boost::asio::io_service io;
+  skye::asio::socket s(io);
+  stream_engine engine(s);
+
+  char buf[16];
+  result r;
+  s.async_read_some(boost::asio::buffer(buf), record(r));
+  io.run();
+  io.reset();
+  BOOST_CHECK_EQUAL(r.called, 0);
+  BOOST_CHECK_EQUAL(engine.pending_reads(), 1);
+
+  engine.feed("abc", 3);
+  BOOST_CHECK_EQUAL(engine.pending_reads(), 0);
+  io.run();
+  io.reset();
+  BOOST_CHECK_EQUAL(r.called, 1);
+  BOOST_CHECK_EQUAL(r.bytes, 3);
+  BOOST_CHECK_EQUAL(std::string(buf, 3), "abc");
+
+  s.async_read_some(boost::asio::buffer(buf), record(r));
+  engine.close_input();
+  io.run();
+  BOOST_CHECK_EQUAL(r.called, 2);
+  BOOST_CHECK_EQUAL(r.ec, boost::asio::error::eof);
+  BOOST_CHECK_EQUAL(r.bytes, 0);
+}
+
+/**
+ * @test Verify that empty reads complete immediately.
+ */
+BOOST_AUTO_TEST_CASE( stream_engine_empty_read ) {
+  boost::asio::io_service io;
+  skye::asio::socket s(io);
+  stream_engine engine(s);
+
+  result r;
+  s.async_read_some(boost::asio::mutable_buffers_1(nullptr, 0), record(r));
+  io.run();
+  BOOST_CHECK_EQUAL(r.called, 1);
+  BOOST_CHECK(not r.ec);
+  BOOST_CHECK_EQUAL(r.bytes, 0);
+}
+
+/**
+ * @test Verify that writes are collected by the engine.
+ */
+BOOST_AUTO_TEST_CASE( stream_engine_write ) {
+  boost::asio::io_service io;
+  skye::asio::socket s(io);
+  stream_engine engine(s);
+
+  result r;
+  std::string const msg("GET / HTTP/1.0\r\n");
+  s.async_write_some(boost::asio::buffer(msg), record(r));
+  s.async_write_some(boost::asio::buffer(msg), record(r));
+  io.run();
+  BOOST_CHECK_EQUAL(r.called, 2);
+  BOOST_CHECK_EQUAL(r.bytes, msg.size());
+  BOOST_CHECK_EQUAL(engine.output(), msg + msg);
+  BOOST_CHECK_EQUAL(engine.bytes_written(), 2 * msg.size());
+
+  engine.clear_output();
+  BOOST_CHECK_EQUAL(engine.output(), "");
+}
+
+/**
+ * @test Verify that a read loop consumes a large stream.
+ */
+BOOST_AUTO_TEST_CASE( stream_engine_read_loop ) {
+  boost::asio::io_service io;
+  skye::asio::socket s(io);
+  stream_engine engine(s);
+
+  std::size_t const size = 1 << 20;
+  std::string data(size, 'x');
+  for (std::size_t i = 0; i != size; ++i) {
+    data[i] = char('a' + i % 26);
+  }
+  // ... feed the data in chunks, before any read ...
+  for (std::size_t i = 0; i < size; i += 100000) {
+    engine.feed(data.data() + i, std::min<std::size_t>(100000, size - i));
+  }
+  engine.close_input();
+
+  std::string received;
+  char buf[4096];
+  std::function<void(boost::system::error_code const &, std::size_t)> h;
+  h = [&](boost::system::error_code const & ec, std::size_t n) {
+    received.append(buf, n);
+    if (not ec) {
+      s.async_read_some(boost::asio::buffer(buf), h);
+    }
+  };
+  s.async_read_some(boost::asio::buffer(buf), h);
+  io.run();
+  BOOST_CHECK(received == data);
+  BOOST_CHECK_EQUAL(engine.bytes_read(), size);
+  BOOST_CHECK_EQUAL(s.async_read_some.call_count(), size / 4096 + 1);
+}
+
+/**
+ * @test Verify that the engine detaches from the socket.
+ */
+BOOST_AUTO_TEST_CASE( stream_engine_detach ) {
+  boost::asio::io_service io;
+  skye::asio::socket s(io);
+  {
+    stream_engine engine(s);
+    engine.feed(std::string("abc"));
+  }
+  char buf[16];
+  result r;
+  s.async_read_some(boost::asio::buffer(buf), record(r));
+  io.run();
+  BOOST_CHECK_EQUAL(r.called, 0);
+  s.async_read_some.check_called().once();
+}
+
+/**
+ * @test Verify that gather writes and scatter reads are supported.
+ */
+BOOST_AUTO_TEST_CASE( stream_engine_scatter_gather ) {
+  boost::asio::io_service io;
+  skye::asio::socket s(io);
+  stream_engine engine(s);
+
+  std::string const header("HDR:"), body("payload");
+  std::vector<boost::asio::const_buffer> gather{
+    boost::asio::buffer(header), boost::asio::buffer(body)};
+  result w;
+  s.async_write_some(gather, record(w));
+
+  char h[4], b[16];
+  std::vector<boost::asio::mutable_buffer> scatter{
+    boost::asio::buffer(h), boost::asio::buffer(b)};
+  result r;
+  engine.feed(std::string("ABCDefg"));
+  s.async_read_some(scatter, record(r));
+  io.run();
+
+  BOOST_CHECK_EQUAL(w.bytes, 11);
+  BOOST_CHECK_EQUAL(engine.output(), "HDR:payload");
+  BOOST_CHECK_EQUAL(r.bytes, 7);
+  BOOST_CHECK_EQUAL(std::string(h, 4), "ABCD");
+  BOOST_CHECK_EQUAL(std::string(b, 3), "efg");
+}
@@ -0,0 +1,160 @@
+#include <skye/asio/timer.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <functional>
+
+using skye::asio::timer;
+using skye::asio::virtual_clock;
+
+namespace {
+typedef std::function<void(boost::system::error_code const &)> wait_handler;
+} // anonymous namespace
+
+/**
+ * @test Verify that timers expire in virtual time.
+ */
+BOOST_AUTO_TEST_CASE( timer_basic ) {
+  boost::asio::io_service io;
+  virtual_clock & clock = virtual_clock::get(io);
+  auto const start = clock.now();
+
+  timer t(io);
+  t.expires_from_now(std::chrono::hours(1));
+  int called = 0;
+  boost::system::error_code result = boost::asio::error::eof;
+  t.async_wait([&](boost::system::error_code const & ec) {
+      ++called;
+      result = ec;
+    });
+  BOOST_CHECK_EQUAL(t.pending_waits(), 1);
+  BOOST_CHECK_EQUAL(clock.pending_timers(), 1);
+
+  clock.run();
+  BOOST_CHECK_EQUAL(called, 1);
+  BOOST_CHECK(not result);
+  BOOST_CHECK(clock.now() - start == std::chrono::hours(1));
+  BOOST_CHECK_EQUAL(t.pending_waits(), 0);
+  t.async_wait.check_called().once();
+}
+
+/**
+ * @test Verify that timers expire in deadline order, even when the
+ * handlers create more timers.
+ */
+BOOST_AUTO_TEST_CASE( timer_order ) {
+  boost::asio::io_service io;
+  virtual_clock & clock = virtual_clock::get(io);
+
+  std::vector<int> fired;
+  timer t1(io, std::chrono::seconds(30));
+  timer t2(io, std::chrono::seconds(10));
+  timer t3(io);
+  t1.async_wait([&](boost::system::error_code const &) {
+      fired.push_back(1);
+    });
+  t2.async_wait([&](boost::system::error_code const &) {
+      fired.push_back(2);
+      t3.expires_from_now(std::chrono::seconds(5));
+      t3.async_wait([&](boost::system::error_code const &) {
+          fired.push_back(3);
+        });
+    });
+  clock.run();
+  std::vector<int> const expected{2, 3, 1};
+  BOOST_CHECK_EQUAL_COLLECTIONS(
+      fired.begin(), fired.end(), expected.begin(), expected.end());
+}
+
+/**
+ * @test Verify that a retry loop spanning hours runs immediately.
+ */
+BOOST_AUTO_TEST_CASE( timer_retry_loop ) {
+  boost::asio::io_service io;
+  virtual_clock & clock = virtual_clock::get(io);
+  auto const start = clock.now();
+
+  timer t(io);
+  int retries = 0;
+  wait_handler retry = [&](boost::system::error_code const & ec) {
+    if (ec or ++retries == 3600) {
+      return;
+    }
+    t.expires_from_now(std::chrono::seconds(10));
+    t.async_wait(retry);
+  };
+  t.expires_from_now(std::chrono::seconds(10));
+  t.async_wait(retry);
+  std::size_t handlers = clock.run();
+  BOOST_CHECK_EQUAL(retries, 3600);
+  BOOST_CHECK_EQUAL(handlers, 3600);
+  BOOST_CHECK(clock.now() - start == std::chrono::hours(10));
+  t.async_wait.check_called().exactly( 3600 );
+}
+
+/**
+ * @test Verify that cancelling (or resetting) a timer aborts the
+ * pending waits.
+ */
+BOOST_AUTO_TEST_CASE( timer_cancel ) {
+  boost::asio::io_service io;
+  virtual_clock & clock = virtual_clock::get(io);
+
+  std::vector<boost::system::error_code> results;
+  wait_handler h = [&](boost::system::error_code const & ec) {
+    results.push_back(ec);
+  };
+  timer t(io, std::chrono::minutes(1));
+  t.async_wait(h);
+  t.async_wait(h);
+  BOOST_CHECK_EQUAL(t.cancel(), 2);
+  t.async_wait(h);
+  BOOST_CHECK_EQUAL(t.expires_from_now(std::chrono::minutes(2)), 1);
+  t.async_wait(h);
+  clock.run();
+  BOOST_REQUIRE_EQUAL(results.size(), 4);
+  BOOST_CHECK_EQUAL(results[0], boost::asio::error::operation_aborted);
+  BOOST_CHECK_EQUAL(results[1], boost::asio::error::operation_aborted);
+  BOOST_CHECK_EQUAL(results[2], boost::asio::error::operation_aborted);
+  BOOST_CHECK(not results[3]);
+  BOOST_CHECK_EQUAL(clock.pending_timers(), 0);
+}
+
+/**
+ * @test Verify that run_for() and advance() limit the passage of time.
+ */
+BOOST_AUTO_TEST_CASE( virtual_clock_run_for ) {
+  boost::asio::io_service io;
+  virtual_clock & clock = virtual_clock::get(io);
+  auto const start = clock.now();
+
+  int called = 0;
+  timer t(io, std::chrono::seconds(10));
+  t.async_wait([&called](boost::system::error_code const &) { ++called; });
+
+  clock.run_for(std::chrono::seconds(5));
+  BOOST_CHECK_EQUAL(called, 0);
+  BOOST_CHECK(clock.now() - start == std::chrono::seconds(5));
+  BOOST_CHECK(t.expires_from_now() == std::chrono::seconds(5));
+
+  clock.advance(std::chrono::seconds(5));
+  BOOST_CHECK_EQUAL(called, 0);
+  io.poll();
+  BOOST_CHECK_EQUAL(called, 1);
+
+  // ... waiting on an expired timer completes immediately ...
+  t.async_wait([&called](boost::system::error_code const &) { ++called; });
+  clock.run();
+  BOOST_CHECK_EQUAL(called, 2);
+  BOOST_CHECK(clock.now() - start == std::chrono::seconds(10));
+}
+
+/**
+ * @test Verify that each io_service has its own clock.
+ */
+BOOST_AUTO_TEST_CASE( virtual_clock_per_io_service ) {
+  boost::asio::io_service io1;
+  boost::asio::io_service io2;
+  virtual_clock::get(io1).advance(std::chrono::seconds(1));
+  BOOST_CHECK(&virtual_clock::get(io1) != &virtual_clock::get(io2));
+  BOOST_CHECK(virtual_clock::get(io1).now() != virtual_clock::get(io2).now());
+}
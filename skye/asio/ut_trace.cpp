@@ -0,0 +1,258 @@
+#include <skye/asio/trace_replayer.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <boost/asio/buffer.hpp>
+
+#include <cctype>
+#include <cstdint>
+#include <sstream>
+#include <stdexcept>
+
+using skye::asio::trace_reader;
+using skye::asio::trace_record;
+using skye::asio::trace_replayer;
+using skye::asio::trace_writer;
+
+namespace {
+
+/// A trivial protocol, write back what is read, optionally in
+/// uppercase.
+class echo {
+ public:
+  echo(skye::asio::socket & s, bool upper = false)
+      : socket_(s)
+      , upper_(upper)
+      , buffer_()
+      , error_()
+  {}
+
+  void start() {
+    socket_.async_read_some(
+        boost::asio::buffer(buffer_),
+        [this](boost::system::error_code const & ec, std::size_t n) {
+          on_read(ec, n);
+        });
+  }
+
+  boost::system::error_code const & error() const {
+    return error_;
+  }
+
+ private:
+  void on_read(boost::system::error_code const & ec, std::size_t n) {
+    if (upper_) {
+      for (std::size_t i = 0; i != n; ++i) {
+        buffer_[i] = static_cast<char>(std::toupper(buffer_[i]));
+      }
+    }
+    if (ec) {
+      error_ = ec;
+      return;
+    }
+    socket_.async_write_some(
+        boost::asio::buffer(buffer_, n),
+        [this](boost::system::error_code const & ec, std::size_t) {
+          if (ec) {
+            error_ = ec;
+            return;
+          }
+          start();
+        });
+  }
+
+ private:
+  skye::asio::socket & socket_;
+  bool upper_;
+  char buffer_[3];
+  boost::system::error_code error_;
+};
+
+void record(
+    trace_writer & w, trace_record::direction_type d, std::string const & s,
+    boost::system::error_code const & ec = boost::system::error_code()) {
+  w.write(d, ec, std::chrono::milliseconds(1), s.data(), s.size());
+}
+
+} // anonymous namespace
+
+/**
+ * @test Verify that traces can be written and read back.
+ */
+BOOST_AUTO_TEST_CASE( trace_roundtrip ) {
+  std::stringstream ss;
+  trace_writer w(ss);
+  record(w, trace_record::read, "hello");
+  record(w, trace_record::write, std::string("a\0b", 3));
+  record(w, trace_record::read, "", boost::asio::error::eof);
+  record(w, trace_record::write, "", boost::asio::error::connection_reset);
+  BOOST_CHECK_EQUAL(w.records(), 4);
+
+  trace_reader r(ss);
+  trace_record rec;
+  BOOST_REQUIRE(r.next(rec));
+  BOOST_CHECK_EQUAL(rec.direction, trace_record::read);
+  BOOST_CHECK_EQUAL(rec.data, "hello");
+  BOOST_CHECK(not rec.error);
+  BOOST_CHECK(rec.delay == std::chrono::milliseconds(1));
+  BOOST_REQUIRE(r.next(rec));
+  BOOST_CHECK_EQUAL(rec.direction, trace_record::write);
+  BOOST_CHECK_EQUAL(rec.data, std::string("a\0b", 3));
+  BOOST_REQUIRE(r.next(rec));
+  BOOST_CHECK_EQUAL(rec.error, boost::asio::error::eof);
+  BOOST_CHECK(rec.data.empty());
+  BOOST_REQUIRE(r.next(rec));
+  BOOST_CHECK_EQUAL(rec.error, boost::asio::error::connection_reset);
+  BOOST_CHECK(not r.next(rec));
+  BOOST_CHECK_EQUAL(r.records(), 4);
+}
+
+/**
+ * @test Verify that invalid traces are detected.
+ */
+BOOST_AUTO_TEST_CASE( trace_invalid ) {
+  std::istringstream empty;
+  BOOST_CHECK_THROW(trace_reader r(empty), std::runtime_error);
+  std::istringstream garbage("NOTATRACE");
+  BOOST_CHECK_THROW(trace_reader r(garbage), std::runtime_error);
+
+  std::stringstream ss;
+  trace_writer w(ss);
+  record(w, trace_record::read, "hello");
+  std::string const full = ss.str();
+  std::istringstream truncated(full.substr(0, full.size() - 1));
+  trace_reader r(truncated);
+  trace_record rec;
+  BOOST_CHECK_THROW(r.next(rec), std::runtime_error);
+
+  // ... the record size is 32 bits, larger writes are rejected ...
+  if (sizeof(std::size_t) > sizeof(std::uint32_t)) {
+    std::uint64_t const too_large = std::uint64_t(1) << 32;
+    BOOST_CHECK_THROW(
+        w.write(trace_record::write, boost::system::error_code(),
+                trace_record::duration(0), full.data(),
+                static_cast<std::size_t>(too_large)),
+        std::length_error);
+    BOOST_CHECK_EQUAL(w.records(), 1);
+  }
+}
+
+/**
+ * @test Verify that a trace drives the reads and checks the writes.
+ */
+BOOST_AUTO_TEST_CASE( trace_replay_echo ) {
+  std::stringstream ss;
+  trace_writer w(ss);
+  record(w, trace_record::read, "hello");
+  record(w, trace_record::write, "hel");
+  record(w, trace_record::write, "lo");
+  record(w, trace_record::read, "world");
+  record(w, trace_record::write, "world");
+
+  boost::asio::io_service io;
+  skye::asio::socket s(io);
+  trace_reader r(ss);
+  trace_replayer replayer(s, r);
+  echo e(s);
+  e.start();
+  io.run();
+
+  BOOST_CHECK_MESSAGE(
+      replayer.mismatches() == 0, replayer.first_mismatch());
+  BOOST_CHECK(replayer.finished());
+  BOOST_CHECK_EQUAL(e.error(), boost::asio::error::eof);
+  BOOST_CHECK_EQUAL(replayer.bytes_read(), 10);
+  BOOST_CHECK_EQUAL(replayer.bytes_written(), 10);
+  BOOST_CHECK_EQUAL(s.async_read_some.call_count(), 5);
+  BOOST_CHECK_EQUAL(s.async_write_some.call_count(), 4);
+}
+
+/**
+ * @test Verify that the replayer reports writes that do not match.
+ */
+BOOST_AUTO_TEST_CASE( trace_replay_mismatch ) {
+  std::stringstream ss;
+  trace_writer w(ss);
+  record(w, trace_record::read, "abc");
+  record(w, trace_record::write, "abc");
+  record(w, trace_record::read, "def");
+  record(w, trace_record::write, "def");
+
+  boost::asio::io_service io;
+  skye::asio::socket s(io);
+  trace_reader r(ss);
+  trace_replayer replayer(s, r);
+  echo e(s, true);
+  e.start();
+  io.run();
+
+  BOOST_CHECK_EQUAL(replayer.mismatches(), 2);
+  BOOST_CHECK_EQUAL(
+      replayer.first_mismatch(),
+      "write mismatch at byte 0 of the output, in trace record 2"
+      ", expected=<abc>, actual=<ABC>");
+}
+
+/**
+ * @test Verify that recorded errors are replayed.
+ */
+BOOST_AUTO_TEST_CASE( trace_replay_errors ) {
+  std::stringstream ss;
+  trace_writer w(ss);
+  record(w, trace_record::read, "abc");
+  record(w, trace_record::write, "", boost::asio::error::broken_pipe);
+
+  boost::asio::io_service io;
+  skye::asio::socket s(io);
+  trace_reader r(ss);
+  trace_replayer replayer(s, r);
+  echo e(s);
+  e.start();
+  io.run();
+  BOOST_CHECK_EQUAL(e.error(), boost::asio::error::broken_pipe);
+  BOOST_CHECK_EQUAL(replayer.mismatches(), 0);
+
+  std::stringstream reset;
+  trace_writer w2(reset);
+  record(w2, trace_record::read, "ab", boost::asio::error::connection_reset);
+  io.reset();
+  skye::asio::socket s2(io);
+  trace_reader r2(reset);
+  trace_replayer replayer2(s2, r2);
+  echo e2(s2);
+  e2.start();
+  io.run();
+  BOOST_CHECK_EQUAL(e2.error(), boost::asio::error::connection_reset);
+  BOOST_CHECK_EQUAL(replayer2.bytes_read(), 2);
+}
+
+/**
+ * @test Verify that long traces are streamed, and the delays advance
+ * the virtual clock.
+ */
+BOOST_AUTO_TEST_CASE( trace_replay_long ) {
+  int const count = 10000;
+  std::stringstream ss;
+  trace_writer w(ss);
+  for (int i = 0; i != count; ++i) {
+    std::string const msg = std::to_string(i % 1000);
+    record(w, trace_record::read, msg);
+    record(w, trace_record::write, msg);
+  }
+
+  boost::asio::io_service io;
+  skye::asio::virtual_clock & clock = skye::asio::virtual_clock::get(io);
+  auto const start = clock.now();
+  skye::asio::socket s(io);
+  trace_reader r(ss);
+  trace_replayer replayer(s, r);
+  replayer.set_clock(&clock);
+  echo e(s);
+  e.start();
+  clock.run();
+
+  BOOST_CHECK_MESSAGE(
+      replayer.mismatches() == 0, replayer.first_mismatch());
+  BOOST_CHECK(replayer.finished());
+  BOOST_CHECK_EQUAL(r.records(), 2 * count);
+  BOOST_CHECK(clock.now() - start == std::chrono::milliseconds(2 * count));
+}
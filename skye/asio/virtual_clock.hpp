@@ -0,0 +1,187 @@
+#ifndef skye_asio_virtual_clock_hpp
+#define skye_asio_virtual_clock_hpp
+
+#include <boost/asio/io_service.hpp>
+
+#include <chrono>
+#include <map>
+
+namespace skye {
+namespace asio {
+namespace detail {
+
+/**
+ * The interface used by the virtual clock to expire the mock timers.
+ */
+class virtual_timer {
+ public:
+  virtual ~virtual_timer() {}
+
+  /// Called once the timer deadline is reached.
+  virtual void expire() = 0;
+};
+
+} // namespace detail
+
+/**
+ * A virtual clock for the mock timers in an io_service.
+ *
+ * The clock is a service of the io_service, so each io_service has
+ * its own clock, created the first time it is used.  The clock only
+ * moves when the test says so, and run() jumps straight to the next
+ * deadline whenever the io_service runs out of ready handlers.
+ * Therefore an hour of timeouts and retries runs as fast as the
+ * handlers themselves:
+ *
+ * @code
+ * boost::asio::io_service io;
+ * skye::asio::timer t(io);
+ * t.expires_from_now(std::chrono::hours(1));
+ * t.async_wait([](boost::system::error_code const & ec) { ... });
+ * skye::asio::virtual_clock::get(io).run();
+ * @endcode
+ *
+ * Boost.ASIO requires a static data member as the service id, and
+ * this is a template only so the id can be defined in a header, use
+ * the virtual_clock typedef.
+ */
+template<bool unused>
+class basic_virtual_clock : public boost::asio::io_service::service {
+ public:
+  typedef std::chrono::steady_clock::duration duration;
+  typedef std::chrono::steady_clock::time_point time_point;
+  typedef std::multimap<time_point, detail::virtual_timer*> timer_queue;
+  typedef typename timer_queue::iterator handle;
+
+  /// The service id, required by boost::asio::use_service().
+  static boost::asio::io_service::id id;
+
+  explicit basic_virtual_clock(boost::asio::io_service & io)
+      : boost::asio::io_service::service(io)
+      , io_(io)
+      , now_()
+      , timers_()
+  {}
+
+  /// Return the clock for @a io, creating it if needed.
+  static basic_virtual_clock & get(boost::asio::io_service & io) {
+    return boost::asio::use_service<basic_virtual_clock>(io);
+  }
+
+  /// The current virtual time.
+  time_point now() const {
+    return now_;
+  }
+
+  /**
+   * Run the io_service, advancing the clock as needed.
+   *
+   * Runs the ready handlers, and when there are none left, advances
+   * the clock to the next deadline and expires the timers due.
+   * Returns when there are no ready handlers and no timers left.
+   * Unlike io_service::run(), the io_service is left ready to run
+   * again, without calling reset().
+   *
+   * @returns the number of handlers executed.
+   */
+  std::size_t run() {
+    return run_until(time_point::max());
+  }
+
+  /**
+   * Like run(), but do not advance the clock more than @a d.
+   *
+   * @returns the number of handlers executed.
+   */
+  std::size_t run_for(duration d) {
+    return run_until(now_ + d);
+  }
+
+  /**
+   * Advance the clock by @a d and expire the timers due.
+   *
+   * The handlers of the expired timers are posted to the io_service,
+   * but this function does not run them.
+   */
+  void advance(duration d) {
+    now_ += d;
+    expire_due();
+  }
+
+  //@{
+  /**
+   * @name Used by the mock timers.
+   */
+  /// Call @a t->expire() once the clock reaches @a deadline.
+  handle schedule(time_point deadline, detail::virtual_timer * t) {
+    return timers_.emplace(deadline, t);
+  }
+  /// Cancel a call to schedule().
+  void unschedule(handle h) {
+    timers_.erase(h);
+  }
+  //@}
+
+  /// The number of timers waiting for their deadline.
+  std::size_t pending_timers() const {
+    return timers_.size();
+  }
+
+  /**
+   * Move the clock back to time_point().
+   *
+   * Used to recycle the io_service in another test, see
+   * io_service_context.  There must be no timers waiting for their
+   * deadline.
+   */
+  void reset() {
+    now_ = time_point();
+  }
+
+ private:
+  std::size_t run_until(time_point limit) {
+    std::size_t count = 0;
+    for (;;) {
+      io_.reset();
+      count += io_.poll();
+      if (timers_.empty() or timers_.begin()->first > limit) {
+        break;
+      }
+      if (now_ < timers_.begin()->first) {
+        now_ = timers_.begin()->first;
+      }
+      expire_due();
+    }
+    if (limit != time_point::max() and now_ < limit) {
+      now_ = limit;
+    }
+    io_.reset();
+    return count;
+  }
+
+  void expire_due() {
+    while (not timers_.empty() and timers_.begin()->first <= now_) {
+      detail::virtual_timer * t = timers_.begin()->second;
+      timers_.erase(timers_.begin());
+      t->expire();
+    }
+  }
+
+  virtual void shutdown_service() override {
+  }
+
+ private:
+  boost::asio::io_service & io_;
+  time_point now_;
+  timer_queue timers_;
+};
+
+template<bool unused>
+boost::asio::io_service::id basic_virtual_clock<unused>::id;
+
+typedef basic_virtual_clock<true> virtual_clock;
+
+} // namespace asio
+} // namespace skye
+
+#endif // skye_asio_virtual_clock_hpp
@@ -0,0 +1,12 @@
+/**
+ * @file
+ *
+ * Define the explicit instantiations declared in
+ * skye/detail/extern_templates.hpp.
+ */
+#define SKYE_COMPILING_LIBRARY
+#if not defined(SKYE_USE_COMPILED_LIBRARY)
+#  define SKYE_USE_COMPILED_LIBRARY
+#endif // SKYE_USE_COMPILED_LIBRARY
+
+#include <skye/detail/extern_templates.hpp>
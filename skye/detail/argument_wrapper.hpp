@@ -1,8 +1,10 @@
 #ifndef skye_detail_invocation_argument_wrapper_hpp
 #define skye_detail_invocation_argument_wrapper_hpp
 
+#include <skye/detail/index_list.hpp>
 #include <skye/detail/tuple_streaming.hpp>
 
+#include <functional>
 #include <iostream>
 #include <tuple>
 #include <type_traits>
@@ -23,7 +25,7 @@ struct argument_wrapper {
       : value(t)
   {}
   explicit argument_wrapper(T && t)
-      : value(t)
+      : value(std::move(t))
   {}
 
   operator T const&() const {
@@ -37,8 +39,10 @@ struct argument_wrapper {
  * Helper function that determines if there is a operator<<() defined
  * for std::ostream and T::value_type.
  *
- * There are two overloads, but one has a variadic template so it is
- * only used if the first one fails.  The first one only works if
+ * There are two overloads, but one has a C-style variadic argument
+ * list so it is only used if the first one fails.  The ellipsis is
+ * cheaper to compile than a template parameter pack, which creates a
+ * new specialization for each deduction.  The first one only works if
  * decltype(os << t.value) is a legal expression, otherwise SFINAE
  * removes it from consideration.
  */
@@ -52,9 +56,8 @@ auto safe_streaming(
 /**
  * Generic overload used when streaming operator is not defined.
  */
-template<typename T, typename... non_streamable>
-void safe_streaming(
-    std::ostream & os, argument_wrapper<T> const & t, non_streamable...) {
+template<typename T>
+void safe_streaming(std::ostream & os, argument_wrapper<T> const & t, ...) {
   os << "[::non_streamable::]";
 }
 
@@ -67,6 +70,38 @@ std::ostream & operator<<(std::ostream & os, argument_wrapper<T> const & t) {
   return os;
 }
 
+/**
+ * Determine if operator==() is usable for a type.
+ *
+ * The standard containers declare operator==() for any element type,
+ * so a std::vector is only comparable if its elements are.  That
+ * matters for scatter/gather buffer sequences, as the ASIO buffers
+ * cannot be compared.
+ *
+ * @see safe_streaming for an explanation of the technique.
+ */
+template<typename T>
+struct is_equality_comparable {
+ private:
+  template<typename U>
+  static auto test(bool)
+      -> decltype(bool(std::declval<U const &>() == std::declval<U const &>()),
+                  std::true_type());
+  template<typename U>
+  static std::false_type test(...);
+
+ public:
+  static bool const value = decltype(test<T>(true))::value;
+};
+
+template<typename T>
+bool const is_equality_comparable<T>::value;
+
+template<typename T, typename A>
+struct is_equality_comparable<std::vector<T,A>>
+    : public is_equality_comparable<T> {
+};
+
 /**
  * Helper function that determines if there is a operator==() defined
  * for a pair of wrapped arguments.
@@ -75,34 +110,50 @@ std::ostream & operator<<(std::ostream & os, argument_wrapper<T> const & t) {
  */
 template<typename T>
 auto safe_equals(
-    argument_wrapper<T> const & lhs, argument_wrapper<T> const & rhs, bool)
-    -> decltype(bool(lhs.value == rhs.value), bool()) {
+    argument_wrapper<T> const & lhs, argument_wrapper<T> const & rhs, int)
+    -> typename std::enable_if<is_equality_comparable<T>::value, bool>::type {
   return lhs.value == rhs.value;
 }
 
+/**
+ * Compare a wrapped argument against a value of another type.
+ *
+ * Two wrappers of the same type only use the previous overload, and
+ * a value of the same type is only compared if the type is
+ * comparable, see is_equality_comparable.
+ */
 template<typename T, typename U>
 auto safe_equals(
-    argument_wrapper<T> const & lhs, U const & rhs, bool)
-    -> decltype(bool(rhs == lhs.value), bool()) {
+    argument_wrapper<T> const & lhs, U const & rhs, int)
+    -> typename std::enable_if<
+      not std::is_same<U, argument_wrapper<T>>::value
+      and (not std::is_same<U, T>::value
+           or is_equality_comparable<T>::value),
+      decltype(bool(rhs == lhs.value), bool())>::type {
   return rhs == lhs.value;
 }
 
-template<typename T, typename... no_equals>
-bool safe_equals(
-    argument_wrapper<T> const & lhs, no_equals...) {
+/**
+ * Generic overload used when operator==() is not defined.
+ *
+ * The callers pass an int, so the long parameter makes this overload
+ * a worse match than the previous ones.
+ */
+template<typename T, typename U>
+bool safe_equals(argument_wrapper<T> const &, U const &, long) {
   return false;
 }
 
 template<typename T>
 bool operator==(
     argument_wrapper<T> const & lhs, argument_wrapper<T> const & rhs) {
-  return safe_equals(lhs, rhs, true);
+  return safe_equals(lhs, rhs, 0);
 }
 
 template<typename T, typename U>
 bool operator==(
     argument_wrapper<T> const & lhs, U const & rhs) {
-  return safe_equals(lhs, rhs, true);
+  return safe_equals(lhs, rhs, 0);
 }
 
 template<typename T>
@@ -117,6 +168,147 @@ bool operator!=(
   return !(lhs == rhs);
 }
 
+/**
+ * Determine if std::hash<> is usable for a type.
+ *
+ * @see safe_streaming for an explanation of the technique.
+ */
+template<typename T>
+struct is_hashable {
+ private:
+  template<typename U>
+  static auto test(bool)
+      -> decltype(std::hash<U>()(std::declval<U const &>()), std::true_type());
+  template<typename U>
+  static std::false_type test(...);
+
+ public:
+  static bool const value = decltype(test<T>(true))::value;
+};
+
+template<typename T>
+bool const is_hashable<T>::value;
+
+/**
+ * Hash a wrapped argument if possible.
+ *
+ * The generic version is used for arguments that cannot be hashed
+ * (such as place_holder).  Callers are expected to check
+ * argument_hash::hashable before using the value returned by hash().
+ */
+template<typename wrapped>
+struct argument_hash {
+  static bool const hashable = false;
+  static std::size_t hash(wrapped const &) {
+    return 0;
+  }
+  template<typename U>
+  static std::size_t hash_argument(U const &) {
+    return 0;
+  }
+};
+
+template<typename wrapped>
+bool const argument_hash<wrapped>::hashable;
+
+/**
+ * Partial specialization for wrapped arguments.
+ */
+template<typename T>
+struct argument_hash<argument_wrapper<T>> {
+  static bool const hashable = is_hashable<T>::value;
+  static std::size_t hash(argument_wrapper<T> const & t) {
+    return hash_argument(t.value);
+  }
+  /// Hash an argument of a call, as if it was wrapped.
+  static std::size_t hash_argument(T const & x) {
+    return hash_argument(x, std::integral_constant<bool,hashable>());
+  }
+
+ private:
+  static std::size_t hash_argument(T const & x, std::true_type) {
+    return std::hash<T>()(x);
+  }
+  static std::size_t hash_argument(T const &, std::false_type) {
+    return 0;
+  }
+};
+
+template<typename T>
+bool const argument_hash<argument_wrapper<T>>::hashable;
+
+/// Combine the hash of the next element into @a h.
+inline std::size_t hash_combine(std::size_t h, std::size_t v) {
+  return h ^ (v + 0x9e3779b9 + (h << 6) + (h >> 2));
+}
+
+template<bool... values>
+struct bool_list {
+};
+
+/// True if all the @a values are true, without recursion.
+template<bool... values>
+struct all_true
+    : public std::is_same<bool_list<true, values...>,
+                          bool_list<values..., true>> {
+};
+
+/**
+ * Hash a tuple of wrapped arguments.
+ *
+ * The tuple is hashable only if all its elements are.  The elements
+ * are combined with a pack expansion over @a indices, in order.
+ */
+template<typename tuple_t, typename indices>
+struct tuple_hash;
+
+template<typename tuple_t, std::size_t... I>
+struct tuple_hash<tuple_t, index_list<I...>> {
+  static bool const hashable = all_true<
+    argument_hash<typename std::tuple_element<I, tuple_t>::type>::hashable...
+    >::value;
+
+  static std::size_t hash(tuple_t const & x) {
+    std::size_t h = 0;
+    int const unused[] = {
+      0, (h = hash_combine(h, argument_hash<
+               typename std::tuple_element<I, tuple_t>::type>::hash(
+                   std::get<I>(x))), 0)...};
+    (void) unused;
+    return h;
+  }
+
+  /**
+   * Hash the arguments of a call, without capturing them.
+   *
+   * The result is the same as hash() for the capture of the
+   * arguments.
+   */
+  template<typename... args>
+  static std::size_t hash_arguments(args const &... a) {
+    std::size_t h = 0;
+    int const unused[] = {
+      0, (h = hash_combine(h, argument_hash<
+               typename std::tuple_element<I, tuple_t>::type>::hash_argument(
+                   a)), 0)...};
+    (void) unused;
+    return h;
+  }
+};
+
+template<typename tuple_t, std::size_t... I>
+bool const tuple_hash<tuple_t, index_list<I...>>::hashable;
+
+/**
+ * Hash a tuple of wrapped arguments.
+ */
+template<typename tuple_t>
+struct wrapped_tuple_hash
+    : public tuple_hash<
+        tuple_t,
+        typename make_index_list<std::tuple_size<tuple_t>::value>::type> {
+};
+
 /**
  * A simple object to hold in place of non-copy-constructible objects.
  */
@@ -180,10 +372,15 @@ struct argument_wrapper_type<T,false> {
 
 /**
  * A traits class describe how an argument is wrapped.
+ *
+ * The wrapper holds a copy of the argument, so any reference and cv
+ * qualifiers are removed, that way all the ways to pass a T are
+ * captured with the same type, and the captures are assignable.
  */
 template<typename T>
 struct argument_traits {
-  typedef typename std::remove_reference<T>::type base_type;
+  typedef typename std::remove_cv<
+    typename std::remove_reference<T>::type>::type base_type;
   static bool const copyable = std::is_copy_constructible<base_type>::value;
   typedef typename argument_wrapper_type<base_type,copyable>::type type;
 };
@@ -193,20 +390,14 @@ bool const argument_traits<T>::copyable;
 
 /**
  * Wrap an argument in the correct type, using perfect forwarding.
+ *
+ * Rvalues are moved into the wrapper, lvalues are copied.
  */
 template<typename T>
 typename argument_traits<T>::type make_arg_wrapper(T && t) {
   return typename argument_traits<T>::type(std::forward<T>(t));
 }
 
-/**
- * Wrap an argument in the correct type, based on a const reference.
- */
-template<typename T>
-typename argument_traits<T>::type make_arg_wrapper(T const & t) {
-  return typename argument_traits<T>::type(t);
-}
-
 /**
  * Forward a single argument to make_ar_wrapper function.
  */
@@ -217,14 +408,103 @@ auto forward_wrapper(T && arg)
 }
 
 /**
- * Wrap a list of arguments into a tuple using make_arg_wrapper() for each one.
+ * The type of a tuple of wrapped arguments.
+ */
+template<typename... args>
+struct wrapped_tuple {
+  typedef std::tuple<typename argument_traits<args>::type...> type;
+};
+
+/**
+ * Wrap a list of arguments into a tuple, with the same wrapper types
+ * make_arg_wrapper() would use.
+ *
+ * Each element of the tuple is constructed directly from the
+ * (perfectly forwarded) argument, so rvalues are moved exactly once
+ * and lvalues are copied exactly once.
  */
 template<typename... args>
-auto wrap_args_as_tuple(args&&... a)
-    -> decltype(std::make_tuple(forward_wrapper(a)...)) {
-  return std::make_tuple(forward_wrapper(a)...);
+typename wrapped_tuple<args...>::type wrap_args_as_tuple(args&&... a) {
+  return typename wrapped_tuple<args...>::type(std::forward<args>(a)...);
+}
+
+/// Compare a captured argument against an argument of a call.
+template<typename wrapped, typename U>
+bool captured_argument_equals(wrapped const & lhs, U const & rhs) {
+  return lhs == rhs;
+}
+
+/// Non-copyable arguments are not captured, any value matches.
+template<typename U>
+bool captured_argument_equals(place_holder const &, U const &) {
+  return true;
+}
+
+/**
+ * Compare a tuple of wrapped arguments against the arguments of a
+ * call, without copying (or moving from) the arguments.
+ */
+template<typename tuple_t, std::size_t... I, typename... args>
+bool wrapped_tuple_equals(
+    tuple_t const & lhs, index_list<I...>, args const &... a) {
+  bool result = true;
+  int const unused[] = {
+    0, (result = result and captured_argument_equals(std::get<I>(lhs), a),
+        0)...};
+  (void) unused;
+  return result;
 }
 
+/**
+ * True if predicate_argument copies an argument of type T.
+ *
+ * Arguments passed by value or by rvalue reference are copied, unless
+ * they cannot be copied.  Lvalue references are passed through, the
+ * capture does not take them.
+ */
+template<typename T>
+struct predicate_argument_copies : public std::integral_constant<
+  bool, not std::is_lvalue_reference<T>::value
+  and std::is_copy_constructible<typename std::decay<T>::type>::value> {
+};
+
+/**
+ * Hold an argument of a mock call for the predicates.
+ *
+ * Predicates (see whenp()) receive the arguments as rvalues, and may
+ * move from them.  The mock still needs the arguments for the
+ * capture, so the predicates receive a copy, made once per call and
+ * shared by all the predicates.
+ */
+template<typename T, bool copies = predicate_argument_copies<T>::value>
+struct predicate_argument {
+  explicit predicate_argument(typename std::remove_reference<T>::type const & x)
+      : value(x)
+  {}
+
+  T && get() {
+    return static_cast<T&&>(value);
+  }
+
+  typename std::decay<T>::type value;
+};
+
+/**
+ * Pass an argument that is not copied to the predicates.
+ */
+template<typename T>
+struct predicate_argument<T,false> {
+  explicit predicate_argument(typename std::remove_reference<T>::type & x)
+      : value(x)
+  {}
+
+  T && get() {
+    return static_cast<T&&>(value);
+  }
+
+  typename std::remove_reference<T>::type & value;
+};
+
 /**
  * Define the default strategy to capture arguments in mock functions.
  *
@@ -244,18 +524,65 @@ class known_arguments_capture_by_value {
 
   /// Capture a set of arguments.
   static value_type capture(arg_types&&... args) {
-    return wrap_args_as_tuple(args...);
+    return value_type(std::forward<arg_types>(args)...);
+  }
+
+  /**
+   * Capture a set of arguments directly into a capture_buffer.
+   *
+   * The capture is constructed in place, so each argument is moved
+   * (or copied, if it is an lvalue) exactly once.
+   */
+  template<typename buffer_type>
+  static value_type & capture_into(buffer_type & buffer, arg_types&&... args) {
+    return buffer.emplace_back(std::forward<arg_types>(args)...);
   }
 
   static bool equals(value_type const & lhs, value_type const & rhs) {
     return lhs == rhs;
   }
 
+  /// Compare a capture against the arguments of a call.
+  static bool matches(value_type const & lhs, arg_types const &... args) {
+    return wrapped_tuple_equals(
+        lhs, typename make_index_list<sizeof...(arg_types)>::type(), args...);
+  }
+
+  /// Return true if the capture can be used as a key in a hash table.
+  static bool hashable(value_type const &) {
+    return wrapped_tuple_hash<value_type>::hashable;
+  }
+
+  static std::size_t hash(value_type const & x) {
+    return wrapped_tuple_hash<value_type>::hash(x);
+  }
+
+  /// Hash the arguments of a call, as hash() would hash their capture.
+  static std::size_t hash_arguments(arg_types const &... args) {
+    return wrapped_tuple_hash<value_type>::hash_arguments(args...);
+  }
+
   static void stream(std::ostream & os, value_type const & x) {
     os << x;
   }
 };
 
+/**
+ * Select the default capture strategy for a function signature.
+ *
+ * Only the partial specialization for function types is defined.
+ */
+template<typename signature>
+struct default_capture_strategy;
+
+/**
+ * By default mock functions capture their arguments by value.
+ */
+template<typename return_type, typename... arg_types>
+struct default_capture_strategy<return_type(arg_types...)> {
+  typedef known_arguments_capture_by_value<arg_types...> type;
+};
+
 } // namespace detail
 } // namespace skye
 
@@ -7,24 +7,74 @@
 namespace skye {
 namespace detail {
 
-typedef boost_check_reporting default_check_reporting;
-typedef boost_require_reporting default_require_reporting;
+typedef boost_check_reporting framework_check_reporting;
+typedef boost_require_reporting framework_require_reporting;
 
 } // namespace detail
 } // namespace skye
 
-#else /* SKYE_USE_BOOST_UNIT_TEST_FRAMEWORK */
+#elif defined(SKYE_USE_BUFFERED_ASSERTION_REPORTING)
+
+#  include <skye/detail/buffered_assertion_reporting.hpp>
+namespace skye {
+namespace detail {
+
+typedef buffered_check_reporting framework_check_reporting;
+typedef buffered_require_reporting framework_require_reporting;
+
+} // namespace detail
+} // namespace skye
+
+#elif defined(SKYE_USE_LIGHTWEIGHT_TEST_FRAMEWORK)
+
+#  include <skye/detail/hook_assertion_reporting.hpp>
+namespace skye {
+namespace detail {
+
+typedef hook_check_reporting framework_check_reporting;
+typedef hook_require_reporting framework_require_reporting;
+
+} // namespace detail
+} // namespace skye
+
+#else /* SKYE_USE_LIGHTWEIGHT_TEST_FRAMEWORK */
 
 #  include <skye/detail/iostream_assertion_reporting.hpp>
 namespace skye {
 namespace detail {
 
-typedef iostream_check_reporting default_check_reporting;
-typedef iostream_require_reporting default_require_reporting;
+typedef iostream_check_reporting framework_check_reporting;
+typedef iostream_require_reporting framework_require_reporting;
 
 } // namespace detail
 } // namespace skye
 
 #endif /* Fallback, no special macro defined */
 
+#if defined(SKYE_USE_JSON_ASSERTION_REPORTING)
+
+#  include <skye/detail/json_assertion_reporting.hpp>
+namespace skye {
+namespace detail {
+
+typedef json_reporting<framework_check_reporting> default_check_reporting;
+typedef json_reporting<
+  framework_require_reporting> default_require_reporting;
+
+} // namespace detail
+} // namespace skye
+
+#else /* SKYE_USE_JSON_ASSERTION_REPORTING */
+
+namespace skye {
+namespace detail {
+
+typedef framework_check_reporting default_check_reporting;
+typedef framework_require_reporting default_require_reporting;
+
+} // namespace detail
+} // namespace skye
+
+#endif /* SKYE_USE_JSON_ASSERTION_REPORTING */
+
 #endif // skye_detail_assertion_reporting_hpp
@@ -3,8 +3,12 @@
 
 #include <skye/detail/validator.hpp>
 #include <boost/test/unit_test.hpp>
+#include <boost/test/unit_test_parameters.hpp>
 #include <boost/test/execution_monitor.hpp>
 
+#include <string>
+#include <vector>
+
 namespace skye {
 namespace detail {
 
@@ -24,6 +28,44 @@ inline void boost_log_common(
 #endif // BOOST_VERSION
 }
 
+/**
+ * Query the Boost.Test configuration to determine if successful
+ * assertions are logged.
+ *
+ * With multiple loggers (the --logger option) each one has its own
+ * level, in that case assume the messages are needed.
+ */
+inline bool boost_query_success_logging() {
+  namespace ut = boost::unit_test;
+#if BOOST_VERSION < 106000
+  return ut::runtime_config::log_level() <= ut::log_successful_tests;
+#else
+#if BOOST_VERSION >= 106200
+  if (ut::runtime_config::has(ut::runtime_config::btrt_combined_logger)
+      and not ut::runtime_config::get<std::vector<std::string>>(
+          ut::runtime_config::btrt_combined_logger).empty()) {
+    return true;
+  }
+#endif // BOOST_VERSION >= 106200
+  if (not ut::runtime_config::has(ut::runtime_config::btrt_log_level)) {
+    return true;
+  }
+  return ut::runtime_config::get<ut::log_level>(
+      ut::runtime_config::btrt_log_level) <= ut::log_successful_tests;
+#endif // BOOST_VERSION
+}
+
+/**
+ * Return true if Boost.Test logs successful assertions.
+ *
+ * The log level is set on the command line, so the configuration is
+ * queried once, with the first assertion, and not for every one.
+ */
+inline bool boost_success_logging_enabled() {
+  static bool const enabled = boost_query_success_logging();
+  return enabled;
+}
+
 /// Report to Boost.Test using BOOST_CHECK_* semantics.
 struct boost_check_reporting {
   /// Checkpoint progress through the unit test
@@ -31,6 +73,11 @@ struct boost_check_reporting {
     boost::unit_test::unit_test_log.set_checkpoint(where.file, where.line);
   }
 
+  /// Return true if successful assertions are logged.
+  static bool success_logging_enabled() {
+    return boost_success_logging_enabled();
+  }
+
   /// Report a successful assertion.
   static void report_success(
       location const & where, std::string const & msg) {
@@ -53,6 +100,11 @@ struct boost_require_reporting {
     boost::unit_test::unit_test_log.set_checkpoint(where.file, where.line);
   }
 
+  /// Return true if successful assertions are logged.
+  static bool success_logging_enabled() {
+    return boost_success_logging_enabled();
+  }
+
   /// Report a successful assertion.
   static void report_success(
       location const & where, std::string const & msg) {
@@ -0,0 +1,315 @@
+#ifndef skye_detail_buffered_assertion_reporting_hpp
+#define skye_detail_buffered_assertion_reporting_hpp
+
+#include <skye/detail/iostream_assertion_reporting.hpp>
+#include <skye/detail/mpsc_queue.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <mutex>
+#include <queue>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace skye {
+namespace detail {
+
+/**
+ * Write assertion results to a stream from a background thread.
+ *
+ * The threads reporting assertions append the formatted lines to a
+ * lock-free queue, and a background thread writes them in batches,
+ * with a single write and flush per batch.  Failures are flushed
+ * immediately: the reporting thread waits until the failure, and
+ * everything reported before it, is written and flushed.  Each line
+ * gets a ticket, in the order the lines are reported, and the
+ * background thread publishes the highest ticket such that all the
+ * lines up to it are written.  The lines may reach the queue out of
+ * order, so counting the lines written is not enough.
+ *
+ * By default successful assertions are only counted, and a summary
+ * with the counts is written when the log is destroyed, or by
+ * write_summary().  Use set_log_successes() to write one line per
+ * successful assertion, as iostream_check_reporting does.
+ *
+ * The background thread starts with the first line written, a test
+ * where every assertion passes never starts it, its summary is
+ * written directly when the log is destroyed.
+ */
+class assertion_log {
+ public:
+  assertion_log()
+      : os_(&std::cerr)
+      , log_successes_(false)
+      , successes_(0)
+      , failures_(0)
+      , queue_()
+      , tickets_(0)
+      , mu_()
+      , cv_()
+      , written_(0)
+      , done_()
+      , stop_(false)
+      , writer_()
+      , start_()
+  {}
+
+  ~assertion_log() {
+    if (successes_.load() != 0 or failures_.load() != 0) {
+      if (writer_.joinable()) {
+        write_summary();
+      } else {
+        // ... nothing was queued, do not start the background thread
+        // during the static destruction, write the summary directly ...
+        std::string const line = summary();
+        std::lock_guard<std::mutex> lock(mu_);
+        os_->write(line.data(), line.size());
+        os_->flush();
+      }
+    }
+    stop();
+  }
+
+  assertion_log(assertion_log const &) = delete;
+  assertion_log & operator=(assertion_log const &) = delete;
+
+  /// The log shared by all the buffered reporting strategies.
+  static assertion_log & instance() {
+    static assertion_log log;
+    return log;
+  }
+
+  /// Report a successful assertion.
+  void success(
+      location const & where, std::string const & msg,
+      std::string const & severity) {
+    successes_.fetch_add(1, std::memory_order_relaxed);
+    if (log_successes_.load(std::memory_order_relaxed)) {
+      push(format(where, msg, severity, true));
+    }
+  }
+
+  /// Report a failed assertion, and wait until it is written.
+  void failure(
+      location const & where, std::string const & msg,
+      std::string const & severity) {
+    failures_.fetch_add(1, std::memory_order_relaxed);
+    wait(push(format(where, msg, severity, false)));
+  }
+
+  /// Wait until all the lines reported so far are written and flushed.
+  void flush() {
+    wait(tickets_.load());
+  }
+
+  /// Write (and flush) the number of successes and failures so far.
+  void write_summary() {
+    wait(push(summary()));
+  }
+
+  /**
+   * Write to @a os instead of std::cerr.
+   *
+   * The lines reported so far are written to the previous stream.
+   */
+  void set_stream(std::ostream & os) {
+    flush();
+    std::lock_guard<std::mutex> lock(mu_);
+    os_ = &os;
+  }
+
+  /// Write (or not) one line per successful assertion.
+  void set_log_successes(bool enable) {
+    log_successes_.store(enable);
+  }
+
+  //@{
+  /**
+   * @name Accessors
+   */
+  bool log_successes() const {
+    return log_successes_.load(std::memory_order_relaxed);
+  }
+  std::uint64_t successes() const {
+    return successes_.load();
+  }
+  std::uint64_t failures() const {
+    return failures_.load();
+  }
+  //@}
+
+ private:
+  static std::string format(
+      location const & where, std::string const & msg,
+      std::string const & severity, bool success) {
+    std::ostringstream os;
+    iostream_format_common(os, where, msg, severity, success);
+    os << "\n";
+    return os.str();
+  }
+
+  /// Format the summary line.
+  std::string summary() const {
+    std::ostringstream os;
+    os << "assertion summary: " << successes_.load() << " success(es), "
+       << failures_.load() << " failure(s)\n";
+    return os.str();
+  }
+
+  /// A line waiting to be written, and its ticket.
+  struct entry {
+    std::uint64_t ticket;
+    std::string line;
+  };
+
+  /// Queue @a line, return its ticket.
+  std::uint64_t push(std::string && line) {
+    std::call_once(start_, [this]() {
+        writer_ = std::thread([this]() { run(); });
+      });
+    std::uint64_t const ticket = tickets_.fetch_add(1) + 1;
+    queue_.push(entry{ticket, std::move(line)});
+    cv_.notify_one();
+    return ticket;
+  }
+
+  /// Wait until all the lines up to @a ticket are written and flushed.
+  void wait(std::uint64_t ticket) {
+    if (ticket == 0) {
+      return;
+    }
+    std::unique_lock<std::mutex> lock(mu_);
+    cv_.notify_all();
+    cv_.wait(lock, [this, ticket]() { return written_ >= ticket; });
+  }
+
+  /// The body of the background thread.
+  void run() {
+    std::string batch;
+    entry e;
+    std::unique_lock<std::mutex> lock(mu_);
+    for (;;) {
+      std::uint64_t count = 0;
+      batch.clear();
+      while (queue_.pop(e)) {
+        batch += e.line;
+        done_.push(e.ticket);
+        ++count;
+      }
+      if (count != 0) {
+        os_->write(batch.data(), batch.size());
+        os_->flush();
+        // ... a line with an earlier ticket may not be in the queue
+        // yet, only publish the tickets without gaps ...
+        while (not done_.empty() and done_.top() == written_ + 1) {
+          ++written_;
+          done_.pop();
+        }
+        cv_.notify_all();
+        continue;
+      }
+      if (stop_) {
+        return;
+      }
+      // ... the producers do not hold the mutex when they push, so a
+      // notification can be missed, poll the queue periodically ...
+      cv_.wait_for(lock, std::chrono::milliseconds(10));
+    }
+  }
+
+  void stop() {
+    {
+      std::lock_guard<std::mutex> lock(mu_);
+      stop_ = true;
+      cv_.notify_all();
+    }
+    if (writer_.joinable()) {
+      writer_.join();
+    }
+  }
+
+ private:
+  std::ostream * os_;
+  std::atomic<bool> log_successes_;
+  std::atomic<std::uint64_t> successes_;
+  std::atomic<std::uint64_t> failures_;
+  mpsc_queue<entry> queue_;
+  /// The last ticket assigned.
+  std::atomic<std::uint64_t> tickets_;
+  /// Protects os_, written_, done_ and stop_, the background thread
+  /// holds it except while it waits.
+  std::mutex mu_;
+  std::condition_variable cv_;
+  /// All the lines with a ticket up to this one are written.
+  std::uint64_t written_;
+  /// The tickets written after a gap in the sequence.
+  std::priority_queue<
+    std::uint64_t, std::vector<std::uint64_t>,
+    std::greater<std::uint64_t>> done_;
+  bool stop_;
+  std::thread writer_;
+  std::once_flag start_;
+};
+
+/// Report to the buffered assertion_log, with no further action on
+/// failures.
+struct buffered_check_reporting {
+  /// Checkpoint progress through the unit test
+  static void checkpoint(location const & ) {
+  }
+
+  /// Return true if successful assertions are logged.
+  static bool success_logging_enabled() {
+    return assertion_log::instance().log_successes();
+  }
+
+  /// Report a successful assertion.
+  static void report_success(
+      location const & where, std::string const & msg) {
+    assertion_log::instance().success(where, msg, "checked");
+  }
+
+  /// Report an assertion failure.
+  static void report_failure(
+      location const & where, std::string const & msg) {
+    assertion_log::instance().failure(where, msg, "checked");
+  }
+};
+
+/// Report to the buffered assertion_log, and raise an exception on
+/// failures.
+struct buffered_require_reporting {
+  /// Checkpoint progress through the unit test
+  static void checkpoint(location const & ) {
+  }
+
+  /// Return true if successful assertions are logged.
+  static bool success_logging_enabled() {
+    return assertion_log::instance().log_successes();
+  }
+
+  /// Report a successful assertion.
+  static void report_success(
+      location const & where, std::string const & msg) {
+    assertion_log::instance().success(where, msg, "required");
+  }
+
+  /// Report an assertion failure.
+  static void report_failure(
+      location const & where, std::string const & msg) {
+    assertion_log::instance().failure(where, msg, "required");
+    throw std::runtime_error(msg);
+  }
+};
+
+} // namespace detail
+} // namespace skye
+
+#endif // skye_detail_buffered_assertion_reporting_hpp
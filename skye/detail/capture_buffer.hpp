@@ -0,0 +1,344 @@
+#ifndef skye_detail_capture_buffer_hpp
+#define skye_detail_capture_buffer_hpp
+
+#include <skye/detail/capture_shards.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace skye {
+namespace detail {
+
+/**
+ * Hold the argument captures for a mock function.
+ *
+ * By default all the captures are retained, in the order the calls
+ * were made.  Long running tests (soak tests for example) can drive
+ * millions of calls through a single mock, so the buffer can be
+ * bounded: once @a capacity captures are retained each new capture
+ * overwrites the oldest one, as in a ring buffer.  The total number
+ * of calls is always tracked exactly, even after older captures are
+ * dropped.
+ *
+ * In bounded mode the captures are rotated back into call order
+ * lazily, when they are examined, so recording a call is O(1) in
+ * either mode.  Captures that cannot be assigned are replaced by
+ * destroying the old capture and constructing the new one in its
+ * place, if that cannot throw, otherwise the buffer ignores the
+ * capacity and retains all the captures.
+ *
+ * The buffer can also be made thread-safe (see set_thread_safe()),
+ * in that mode each thread appends to its own shard (see
+ * capture_shards), and the shards are merged, in call order, when
+ * the captures are examined.  Only appending through append() is
+ * safe to do concurrently, the accessors and modifiers must not run
+ * concurrently with each other.
+ *
+ * @tparam sequence_type the container used to hold the captures, as
+ *   defined by the capture strategy.
+ */
+template<typename sequence_type>
+class capture_buffer {
+ public:
+  typedef typename sequence_type::value_type value_type;
+  typedef typename sequence_type::const_iterator const_iterator;
+
+  typedef capture_shards<sequence_type> shards;
+
+  /// True if a new capture can replace the oldest one in bounded mode.
+  typedef std::integral_constant<
+    bool, std::is_move_assignable<value_type>::value
+    or std::is_nothrow_move_constructible<value_type>::value> overwritable;
+
+  capture_buffer()
+      : sequence_()
+      , capacity_(0)
+      , head_(0)
+      , total_(0)
+      , shards_()
+  {}
+  capture_buffer(capture_buffer const & rhs)
+      : sequence_(rhs.sequence())
+      , capacity_(rhs.capacity_)
+      , head_(0)
+      , total_(rhs.total_)
+      , shards_(rhs.shards_ ? new shards : nullptr)
+  {}
+  capture_buffer & operator=(capture_buffer const & rhs) {
+    if (this != &rhs) {
+      sequence_ = rhs.sequence();
+      capacity_ = rhs.capacity_;
+      head_ = 0;
+      total_ = rhs.total_;
+      shards_.reset(rhs.shards_ ? new shards : nullptr);
+    }
+    return *this;
+  }
+
+  /**
+   * Append captures to the buffer, holding any locks required.
+   *
+   * The capture strategies store captures in this object, and the
+   * caller may keep using the reference to the stored value until the
+   * appender is destroyed.
+   */
+  class appender {
+   public:
+    explicit appender(capture_buffer & buffer)
+        : buffer_(&buffer)
+        , shard_(nullptr)
+        , lock_() {
+      if (buffer.shards_) {
+        shard_ = &buffer.shards_->local_shard();
+        lock_ = std::unique_lock<std::mutex>(shard_->mu);
+      }
+    }
+
+    value_type & push_back(value_type && v) {
+      if (shard_ == nullptr) {
+        return buffer_->push_back(std::move(v));
+      }
+      return buffer_->shards_->push_back(*shard_, std::move(v));
+    }
+
+    template<typename... arg_types>
+    value_type & emplace_back(arg_types&&... args) {
+      if (shard_ == nullptr) {
+        return buffer_->emplace_back(std::forward<arg_types>(args)...);
+      }
+      return buffer_->shards_->emplace_back(
+          *shard_, std::forward<arg_types>(args)...);
+    }
+
+   private:
+    capture_buffer * buffer_;
+    typename shards::shard * shard_;
+    std::unique_lock<std::mutex> lock_;
+  };
+
+  /// Return an appender, safe to use concurrently in thread-safe mode.
+  appender append() {
+    return appender(*this);
+  }
+
+  /**
+   * Enable (or disable) the thread-safe mode.
+   *
+   * This function must not be called concurrently with any other
+   * member function.
+   */
+  void set_thread_safe(bool enable) {
+    if (enable == bool(shards_)) {
+      return;
+    }
+    if (enable) {
+      shards_.reset(new shards);
+      return;
+    }
+    drain();
+    shards_.reset();
+  }
+
+  /**
+   * Record a new capture, return a reference to the stored value.
+   *
+   * This function bypasses the thread-safe mode, see append().
+   */
+  value_type & push_back(value_type && v) {
+    return store(std::move(v));
+  }
+
+  /**
+   * Construct a new capture in place, return a reference to it.
+   *
+   * Once the buffer is full the oldest capture is replaced by the
+   * new capture, see overwrite().
+   */
+  template<typename... arg_types>
+  value_type & emplace_back(arg_types&&... args) {
+    ++total_;
+    if (not full()) {
+      sequence_.emplace_back(std::forward<arg_types>(args)...);
+      return sequence_.back();
+    }
+    return overwrite(value_type(std::forward<arg_types>(args)...));
+  }
+
+  /**
+   * Only retain the last @a capacity captures.
+   *
+   * A capacity of 0 retains all the captures.  If there are more
+   * captures than the new capacity the oldest ones are dropped.
+   */
+  void set_capacity(std::size_t capacity) {
+    drain();
+    linearize();
+    if (capacity != 0 and overwritable::value
+        and sequence_.size() > capacity) {
+      drop_front(
+          sequence_.size() - capacity,
+          std::is_move_assignable<value_type>());
+    }
+    capacity_ = capacity;
+  }
+
+  /// Discard all the captures, and reset the call count.
+  void clear() {
+    if (shards_) {
+      shards_->clear();
+    }
+    sequence_.clear();
+    head_ = 0;
+    total_ = 0;
+  }
+
+  //@{
+  /**
+   * @name Accessors
+   */
+  std::size_t capacity() const {
+    return capacity_;
+  }
+  bool thread_safe() const {
+    return bool(shards_);
+  }
+  /// The number of calls recorded, including any dropped captures.
+  std::size_t call_count() const {
+    drain();
+    return total_;
+  }
+  /// The number of captures dropped to honor the capacity.
+  std::size_t dropped() const {
+    drain();
+    return total_ - sequence_.size();
+  }
+  /// The number of captures retained.
+  std::size_t size() const {
+    drain();
+    return sequence_.size();
+  }
+  bool empty() const {
+    drain();
+    return sequence_.empty();
+  }
+
+  /// The retained captures, in call order.
+  sequence_type const & sequence() const {
+    drain();
+    linearize();
+    return sequence_;
+  }
+  const_iterator begin() const {
+    return sequence().begin();
+  }
+  const_iterator end() const {
+    return sequence().end();
+  }
+  value_type & at(std::size_t i) {
+    drain();
+    linearize();
+    return sequence_.at(i);
+  }
+  value_type const & at(std::size_t i) const {
+    return sequence().at(i);
+  }
+  //@}
+
+ private:
+  /**
+   * Move the captures recorded by other threads into the buffer.
+   *
+   * The captures are examined through const accessors, so the merged
+   * state is mutable, as in linearize().
+   */
+  void drain() const {
+    if (not shards_) {
+      return;
+    }
+    shards_->drain([this](value_type && v) { store(std::move(v)); });
+  }
+
+  /// Store a capture, shared by push_back() and drain().
+  value_type & store(value_type && v) const {
+    ++total_;
+    if (not full()) {
+      sequence_.push_back(std::move(v));
+      return sequence_.back();
+    }
+    return overwrite(std::move(v));
+  }
+
+  /// Return true if a new capture must replace the oldest one.
+  bool full() const {
+    return overwritable::value
+        and capacity_ != 0 and sequence_.size() >= capacity_;
+  }
+
+  /// Replace the oldest capture with @a v.
+  value_type & overwrite(value_type && v) const {
+    value_type & slot = sequence_[head_];
+    replace(slot, std::move(v), std::is_move_assignable<value_type>());
+    head_ = (head_ + 1) % capacity_;
+    return slot;
+  }
+
+  static void replace(value_type & slot, value_type && v, std::true_type) {
+    slot = std::move(v);
+  }
+  static void replace(value_type & slot, value_type && v, std::false_type) {
+    // ... only used if the move constructor does not throw ...
+    slot.~value_type();
+    new(&slot) value_type(std::move(v));
+  }
+
+  /// Rotate the ring buffer so the oldest capture is the first element.
+  void linearize() const {
+    if (head_ == 0) {
+      return;
+    }
+    rotate(std::is_move_assignable<value_type>());
+    head_ = 0;
+  }
+
+  void rotate(std::true_type) const {
+    std::rotate(sequence_.begin(), sequence_.begin() + head_, sequence_.end());
+  }
+  void rotate(std::false_type) const {
+    sequence_type tmp;
+    tmp.reserve(sequence_.size());
+    for (std::size_t i = 0; i != sequence_.size(); ++i) {
+      tmp.push_back(std::move(sequence_[(head_ + i) % sequence_.size()]));
+    }
+    sequence_.swap(tmp);
+  }
+
+  /// Discard the oldest @a count captures, the buffer is linear.
+  void drop_front(std::size_t count, std::true_type) {
+    sequence_.erase(sequence_.begin(), sequence_.begin() + count);
+  }
+  void drop_front(std::size_t count, std::false_type) {
+    sequence_type tmp;
+    tmp.reserve(sequence_.size() - count);
+    for (std::size_t i = count; i != sequence_.size(); ++i) {
+      tmp.push_back(std::move(sequence_[i]));
+    }
+    sequence_.swap(tmp);
+  }
+
+ private:
+  mutable sequence_type sequence_;
+  std::size_t capacity_;
+  mutable std::size_t head_;
+  mutable std::size_t total_;
+  std::unique_ptr<shards> shards_;
+};
+
+} // namespace detail
+} // namespace skye
+
+#endif // skye_detail_capture_buffer_hpp
@@ -0,0 +1,194 @@
+#ifndef skye_detail_capture_shards_hpp
+#define skye_detail_capture_shards_hpp
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace skye {
+namespace detail {
+
+/**
+ * Hold the captures recorded concurrently by multiple threads.
+ *
+ * Each thread appends to its own shard, so calls from different
+ * threads only contend on the shard registry the first time a thread
+ * calls the mock.  Every capture is tagged with a global sequence
+ * number, assigned while the shard is locked, and drain() merges the
+ * shards in sequence number order.  Therefore the merged order is
+ * consistent with the order of the calls: if a call happens-before
+ * another, it has a smaller sequence number.
+ *
+ * @tparam sequence_type the container used to hold the captures, as
+ *   defined by the capture strategy.
+ */
+template<typename sequence_type>
+class capture_shards {
+ public:
+  typedef typename sequence_type::value_type value_type;
+
+  /// The captures recorded by a single thread.
+  struct shard {
+    explicit shard(std::thread::id o)
+        : owner(o)
+        , mu()
+        , sequence_numbers()
+        , values()
+    {}
+
+    std::thread::id owner;
+    std::mutex mu;
+    std::vector<std::uint64_t> sequence_numbers;
+    sequence_type values;
+  };
+
+  capture_shards()
+      : id_(next_instance_id())
+      , mu_()
+      , shards_()
+      , next_sequence_number_(0)
+      , positions_()
+  {}
+  capture_shards(capture_shards const &) = delete;
+  capture_shards & operator=(capture_shards const &) = delete;
+
+  /// Return the shard for the calling thread, creating it if needed.
+  shard & local_shard() {
+    thread_cache & cache = local_cache();
+    for (auto const & e : cache.entries) {
+      if (e.instance == id_) {
+        return *e.local;
+      }
+    }
+    shard * s = find_or_create(std::this_thread::get_id());
+    cache.entries[cache.next] = cache_entry{id_, s};
+    cache.next = (cache.next + 1) % cache_size;
+    return *s;
+  }
+
+  /**
+   * Append a capture to @a s.
+   *
+   * The caller must hold the lock for @a s.
+   */
+  value_type & push_back(shard & s, value_type && v) {
+    s.sequence_numbers.push_back(next_sequence_number_++);
+    s.values.push_back(std::move(v));
+    return s.values.back();
+  }
+
+  /**
+   * Construct a capture in place at the end of @a s.
+   *
+   * The caller must hold the lock for @a s.
+   */
+  template<typename... arg_types>
+  value_type & emplace_back(shard & s, arg_types&&... args) {
+    s.sequence_numbers.push_back(next_sequence_number_++);
+    s.values.emplace_back(std::forward<arg_types>(args)...);
+    return s.values.back();
+  }
+
+  /**
+   * Move all the captures, in call order, into @a sink.
+   *
+   * @param sink a functor called with each value_type rvalue.
+   */
+  template<typename functor>
+  void drain(functor && sink) {
+    std::lock_guard<std::mutex> registry_lock(mu_);
+    // ... lock all the shards before examining any of them, any
+    // capture appended after this point has a larger sequence number
+    // than all the captures drained ...
+    std::vector<std::unique_lock<std::mutex>> locks;
+    locks.reserve(shards_.size());
+    for (auto & s : shards_) {
+      locks.emplace_back(s->mu);
+    }
+    positions_.assign(shards_.size(), 0);
+    for (;;) {
+      std::size_t best = shards_.size();
+      std::uint64_t best_number = 0;
+      for (std::size_t i = 0; i != shards_.size(); ++i) {
+        shard const & s = *shards_[i];
+        if (positions_[i] == s.sequence_numbers.size()) {
+          continue;
+        }
+        std::uint64_t n = s.sequence_numbers[positions_[i]];
+        if (best == shards_.size() or n < best_number) {
+          best = i;
+          best_number = n;
+        }
+      }
+      if (best == shards_.size()) {
+        break;
+      }
+      sink(std::move(shards_[best]->values[positions_[best]]));
+      ++positions_[best];
+    }
+    for (auto & s : shards_) {
+      s->sequence_numbers.clear();
+      s->values.clear();
+    }
+  }
+
+  /// Discard all the captures not drained yet.
+  void clear() {
+    std::lock_guard<std::mutex> registry_lock(mu_);
+    for (auto & s : shards_) {
+      std::lock_guard<std::mutex> lock(s->mu);
+      s->sequence_numbers.clear();
+      s->values.clear();
+    }
+  }
+
+ private:
+  shard * find_or_create(std::thread::id owner) {
+    std::lock_guard<std::mutex> registry_lock(mu_);
+    for (auto & s : shards_) {
+      if (s->owner == owner) {
+        return s.get();
+      }
+    }
+    shards_.emplace_back(new shard(owner));
+    return shards_.back().get();
+  }
+
+  /// Each object gets a unique id, used to key the per-thread cache.
+  static std::uint64_t next_instance_id() {
+    static std::atomic<std::uint64_t> next(1);
+    return next++;
+  }
+
+  static std::size_t const cache_size = 8;
+  struct cache_entry {
+    std::uint64_t instance;
+    shard * local;
+  };
+  /// A small per-thread cache mapping objects to shards.
+  struct thread_cache {
+    cache_entry entries[cache_size];
+    std::size_t next;
+  };
+  static thread_cache & local_cache() {
+    static thread_local thread_cache cache = {};
+    return cache;
+  }
+
+ private:
+  std::uint64_t const id_;
+  std::mutex mu_;
+  std::vector<std::unique_ptr<shard>> shards_;
+  std::atomic<std::uint64_t> next_sequence_number_;
+  std::vector<std::size_t> positions_;
+};
+
+} // namespace detail
+} // namespace skye
+
+#endif // skye_detail_capture_shards_hpp
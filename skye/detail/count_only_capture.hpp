@@ -0,0 +1,230 @@
+#ifndef skye_detail_count_only_capture_hpp
+#define skye_detail_count_only_capture_hpp
+
+#include <skye/detail/function_assertion.hpp>
+
+#include <boost/iterator/iterator_facade.hpp>
+
+#include <cstddef>
+#include <iostream>
+#include <iterator>
+#include <stdexcept>
+
+namespace skye {
+namespace detail {
+
+/**
+ * The (empty) capture recorded by count_only_capture.
+ */
+struct call_marker {
+  bool operator==(call_marker const &) const {
+    return true;
+  }
+  bool operator!=(call_marker const &) const {
+    return false;
+  }
+};
+
+inline std::ostream & operator<<(std::ostream & os, call_marker const &) {
+  return os << "[::call_marker::]";
+}
+
+/**
+ * Iterate over a counting_sequence.
+ *
+ * All the elements in a counting_sequence are identical, so the
+ * iterator only needs a position and the address of the single
+ * element.
+ */
+template<typename value_type>
+class counting_sequence_iterator
+    : public boost::iterator_facade<
+  counting_sequence_iterator<value_type>, value_type,
+  std::random_access_iterator_tag> {
+ public:
+  counting_sequence_iterator()
+      : element_(nullptr)
+      , position_(0)
+  {}
+  counting_sequence_iterator(value_type * element, std::size_t position)
+      : element_(element)
+      , position_(position)
+  {}
+
+ private:
+  friend class boost::iterator_core_access;
+
+  value_type & dereference() const {
+    return *element_;
+  }
+  bool equal(counting_sequence_iterator const & rhs) const {
+    return position_ == rhs.position_;
+  }
+  void increment() {
+    ++position_;
+  }
+  void decrement() {
+    --position_;
+  }
+  void advance(std::ptrdiff_t n) {
+    position_ += n;
+  }
+  std::ptrdiff_t distance_to(counting_sequence_iterator const & rhs) const {
+    return std::ptrdiff_t(rhs.position_) - std::ptrdiff_t(position_);
+  }
+
+ private:
+  value_type * element_;
+  std::size_t position_;
+};
+
+/**
+ * A container that only counts its elements.
+ *
+ * Implements the subset of the std::vector<> interface used by
+ * capture_buffer and function_assertion, but never stores (or
+ * allocates) any element.
+ */
+template<typename value_type_T>
+class counting_sequence {
+ public:
+  typedef value_type_T value_type;
+  typedef counting_sequence_iterator<value_type> iterator;
+  typedef iterator const_iterator;
+
+  counting_sequence()
+      : element_()
+      , size_(0)
+  {}
+  counting_sequence(counting_sequence const & rhs)
+      : element_()
+      , size_(rhs.size_)
+  {}
+  counting_sequence & operator=(counting_sequence const & rhs) {
+    size_ = rhs.size_;
+    return *this;
+  }
+
+  void push_back(value_type const &) {
+    ++size_;
+  }
+  void clear() {
+    size_ = 0;
+  }
+  void swap(counting_sequence & rhs) {
+    std::swap(size_, rhs.size_);
+  }
+  iterator erase(const_iterator first, const_iterator last) {
+    size_ -= std::distance(first, last);
+    return first;
+  }
+
+  //@{
+  /**
+   * @name Accessors
+   */
+  std::size_t size() const {
+    return size_;
+  }
+  bool empty() const {
+    return size_ == 0;
+  }
+  iterator begin() const {
+    return iterator(&element_, 0);
+  }
+  iterator end() const {
+    return iterator(&element_, size_);
+  }
+  value_type & back() const {
+    return element_;
+  }
+  value_type & operator[](std::size_t) const {
+    return element_;
+  }
+  value_type & at(std::size_t i) const {
+    if (i >= size_) {
+      throw std::out_of_range("counting_sequence::at() - index out of range");
+    }
+    return element_;
+  }
+  //@}
+
+ private:
+  mutable value_type element_;
+  std::size_t size_;
+};
+
+/**
+ * Define a strategy to count calls without capturing any arguments.
+ *
+ * Many tests only verify how many times a mock was called, with
+ * exactly(), never(), at_least() and friends.  This strategy avoids
+ * copying the arguments on each call, each capture is an empty
+ * call_marker, and the capture sequence only holds a counter.  It can
+ * be used with both mock_function and mock_template_function:
+ *
+ * @code
+ * mock_function<void(std::string const&), detail::count_only_capture> f;
+ * mock_template_function<void, detail::count_only_capture> g;
+ * @endcode
+ *
+ * Naturally the arguments cannot be examined, so with() assertions and
+ * when() conditional returns are rejected at compile time.
+ */
+struct count_only_capture {
+  /// A single argument capture.
+  typedef call_marker value_type;
+
+  /// The type representing a sequence of argument captures.
+  typedef counting_sequence<call_marker> capture_sequence;
+
+  /// Capture a set of arguments, by ignoring them.
+  template<typename... arg_types>
+  static value_type capture(arg_types&&...) {
+    return value_type();
+  }
+
+  /// Capture a set of arguments directly into a capture_buffer.
+  template<typename buffer_type, typename... arg_types>
+  static value_type & capture_into(buffer_type & buffer, arg_types&&...) {
+    return buffer.push_back(value_type());
+  }
+
+  static bool equals(value_type const &, value_type const &) {
+    return true;
+  }
+
+  static bool hashable(value_type const &) {
+    return false;
+  }
+
+  static std::size_t hash(value_type const &) {
+    return 0;
+  }
+
+  template<typename... arg_types>
+  static std::size_t hash_arguments(arg_types const &...) {
+    return 0;
+  }
+
+  template<typename... arg_types>
+  static bool matches(value_type const &, arg_types const &...) {
+    return true;
+  }
+
+  static void stream(std::ostream & os, value_type const & x) {
+    os << x;
+  }
+};
+
+/**
+ * The count_only_capture strategy does not record argument values.
+ */
+template<>
+struct captures_arguments<count_only_capture> : public std::false_type {
+};
+
+} // namespace detail
+} // namespace skye
+
+#endif // skye_detail_count_only_capture_hpp
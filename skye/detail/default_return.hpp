@@ -12,7 +12,7 @@ return_type default_return() {
 }
 
 template<>
-void default_return<void>() {
+inline void default_return<void>() {
 }
 
 } // namespace detail
@@ -0,0 +1,70 @@
+#ifndef skye_detail_extern_templates_hpp
+#define skye_detail_extern_templates_hpp
+
+/**
+ * @file
+ *
+ * Explicit instantiations for the most common mocks.
+ *
+ * Skye is a header-only library, so each test translation unit
+ * instantiates the same mocks, for example mock_function<void()>.
+ * With SKYE_USE_COMPILED_LIBRARY defined the Skye headers include
+ * this file, which declares those instantiations as extern
+ * templates, and the tests link skye/lib_skye.a instead (configure
+ * with --enable-compiled-library).
+ *
+ * skye/compiled_library.cpp defines SKYE_COMPILING_LIBRARY to turn
+ * the same declarations into explicit instantiation definitions, so
+ * the list is only maintained here.  The library instantiates the
+ * check() and require() functions with the default reporting
+ * strategies, so it must be compiled with the same
+ * SKYE_USE_*_REPORTING or SKYE_USE_*_FRAMEWORK macros as the tests.
+ */
+
+#if defined(SKYE_COMPILING_LIBRARY)
+#  define SKYE_EXTERN_TEMPLATE template
+#else
+#  define SKYE_EXTERN_TEMPLATE extern template
+#endif // SKYE_COMPILING_LIBRARY
+
+#include <skye/mock_function.hpp>
+#include <skye/mock_template_function.hpp>
+
+namespace skye {
+
+SKYE_EXTERN_TEMPLATE class mock_function<void()>;
+SKYE_EXTERN_TEMPLATE class mock_function<bool()>;
+SKYE_EXTERN_TEMPLATE class mock_function<int()>;
+
+SKYE_EXTERN_TEMPLATE class mock_template_function<void>;
+SKYE_EXTERN_TEMPLATE class mock_template_function<bool>;
+SKYE_EXTERN_TEMPLATE class mock_template_function<int>;
+
+namespace detail {
+
+/**
+ * Instantiate the classes shared by all the mocks using @a capture.
+ *
+ * @a extern_template is either SKYE_EXTERN_TEMPLATE or the equivalent
+ * macro for another library.
+ */
+#define SKYE_EXTERN_TEMPLATE_CAPTURE(extern_template, capture) \
+  extern_template class capture_buffer<capture::capture_sequence>; \
+  extern_template class validator<capture::capture_sequence>; \
+  extern_template class at_least_validator<capture::capture_sequence>; \
+  extern_template class at_most_validator<capture::capture_sequence>; \
+  extern_template class exactly_validator< \
+    capture::capture_sequence, false>; \
+  extern_template class exactly_validator< \
+    capture::capture_sequence, true>
+
+// ... mock_function<R()> shares the capture for any R ...
+SKYE_EXTERN_TEMPLATE_CAPTURE(
+    SKYE_EXTERN_TEMPLATE, mock_function<void()>::capture_strategy);
+SKYE_EXTERN_TEMPLATE_CAPTURE(
+    SKYE_EXTERN_TEMPLATE, unknown_arguments_capture_by_value);
+
+} // namespace detail
+} // namespace skye
+
+#endif // skye_detail_extern_templates_hpp
@@ -2,8 +2,9 @@
 #define skye_detail_function_assertion_hpp
 
 #include <skye/detail/validator.hpp>
-#include <boost/range/adaptor/reversed.hpp>
+#include <skye/detail/watch_table.hpp>
 
+#include <chrono>
 #include <list>
 #include <memory>
 #include <string>
@@ -13,6 +14,58 @@
 namespace skye {
 namespace detail {
 
+/**
+ * Determine if a capture strategy records the argument values.
+ *
+ * Most strategies do, but some only count the calls, those
+ * specialize this trait so filters such as with() can be rejected at
+ * compile time.
+ */
+template<typename capture_strategy>
+struct captures_arguments : public std::true_type {
+};
+
+/**
+ * The structured result of an assertion.
+ *
+ * Reporting strategies that record more than the assertion message
+ * define a static report_record() member function, which receives
+ * these records.  See json_reporting.
+ */
+struct assertion_record {
+  /// Where the assertion was made.
+  location where;
+  /// True if the assertion passed.
+  bool pass;
+  /// The number of calls to the mock, including the dropped ones.
+  std::size_t call_count;
+  /// The number of retained calls that passed the filters.
+  std::size_t matched;
+  /// The number of calls dropped by the mock, see dropped_calls().
+  std::size_t dropped;
+  /// The time spent validating, including formatting the message.
+  std::chrono::nanoseconds validation_time;
+  /// The assertion message, null if it was not formatted.
+  std::string const * message;
+};
+
+/**
+ * Determine if a reporting strategy receives assertion_record objects.
+ */
+template<typename reporting_strategy>
+struct has_report_record {
+ private:
+  template<typename T>
+  static auto test(int) -> decltype(
+      T::report_record(std::declval<assertion_record const &>()),
+      std::true_type());
+  template<typename T>
+  static std::false_type test(...);
+
+ public:
+  static constexpr bool value = decltype(test<reporting_strategy>(0))::value;
+};
+
 /**
  * Build a validation check, executes it and then reports the results.
  *
@@ -60,6 +113,27 @@ namespace detail {
  * The never() quantifier short-circuits validation, that means that
  * whatever results from subsequent validators are ignored.
  *
+ * Validation makes a single pass over the captures, without copying
+ * them: each capture is checked against the filters (such as
+ * with()), and the remaining validators are evaluated against the
+ * number of captures that passed.  Without filters no pass is needed
+ * at all.
+ *
+ * The assertion refers to the captures in the mock function, so it
+ * must not outlive the mock.
+ *
+ * If the assertion has a single with() filter, and the mock counts
+ * the calls for that value (see mock_function::watch()), the counter
+ * is used and the captures are not examined at all.
+ *
+ * The assertion message is only formatted if the assertion fails, or
+ * if the reporting strategy logs successful assertions.
+ *
+ * If the mock function only retains its most recent captures (see
+ * mock_function::set_capture_capacity()) the validators only examine
+ * the retained captures, and the assertion message reports how many
+ * older calls were dropped.
+ *
  * @tparam capture_strategy_T how was the underlying mock function
  * capturing its arguments.
  * @tparam reporting_strategy_T how are assertion results supposed to
@@ -74,11 +148,25 @@ class function_assertion {
   typedef typename capture_strategy::value_type value_type;
   typedef typename capture_strategy::capture_sequence sequence_type;
   typedef std::shared_ptr<validator<sequence_type>> pointer;
+  typedef watch_table<capture_strategy> watches;
 
   function_assertion(
       sequence_type const & sequence, location const & where)
+      : function_assertion(sequence, 0, nullptr, where)
+  {}
+  function_assertion(
+      sequence_type const & sequence, std::size_t dropped,
+      location const & where)
+      : function_assertion(sequence, dropped, nullptr, where)
+  {}
+  function_assertion(
+      sequence_type const & sequence, std::size_t dropped,
+      watches const * watched, location const & where)
       : validators_()
+      , filters_()
       , sequence_(sequence)
+      , dropped_(dropped)
+      , watched_(watched)
       , where_(where) {
     reporting_strategy::checkpoint(where_);
   }
@@ -130,18 +218,19 @@ class function_assertion {
   /// Filters to only the calls with the given value.
   template<typename... arg_types>
   function_assertion & with(arg_types&&... args) {
+    static_assert(
+        captures_arguments<capture_strategy>::value,
+        "with() requires a capture strategy that records the arguments");
     auto match = capture_strategy::capture(std::forward<arg_types>(args)...);
     return with(std::move(match));
   }
 
   function_assertion & with(value_type && m) {
-    value_type match(m);
-    std::ostringstream os;
-    capture_strategy::stream(os, match);
-    add_validator(
-        make_negative_filter<sequence_type>( os.str(), [match](value_type v) {
-            return not capture_strategy::equals(match, v);
-          }));
+    static_assert(
+        captures_arguments<capture_strategy>::value,
+        "with() requires a capture strategy that records the arguments");
+    add_validator(pointer(
+        new match_filter<sequence_type,capture_strategy>(std::move(m))));
     return *this;
   }
                          
@@ -149,26 +238,77 @@ class function_assertion {
 
  private:
   void add_validator(pointer v) {
-    validators_.push_back(v);
+    if (v->filters()) {
+      filters_.push_back(v.get());
+    }
+    validators_.push_back(std::move(v));
   }
 
-  void validate() {
-    sequence_type sequence;
-    sequence.swap(sequence_); // We no longer need the contents of sequence_
-
-    for (auto i : boost::adaptors::reverse(validators_)) {
-      i->filter(sequence);
+  /// Count the captures that pass all the filters.
+  std::size_t filtered_count() const {
+    if (filters_.empty()) {
+      return sequence_.size();
+    }
+    std::size_t count = 0;
+    // ... the counters include the dropped captures, only use them if
+    // there are none ...
+    if (watched_ != nullptr and dropped_ == 0 and filters_.size() == 1) {
+      auto match = filters_.front()->exact_match();
+      if (match != nullptr and watched_->lookup(*match, count)) {
+        return count;
+      }
+    }
+    for (auto const & capture : sequence_) {
+      bool accepted = true;
+      for (auto const * f : filters_) {
+        if (not f->accept(capture)) {
+          accepted = false;
+          break;
+        }
+      }
+      if (accepted) {
+        ++count;
+      }
     }
+    return count;
+  }
+
+  typedef std::integral_constant<
+    bool, has_report_record<reporting_strategy>::value> records;
+
+  void validate() {
+    // ... only measure the time if somebody wants it ...
+    auto const start = now(records());
+    std::size_t const sequence_size = sequence_.size();
+    std::size_t const count = filtered_count();
 
     validation_result r{true,false,std::string()};
-    std::string msg = "check_called()";
-    for (auto i : validators_) {
-      r = i->validate(sequence);
-      msg += r.msg;
+    auto last = validators_.begin();
+    for (; last != validators_.end(); ++last) {
+      r = (*last)->validate_count(count);
       if (not r.pass or r.short_circuit) {
+        ++last;
         break;
       }
     }
+    if (r.pass and not reporting_strategy::success_logging_enabled()) {
+      record(records(), start, true, count, nullptr);
+      reporting_strategy::report_success(where_, "check_called()");
+      return;
+    }
+
+    std::ostringstream os;
+    os << "check_called()";
+    for (auto i = validators_.begin(); i != last; ++i) {
+      (*i)->describe(os, count);
+    }
+    if (dropped_ != 0) {
+      os << " [only the last " << sequence_size
+         << " calls were retained, " << dropped_
+         << " older calls were dropped]";
+    }
+    std::string const msg = os.str();
+    record(records(), start, r.pass, count, &msg);
     if (r.pass) {
       reporting_strategy::report_success(where_, msg);
     } else {
@@ -176,9 +316,39 @@ class function_assertion {
     }
   }
 
+  //@{
+  /**
+   * @name Build the assertion_record, if the strategy wants it.
+   */
+  static std::chrono::steady_clock::time_point now(std::true_type) {
+    return std::chrono::steady_clock::now();
+  }
+  static std::chrono::steady_clock::time_point now(std::false_type) {
+    return std::chrono::steady_clock::time_point();
+  }
+
+  void record(
+      std::true_type, std::chrono::steady_clock::time_point start,
+      bool pass, std::size_t matched, std::string const * msg) const {
+    assertion_record const r{
+      where_, pass, sequence_.size() + dropped_, matched, dropped_,
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::steady_clock::now() - start),
+      msg};
+    reporting_strategy::report_record(r);
+  }
+  void record(
+      std::false_type, std::chrono::steady_clock::time_point,
+      bool, std::size_t, std::string const *) const {
+  }
+  //@}
+
  private:
   std::list<pointer> validators_;
-  sequence_type sequence_;
+  std::list<validator<sequence_type> const *> filters_;
+  sequence_type const & sequence_;
+  std::size_t dropped_;
+  watches const * watched_;
   location where_;
 };
 
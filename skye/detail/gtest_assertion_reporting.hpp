@@ -0,0 +1,51 @@
+#ifndef skye_detail_gtest_assertion_reporting_hpp
+#define skye_detail_gtest_assertion_reporting_hpp
+
+#include <skye/detail/hook_assertion_reporting.hpp>
+#include <gtest/gtest.h>
+
+namespace skye {
+namespace detail {
+
+/**
+ * An assertion_hooks::report() function for googletest.
+ *
+ * Failures are recorded as googletest failures, at the location of
+ * the Skye assertion, so they fail the current test.  Failed
+ * required assertions are recorded as fatal failures.
+ */
+inline void gtest_report(
+    location const & where, std::string const & msg, bool pass,
+    bool fatal) {
+  if (pass) {
+    return;
+  }
+  GTEST_MESSAGE_AT_(
+      where.file, where.line, msg.c_str(),
+      fatal ? ::testing::TestPartResult::kFatalFailure
+            : ::testing::TestPartResult::kNonFatalFailure);
+}
+
+/**
+ * Route the Skye assertions to googletest.
+ *
+ * Call it from main(), before RUN_ALL_TESTS(), or register a
+ * gtest_hooks_environment.  The tests must be compiled with
+ * SKYE_USE_LIGHTWEIGHT_TEST_FRAMEWORK defined.
+ */
+inline void install_gtest_hooks() {
+  assertion_hooks::report() = &gtest_report;
+}
+
+/// A googletest environment that calls install_gtest_hooks().
+class gtest_hooks_environment : public ::testing::Environment {
+ public:
+  virtual void SetUp() {
+    install_gtest_hooks();
+  }
+};
+
+} // namespace detail
+} // namespace skye
+
+#endif // skye_detail_gtest_assertion_reporting_hpp
@@ -0,0 +1,138 @@
+#ifndef skye_detail_hook_assertion_reporting_hpp
+#define skye_detail_hook_assertion_reporting_hpp
+
+#include <skye/detail/validator.hpp>
+
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+namespace skye {
+namespace detail {
+
+/**
+ * Raised by hook_require_reporting when a required assertion fails.
+ *
+ * Test runners catch this exception to abort the current test case.
+ */
+class assertion_aborted : public std::runtime_error {
+ public:
+  explicit assertion_aborted(std::string const & msg)
+      : std::runtime_error(msg)
+  {}
+};
+
+/**
+ * The functions used by hook_check_reporting and
+ * hook_require_reporting.
+ *
+ * This is the integration point with a test framework: a framework
+ * (see skye/lightweight_test.hpp and gtest_assertion_reporting.hpp)
+ * replaces the hooks, usually once, before the tests run.  The
+ * defaults print the failures to std::cerr.  The hooks are plain
+ * function pointers, and are not synchronized, set them before
+ * starting any threads.
+ *
+ * The hooks are function-local statics, so they can be defined in a
+ * header, use the accessors to read or replace them:
+ *
+ * @code
+ * skye::detail::assertion_hooks::report() = &my_report;
+ * @endcode
+ */
+struct assertion_hooks {
+  /// Report the result of an assertion, @a fatal for require().
+  typedef void (*report_function)(
+      location const & where, std::string const & msg, bool pass,
+      bool fatal);
+  /// Record the location of the last assertion.
+  typedef void (*checkpoint_function)(location const & where);
+
+  /// The function called with the result of each assertion.
+  static report_function & report() {
+    static report_function f = &report_to_stderr;
+    return f;
+  }
+  /// The function called before each assertion, or null.
+  static checkpoint_function & checkpoint() {
+    static checkpoint_function f = nullptr;
+    return f;
+  }
+  /// If true, the messages for successful assertions are formatted.
+  static bool & log_successes() {
+    static bool enabled = false;
+    return enabled;
+  }
+
+  /// The default report function.
+  static void report_to_stderr(
+      location const & where, std::string const & msg, bool pass,
+      bool fatal) {
+    if (pass) {
+      return;
+    }
+    std::cerr << where.file << ":" << where.line << ": "
+              << (fatal ? "required" : "checked")
+              << " assertion failure: " << msg << "\n";
+  }
+};
+
+/// Report through the assertion_hooks, with no further action on
+/// failures.
+struct hook_check_reporting {
+  /// Checkpoint progress through the unit test
+  static void checkpoint(location const & where) {
+    if (assertion_hooks::checkpoint() != nullptr) {
+      assertion_hooks::checkpoint()(where);
+    }
+  }
+
+  /// Return true if successful assertions are logged.
+  static bool success_logging_enabled() {
+    return assertion_hooks::log_successes();
+  }
+
+  /// Report a successful assertion.
+  static void report_success(
+      location const & where, std::string const & msg) {
+    assertion_hooks::report()(where, msg, true, false);
+  }
+
+  /// Report an assertion failure.
+  static void report_failure(
+      location const & where, std::string const & msg) {
+    assertion_hooks::report()(where, msg, false, false);
+  }
+};
+
+/// Report through the assertion_hooks, and raise assertion_aborted on
+/// failures.
+struct hook_require_reporting {
+  /// Checkpoint progress through the unit test
+  static void checkpoint(location const & where) {
+    hook_check_reporting::checkpoint(where);
+  }
+
+  /// Return true if successful assertions are logged.
+  static bool success_logging_enabled() {
+    return assertion_hooks::log_successes();
+  }
+
+  /// Report a successful assertion.
+  static void report_success(
+      location const & where, std::string const & msg) {
+    assertion_hooks::report()(where, msg, true, true);
+  }
+
+  /// Report an assertion failure.
+  static void report_failure(
+      location const & where, std::string const & msg) {
+    assertion_hooks::report()(where, msg, false, true);
+    throw assertion_aborted(msg);
+  }
+};
+
+} // namespace detail
+} // namespace skye
+
+#endif // skye_detail_hook_assertion_reporting_hpp
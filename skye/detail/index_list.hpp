@@ -0,0 +1,35 @@
+#ifndef skye_detail_index_list_hpp
+#define skye_detail_index_list_hpp
+
+#include <cstddef>
+
+namespace skye {
+namespace detail {
+
+/**
+ * A compile-time list of indices, a C++11 std::index_sequence.
+ *
+ * Functions over tuples expand the indices in a single function
+ * template, instead of recursing over a class template
+ * parameterized by the tuple type.  The list only depends on the
+ * tuple size, so all the tuples of the same size share its
+ * instantiations.
+ */
+template<std::size_t... I>
+struct index_list {
+};
+
+/// Build index_list<0, 1, ..., N-1>.
+template<std::size_t N, std::size_t... I>
+struct make_index_list : public make_index_list<N - 1, N - 1, I...> {
+};
+
+template<std::size_t... I>
+struct make_index_list<0, I...> {
+  typedef index_list<I...> type;
+};
+
+} // namespace detail
+} // namespace skye
+
+#endif // skye_detail_index_list_hpp
@@ -9,16 +9,23 @@
 namespace skye {
 namespace detail {
 
+/// Format an assertion result, without a trailing newline
+inline void iostream_format_common(
+    std::ostream & os, location const & where, std::string const & msg,
+    std::string const & severity, bool success) {
+  os << severity << " assertion"
+     << "(" << where.file << ":" << where.line << ") "
+     << (success ? "success" : "failure")
+     << ": "
+     << msg;
+}
+
 /// Common logging function for Boost.Test reporting
 inline void iostream_log_common(
     location const & where, std::string const & msg,
     std::string const & severity, bool success) {
-  std::cerr << severity << " assertion"
-            << "(" << where.file << ":" << where.line << ") "
-            << (success ? "success" : "failure")
-            << ": "
-            << msg
-            << std::endl;
+  iostream_format_common(std::cerr, where, msg, severity, success);
+  std::cerr << std::endl;
 }
 
 /// Report to stderr, with no further action on failures.
@@ -27,6 +34,11 @@ struct iostream_check_reporting {
   static void checkpoint(location const & ) {
   }
 
+  /// Return true if successful assertions are logged.
+  static bool success_logging_enabled() {
+    return true;
+  }
+
   /// Report a successful assertion.
   static void report_success(
       location const & where, std::string const & msg) {
@@ -46,6 +58,11 @@ struct iostream_require_reporting {
   static void checkpoint(location const & ) {
   }
 
+  /// Return true if successful assertions are logged.
+  static bool success_logging_enabled() {
+    return true;
+  }
+
   /// Report a successful assertion.
   static void report_success(
       location const & where, std::string const & msg) {
@@ -0,0 +1,218 @@
+#ifndef skye_detail_json_assertion_reporting_hpp
+#define skye_detail_json_assertion_reporting_hpp
+
+#include <skye/detail/function_assertion.hpp>
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <mutex>
+#include <ostream>
+#include <sstream>
+#include <string>
+
+namespace skye {
+namespace detail {
+
+/// Write @a s as a JSON string, with quotes and escapes.
+inline void json_escape(std::ostream & os, char const * s) {
+  os << '"';
+  for (; *s != '\0'; ++s) {
+    unsigned char const c = static_cast<unsigned char>(*s);
+    switch (c) {
+      case '"': os << "\\\""; break;
+      case '\\': os << "\\\\"; break;
+      case '\n': os << "\\n"; break;
+      case '\r': os << "\\r"; break;
+      case '\t': os << "\\t"; break;
+      default:
+        if (c < 0x20) {
+          char buf[8];
+          std::snprintf(buf, sizeof(buf), "\\u%04x", c);
+          os << buf;
+        } else {
+          os << *s;
+        }
+    }
+  }
+  os << '"';
+}
+
+/**
+ * Write a machine-readable report of the assertions and mocks.
+ *
+ * Each assertion (see json_reporting) and each mock (see
+ * json_report_mock()) produces a JSON object in a single line, for
+ * example:
+ *
+ * @verbatim
+ * {"type":"assertion","outcome":"pass","file":"t.cpp","line":42,
+ *  "function":"my_test","call_count":3,"matched":3,"dropped":0,
+ *  "validation_ns":812}
+ * {"type":"mock","name":"f","call_count":3,"dropped":0}
+ * @endverbatim
+ *
+ * (each record is a single line in the actual output).  Failed
+ * assertions also include their "message".  Records are easy to
+ * aggregate across test binaries and shards, for example to find the
+ * slowest assertions.
+ *
+ * If the SKYE_JSON_REPORT environment variable is set the report is
+ * appended to the file it names, otherwise it is disabled until
+ * set_stream() is called.  Writing is thread-safe, and the stream is
+ * only flushed after failures and when the report is destroyed.
+ */
+class json_report {
+ public:
+  json_report()
+      : mu_()
+      , file_()
+      , os_(nullptr) {
+    char const * path = std::getenv("SKYE_JSON_REPORT");
+    if (path != nullptr and *path != '\0') {
+      file_.open(path, std::ios::out | std::ios::app);
+      if (file_) {
+        os_ = &file_;
+      }
+    }
+  }
+  ~json_report() {
+    flush();
+  }
+
+  json_report(json_report const &) = delete;
+  json_report & operator=(json_report const &) = delete;
+
+  /// The report shared by all the json_reporting strategies.
+  static json_report & instance() {
+    static json_report report;
+    return report;
+  }
+
+  /// Write the report to @a os, or disable it if null.
+  void set_stream(std::ostream * os) {
+    std::lock_guard<std::mutex> lock(mu_);
+    if (os_ != nullptr) {
+      os_->flush();
+    }
+    os_ = os;
+  }
+
+  /// Return true if the records are written somewhere.
+  bool enabled() const {
+    std::lock_guard<std::mutex> lock(mu_);
+    return os_ != nullptr;
+  }
+
+  /// Write the record for an assertion.
+  void write_assertion(assertion_record const & r) {
+    if (not enabled()) {
+      return;
+    }
+    std::ostringstream os;
+    os << "{\"type\":\"assertion\",\"outcome\":"
+       << (r.pass ? "\"pass\"" : "\"fail\"") << ",\"file\":";
+    json_escape(os, r.where.file);
+    os << ",\"line\":" << r.where.line << ",\"function\":";
+    json_escape(os, r.where.function);
+    os << ",\"call_count\":" << r.call_count
+       << ",\"matched\":" << r.matched
+       << ",\"dropped\":" << r.dropped
+       << ",\"validation_ns\":" << r.validation_time.count();
+    if (not r.pass and r.message != nullptr) {
+      os << ",\"message\":";
+      json_escape(os, r.message->c_str());
+    }
+    os << "}\n";
+    write(os.str(), not r.pass);
+  }
+
+  /// Write the record for a mock.
+  void write_mock(
+      char const * name, std::size_t call_count, std::size_t dropped) {
+    if (not enabled()) {
+      return;
+    }
+    std::ostringstream os;
+    os << "{\"type\":\"mock\",\"name\":";
+    json_escape(os, name);
+    os << ",\"call_count\":" << call_count
+       << ",\"dropped\":" << dropped << "}\n";
+    write(os.str(), false);
+  }
+
+  /// Flush the underlying stream.
+  void flush() {
+    std::lock_guard<std::mutex> lock(mu_);
+    if (os_ != nullptr) {
+      os_->flush();
+    }
+  }
+
+ private:
+  void write(std::string const & line, bool flush) {
+    std::lock_guard<std::mutex> lock(mu_);
+    if (os_ == nullptr) {
+      return;
+    }
+    os_->write(line.data(), line.size());
+    if (flush) {
+      os_->flush();
+    }
+  }
+
+ private:
+  mutable std::mutex mu_;
+  std::ofstream file_;
+  std::ostream * os_;
+};
+
+/**
+ * Add a json_report record to another reporting strategy.
+ *
+ * All the results are still reported to @a base_strategy, so the
+ * test framework sees the failures as usual.
+ *
+ * @tparam base_strategy the reporting strategy to extend.
+ */
+template<typename base_strategy>
+struct json_reporting {
+  /// Checkpoint progress through the unit test
+  static void checkpoint(location const & where) {
+    base_strategy::checkpoint(where);
+  }
+
+  /// Return true if successful assertions are logged.
+  static bool success_logging_enabled() {
+    return base_strategy::success_logging_enabled();
+  }
+
+  /// Report a successful assertion.
+  static void report_success(
+      location const & where, std::string const & msg) {
+    base_strategy::report_success(where, msg);
+  }
+
+  /// Report an assertion failure.
+  static void report_failure(
+      location const & where, std::string const & msg) {
+    base_strategy::report_failure(where, msg);
+  }
+
+  /// Record the assertion, called before report_success/failure().
+  static void report_record(assertion_record const & r) {
+    json_report::instance().write_assertion(r);
+  }
+};
+
+/// Write the json_report record for @a mock.
+template<typename mock_type>
+void json_report_mock(char const * name, mock_type const & mock) {
+  json_report::instance().write_mock(
+      name, mock.call_count(), mock.dropped_calls());
+}
+
+} // namespace detail
+} // namespace skye
+
+#endif // skye_detail_json_assertion_reporting_hpp
@@ -0,0 +1,113 @@
+#ifndef skye_detail_mpsc_queue_hpp
+#define skye_detail_mpsc_queue_hpp
+
+#include <atomic>
+#include <utility>
+
+namespace skye {
+namespace detail {
+
+/**
+ * A lock-free queue with multiple producers and a single consumer.
+ *
+ * This is the intrusive linked list described by Dmitry Vyukov: push()
+ * is a single atomic exchange and never blocks, pop() is only called
+ * by the consumer thread.  A pop() racing with a push() may miss the
+ * value being pushed, which is fine for a consumer that polls.
+ *
+ * @tparam value_type the type of the values, must be movable and
+ *   default constructible.
+ */
+template<typename value_type>
+class mpsc_queue {
+ public:
+  mpsc_queue()
+      : stub_()
+      , head_(&stub_)
+      , tail_(&stub_)
+  {}
+  ~mpsc_queue() {
+    value_type discard;
+    while (pop(discard)) {
+    }
+  }
+
+  mpsc_queue(mpsc_queue const &) = delete;
+  mpsc_queue & operator=(mpsc_queue const &) = delete;
+
+  /// Append @a v to the queue, safe to call from any thread.
+  void push(value_type && v) {
+    push(new node(std::move(v)));
+  }
+
+  /**
+   * Remove the oldest value in the queue, only from the consumer.
+   *
+   * @returns false if the queue is empty.
+   */
+  bool pop(value_type & v) {
+    node * tail = tail_;
+    node * next = tail->next.load(std::memory_order_acquire);
+    if (tail == &stub_) {
+      if (next == nullptr) {
+        return false;
+      }
+      // ... skip the stub, it does not hold a value ...
+      tail_ = next;
+      tail = next;
+      next = next->next.load(std::memory_order_acquire);
+    }
+    if (next != nullptr) {
+      tail_ = next;
+      v = std::move(tail->value);
+      delete tail;
+      return true;
+    }
+    if (tail != head_.load(std::memory_order_acquire)) {
+      // ... a producer is in the middle of push() ...
+      return false;
+    }
+    // ... the last node cannot be removed while it is the head,
+    // push the stub behind it ...
+    push(&stub_);
+    next = tail->next.load(std::memory_order_acquire);
+    if (next == nullptr) {
+      return false;
+    }
+    tail_ = next;
+    v = std::move(tail->value);
+    delete tail;
+    return true;
+  }
+
+ private:
+  struct node {
+    node()
+        : next(nullptr)
+        , value()
+    {}
+    explicit node(value_type && v)
+        : next(nullptr)
+        , value(std::move(v))
+    {}
+
+    std::atomic<node*> next;
+    value_type value;
+  };
+
+  void push(node * n) {
+    n->next.store(nullptr, std::memory_order_relaxed);
+    node * prev = head_.exchange(n, std::memory_order_acq_rel);
+    prev->next.store(n, std::memory_order_release);
+  }
+
+ private:
+  node stub_;
+  std::atomic<node*> head_;
+  node * tail_;
+};
+
+} // namespace detail
+} // namespace skye
+
+#endif // skye_detail_mpsc_queue_hpp
@@ -0,0 +1,206 @@
+#ifndef skye_detail_side_effect_table_hpp
+#define skye_detail_side_effect_table_hpp
+
+#include <skye/detail/argument_wrapper.hpp>
+
+#include <cstddef>
+#include <list>
+#include <tuple>
+#include <unordered_map>
+#include <utility>
+
+namespace skye {
+namespace detail {
+
+/**
+ * Hold the conditional actions (see when() and whenp()) for a mock
+ * function.
+ *
+ * Mocks often register hundreds of when() rules that match exact
+ * argument values.  Those rules are stored in a hash table keyed on
+ * the hash of the arguments, so finding them is O(1) regardless of the
+ * number of rules.  Rules based on general predicates, and exact
+ * rules whose arguments cannot be hashed, are kept in a list and
+ * checked in order.
+ *
+ * The first rule registered that matches a call wins, as if all the
+ * rules were kept in a single list: each rule is tagged with its
+ * registration rank, and the predicates are only checked up to the
+ * rank of the matching exact rule, if any.
+ *
+ * @tparam capture_strategy how the mock captures its arguments,
+ *   provides the hash and equality functions for the exact rules.
+ * @tparam predicate the type of the general predicates.
+ * @tparam return_function the type of the actions.
+ */
+template<typename capture_strategy, typename predicate,
+         typename return_function>
+class side_effect_table {
+ public:
+  typedef typename capture_strategy::value_type value_type;
+
+  side_effect_table()
+      : predicates_()
+      , exact_()
+      , next_rank_(0)
+  {}
+
+  /// Add a rule based on a general predicate.
+  void add(predicate p, return_function f) {
+    predicates_.push_back(predicate_rule{next_rank_++, p, f});
+  }
+
+  /**
+   * Add a rule matching exactly @a match.
+   *
+   * Returns false if the capture cannot be hashed, in that case the
+   * caller should use a predicate instead.
+   */
+  bool add_exact(value_type const & match, return_function f) {
+    if (not capture_strategy::hashable(match)) {
+      return false;
+    }
+    std::size_t const h = capture_strategy::hash(match);
+    // If the key is already present the earlier rule wins, just as it
+    // would when checking the rules in order.
+    auto const range = exact_.equal_range(h);
+    for (auto i = range.first; i != range.second; ++i) {
+      if (capture_strategy::equals(i->second.match, match)) {
+        return true;
+      }
+    }
+    exact_.insert(std::make_pair(h, exact_rule{next_rank_++, match, f}));
+    return true;
+  }
+
+  /**
+   * Find the action for a call.
+   *
+   * @param captured the captured arguments for the call.
+   * @param args the arguments passed to the general predicates.
+   * @returns the first matching action, or nullptr if none matches.
+   */
+  template<typename... call_types>
+  return_function const * find(
+      value_type const & captured, call_types&&... args) const {
+    exact_rule const * exact = nullptr;
+    if (not exact_.empty() and capture_strategy::hashable(captured)) {
+      exact = find_exact(
+          capture_strategy::hash(captured),
+          [&captured](value_type const & x) {
+            return capture_strategy::equals(x, captured);
+          });
+    }
+    std::size_t const limit = exact == nullptr ? next_rank_ : exact->rank;
+    for (auto const & i : predicates_) {
+      if (i.rank >= limit) {
+        break;
+      }
+      if (i.match(std::forward<call_types>(args)...)) {
+        return &i.action;
+      }
+    }
+    return exact == nullptr ? nullptr : &exact->action;
+  }
+
+  /**
+   * Find the action for a call, before its arguments are captured.
+   *
+   * The exact rules are found by hashing the arguments in place (see
+   * known_arguments_capture_by_value::hash_arguments()), and only the
+   * predicates registered before the matching exact rule, if any, are
+   * evaluated.  Those predicates share a single copy of the arguments
+   * (see predicate_argument), a predicate that moves from them does
+   * not affect the capture.
+   *
+   * @returns the first matching action, or nullptr if none matches.
+   */
+  template<typename... call_types>
+  return_function const * find_arguments(call_types&... args) const {
+    exact_rule const * exact = nullptr;
+    if (not exact_.empty()) {
+      exact = find_exact(
+          capture_strategy::hash_arguments(args...),
+          [&](value_type const & x) {
+            return capture_strategy::matches(x, args...);
+          });
+    }
+    std::size_t const limit = exact == nullptr ? next_rank_ : exact->rank;
+    if (predicates_.empty() or predicates_.front().rank >= limit) {
+      return exact == nullptr ? nullptr : &exact->action;
+    }
+    std::tuple<predicate_argument<call_types>...> copy(args...);
+    for (auto const & i : predicates_) {
+      if (i.rank >= limit) {
+        break;
+      }
+      if (call_predicate(
+              i.match, copy,
+              typename make_index_list<sizeof...(call_types)>::type())) {
+        return &i.action;
+      }
+    }
+    return exact == nullptr ? nullptr : &exact->action;
+  }
+
+  /// Remove all the rules.
+  void clear() {
+    predicates_.clear();
+    exact_.clear();
+    next_rank_ = 0;
+  }
+
+  //@{
+  /**
+   * @name Accessors
+   */
+  bool empty() const {
+    return next_rank_ == 0;
+  }
+  std::size_t size() const {
+    return predicates_.size() + exact_.size();
+  }
+  //@}
+
+ private:
+  struct predicate_rule {
+    std::size_t rank;
+    predicate match;
+    return_function action;
+  };
+  struct exact_rule {
+    std::size_t rank;
+    value_type match;
+    return_function action;
+  };
+
+  /// Find the exact rule with hash @a h whose capture satisfies @a eq.
+  template<typename equal_function>
+  exact_rule const * find_exact(std::size_t h, equal_function eq) const {
+    auto const range = exact_.equal_range(h);
+    for (auto i = range.first; i != range.second; ++i) {
+      if (eq(i->second.match)) {
+        return &i->second;
+      }
+    }
+    return nullptr;
+  }
+
+  /// Call a predicate with the copy of the arguments.
+  template<typename tuple_t, std::size_t... I>
+  static bool call_predicate(
+      predicate const & p, tuple_t & copy, index_list<I...>) {
+    return p(std::get<I>(copy).get()...);
+  }
+
+ private:
+  std::list<predicate_rule> predicates_;
+  /// The exact rules, keyed by the hash of their captures.
+  std::unordered_multimap<std::size_t, exact_rule> exact_;
+  std::size_t next_rank_;
+};
+
+} // namespace detail
+} // namespace skye
+
+#endif // skye_detail_side_effect_table_hpp
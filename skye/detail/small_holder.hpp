@@ -0,0 +1,252 @@
+#ifndef skye_detail_small_holder_hpp
+#define skye_detail_small_holder_hpp
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace skye {
+namespace detail {
+
+/**
+ * Return a unique tag for each type.
+ *
+ * The capture holders use these tags to check if two captures hold
+ * the same type, which is much cheaper than dynamic_cast<>.  The
+ * tag is not const, a constant could be merged with the tags of
+ * other types (by the linker or the compiler), and then two types
+ * would share the same address.
+ */
+template<typename T>
+struct type_tag {
+  static char id;
+};
+
+template<typename T>
+char type_tag<T>::id = 0;
+
+/**
+ * Hold an object derived from @a interface_type by value.
+ *
+ * Type-erased captures (see unknown_arguments_capture_by_value) used
+ * to be held through std::shared_ptr<>, which requires at least one
+ * allocation per capture.  This class stores small objects inline, in
+ * a buffer of @a capacity bytes, and only falls back to the heap for
+ * objects that do not fit (or that cannot be moved without throwing).
+ *
+ * Copies are deep: the held object is copy constructed.  Held objects
+ * that must share state between copies hold that state through a
+ * std::shared_ptr<>, for example, the captures of async_* calls share
+ * the handler and its completion state (see
+ * skye::asio::detail::shared_completion), so code that copies a
+ * capture:
+ *
+ * @code
+ * auto op = mock.at(0);
+ * op->call_functor(boost::system::error_code(), 0);
+ * @endcode
+ *
+ * completes the operation captured by mock.at(0).
+ *
+ * @tparam interface_type the base class for all the held objects, it
+ *   must have a virtual destructor.
+ * @tparam capacity the size of the inline buffer.
+ */
+template<typename interface_type, std::size_t capacity = 8 * sizeof(void*)>
+class small_holder {
+ public:
+  /// Create a new holder with an @a object_type constructed from @a args.
+  template<typename object_type, typename... arg_types>
+  static small_holder create(arg_types&&... args) {
+    small_holder h;
+    h.create_object<object_type>(
+        std::integral_constant<bool, fits_inline<object_type>::value>(),
+        std::forward<arg_types>(args)...);
+    return h;
+  }
+
+  /// Create an empty holder.
+  small_holder()
+      : object_(nullptr)
+      , operations_(nullptr)
+  {}
+  small_holder(small_holder const & rhs)
+      : small_holder() {
+    if (rhs.operations_ != nullptr) {
+      rhs.operations_->copy(*this, rhs);
+    }
+  }
+  small_holder(small_holder && rhs) noexcept
+      : small_holder() {
+    if (rhs.operations_ != nullptr) {
+      rhs.operations_->move(*this, rhs);
+    }
+  }
+  small_holder & operator=(small_holder const & rhs) {
+    if (this != &rhs) {
+      small_holder tmp(rhs);
+      *this = std::move(tmp);
+    }
+    return *this;
+  }
+  small_holder & operator=(small_holder && rhs) noexcept {
+    if (this != &rhs) {
+      reset();
+      if (rhs.operations_ != nullptr) {
+        rhs.operations_->move(*this, rhs);
+      }
+    }
+    return *this;
+  }
+  ~small_holder() {
+    reset();
+  }
+
+  //@{
+  /**
+   * @name Accessors
+   */
+  interface_type * operator->() {
+    return object_;
+  }
+  interface_type const * operator->() const {
+    return object_;
+  }
+  interface_type & operator*() {
+    return *object_;
+  }
+  interface_type const & operator*() const {
+    return *object_;
+  }
+  interface_type * get() {
+    return object_;
+  }
+  interface_type const * get() const {
+    return object_;
+  }
+  explicit operator bool() const {
+    return object_ != nullptr;
+  }
+  /// Return true if the object is stored in the inline buffer.
+  bool is_inline() const {
+    return static_cast<void const*>(object_) == buffer();
+  }
+  //@}
+
+ private:
+  /// Determine if an object can be stored inline.
+  template<typename object_type>
+  struct fits_inline {
+    static bool const value =
+        sizeof(object_type) <= capacity
+        and alignof(object_type) <= alignof(std::max_align_t)
+        and std::is_nothrow_move_constructible<object_type>::value;
+  };
+
+  /// The type-specific operations, one static table per held type.
+  struct operations {
+    void (*copy)(small_holder & dst, small_holder const & src);
+    void (*move)(small_holder & dst, small_holder & src);
+  };
+
+  template<typename object_type, bool is_inline>
+  struct operations_for;
+
+  /// Operations for objects stored inline.
+  template<typename object_type>
+  struct operations_for<object_type,true> {
+    static void copy(small_holder & dst, small_holder const & src) {
+      dst.object_ = new(dst.buffer()) object_type(
+          static_cast<object_type const &>(*src.object_));
+      dst.operations_ = src.operations_;
+    }
+    static void move(small_holder & dst, small_holder & src) {
+      dst.object_ = new(dst.buffer()) object_type(
+          std::move(static_cast<object_type &>(*src.object_)));
+      dst.operations_ = src.operations_;
+      src.reset();
+    }
+    static operations const table;
+  };
+
+  /// Operations for objects stored in the heap.
+  template<typename object_type>
+  struct operations_for<object_type,false> {
+    static void copy(small_holder & dst, small_holder const & src) {
+      dst.object_ = new object_type(
+          static_cast<object_type const &>(*src.object_));
+      dst.operations_ = src.operations_;
+    }
+    static void move(small_holder & dst, small_holder & src) {
+      dst.object_ = src.object_;
+      dst.operations_ = src.operations_;
+      src.object_ = nullptr;
+      src.operations_ = nullptr;
+    }
+    static operations const table;
+  };
+
+  template<typename object_type, typename... arg_types>
+  void create_object(std::true_type, arg_types&&... args) {
+    object_ = new(buffer()) object_type(std::forward<arg_types>(args)...);
+    operations_ = &operations_for<object_type,true>::table;
+  }
+  template<typename object_type, typename... arg_types>
+  void create_object(std::false_type, arg_types&&... args) {
+    object_ = new object_type(std::forward<arg_types>(args)...);
+    operations_ = &operations_for<object_type,false>::table;
+  }
+
+  /// Destroy the held object, if any.
+  void reset() {
+    if (object_ == nullptr) {
+      return;
+    }
+    if (is_inline()) {
+      object_->~interface_type();
+    } else {
+      delete object_;
+    }
+    object_ = nullptr;
+    operations_ = nullptr;
+  }
+
+  void * buffer() {
+    return &buffer_;
+  }
+  void const * buffer() const {
+    return &buffer_;
+  }
+
+ private:
+  interface_type * object_;
+  operations const * operations_;
+  typename std::aligned_storage<
+    capacity, alignof(std::max_align_t)>::type buffer_;
+};
+
+template<typename interface_type, std::size_t capacity>
+template<typename object_type>
+typename small_holder<interface_type,capacity>::operations const
+small_holder<interface_type,capacity>::operations_for<
+  object_type,true>::table = {
+  &small_holder<interface_type,capacity>::operations_for<
+    object_type,true>::copy,
+  &small_holder<interface_type,capacity>::operations_for<
+    object_type,true>::move };
+
+template<typename interface_type, std::size_t capacity>
+template<typename object_type>
+typename small_holder<interface_type,capacity>::operations const
+small_holder<interface_type,capacity>::operations_for<
+  object_type,false>::table = {
+  &small_holder<interface_type,capacity>::operations_for<
+    object_type,false>::copy,
+  &small_holder<interface_type,capacity>::operations_for<
+    object_type,false>::move };
+
+} // namespace detail
+} // namespace skye
+
+#endif // skye_detail_small_holder_hpp
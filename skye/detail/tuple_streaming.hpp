@@ -1,6 +1,8 @@
 #ifndef skye_detail_tuple_streaming_hpp
 #define skye_detail_tuple_streaming_hpp
 
+#include <skye/detail/index_list.hpp>
+
 #include <tuple>
 #include <iostream>
 
@@ -14,33 +16,18 @@ namespace detail {
  * objects have an streaming operator defined, but for types involved
  * in a unit test this is often safe.
  * TODO(ES-40)
+ *
+ * The elements are printed with a pack expansion, in order, so each
+ * tuple type only instantiates this function.
  */
-template<typename tuple_t, std::size_t N>
-struct tuple_contents_printer {
-  static void print(std::ostream & os, tuple_t const & x) {
-    tuple_contents_printer<tuple_t, N-1>::print(os, x);
-    os << "," << std::get<N-1>(x);
-  }
-};
-
-/**
- * Partial specialization for tuples with a single element.
- */
-template<typename tuple_t>
-struct tuple_contents_printer<tuple_t,1> {
-  static void print(std::ostream & os, tuple_t const & x) {
-    os << std::get<0>(x);
-  }
-};
-
-/**
- * Partial specialization for empty tuples.
- */
-template<typename tuple_t>
-struct tuple_contents_printer<tuple_t,0> {
-  static void print(std::ostream & , tuple_t const & ) {
-  }
-};
+template<typename tuple_t, std::size_t... I>
+void print_tuple_contents(
+    std::ostream & os, tuple_t const & x, index_list<I...>) {
+  // ... the initializer list guarantees left to right evaluation ...
+  int const unused[] = {
+    0, ((os << (I == 0 ? "" : ",") << std::get<I>(x)), 0)...};
+  (void) unused;
+}
 
 } // namespace detail
 } // namespace skye
@@ -54,8 +41,9 @@ template<typename... args>
 ostream & operator<<(
     ostream & os, tuple<args...> const & x) {
   os << "<";
-  skye::detail::tuple_contents_printer<
-    tuple<args...>, sizeof...(args)>::print(os, x);
+  skye::detail::print_tuple_contents(
+      os, x, typename skye::detail::make_index_list<
+        sizeof...(args)>::type());
   return os << ">";
 }
 
@@ -2,8 +2,8 @@
 #define skye_detail_unknown_arguments_capture_by_value_hpp
 
 #include <skye/detail/argument_wrapper.hpp>
+#include <skye/detail/small_holder.hpp>
 #include <skye/detail/tuple_streaming.hpp>
-#include <memory>
 
 namespace skye {
 namespace detail {
@@ -18,9 +18,9 @@ namespace detail {
  */
 class unknown_arguments_by_value_holder {
  public:
-  /// These objects are held through a shared_ptr<> often, so define
-  /// an typedef for it.
-  typedef std::shared_ptr<unknown_arguments_by_value_holder> pointer;
+  /// These objects are held by value, small ones without allocating
+  /// any memory, so define a typedef for the holder.
+  typedef small_holder<unknown_arguments_by_value_holder> value;
 
   /// Destructor.
   virtual ~unknown_arguments_by_value_holder() {}
@@ -31,7 +31,17 @@ class unknown_arguments_by_value_holder {
    * This member function is expected to perform a deep comparison,
    * basically member-by-member.
    */
-  virtual bool equals(pointer const & other) const = 0;
+  virtual bool equals(
+      unknown_arguments_by_value_holder const & other) const = 0;
+
+  /// Return a tag unique to the concrete type of the holder.
+  virtual void const * type() const = 0;
+
+  /// Return true if the argument values can be hashed.
+  virtual bool hashable() const = 0;
+
+  /// Hash the argument values, only meaningful if hashable() is true.
+  virtual std::size_t hash() const = 0;
 
   /// Print the argument values using iostreams.
   virtual void stream(std::ostream & os) const = 0;
@@ -51,25 +61,45 @@ class unknown_arguments_by_value_holder_tuple
     : public unknown_arguments_by_value_holder {
  public:
   typedef unknown_arguments_by_value_holder base;
-  typedef typename base::pointer pointer;
+  typedef typename base::value value;
 
   unknown_arguments_by_value_holder_tuple() = default;
   unknown_arguments_by_value_holder_tuple(
       unknown_arguments_by_value_holder_tuple const &) = default;
+  unknown_arguments_by_value_holder_tuple(
+      unknown_arguments_by_value_holder_tuple &&) = default;
+
+  /// Constructor
+  explicit unknown_arguments_by_value_holder_tuple(tuple_type && tuple)
+      : tuple_(std::move(tuple))
+  {}
 
   /// Create a new object given a tuple rvalue reference.
-  static pointer create(tuple_type && t) {
-    return pointer(new unknown_arguments_by_value_holder_tuple(
-        std::forward<tuple_type>(t)));
+  static value create(tuple_type && t) {
+    return value::template create<unknown_arguments_by_value_holder_tuple>(
+        std::move(t));
   }
 
-  virtual bool equals(pointer const & other) const override {
-    auto rhs = dynamic_cast<
-      unknown_arguments_by_value_holder_tuple const*>(other.get());
-    if (rhs == nullptr) {
+  virtual bool equals(
+      unknown_arguments_by_value_holder const & other) const override {
+    if (other.type() != type()) {
       return false;
     }
-    return tuple_ == rhs->tuple_;
+    auto const & rhs =
+        static_cast<unknown_arguments_by_value_holder_tuple const &>(other);
+    return tuple_ == rhs.tuple_;
+  }
+
+  virtual void const * type() const override {
+    return &type_tag<unknown_arguments_by_value_holder_tuple>::id;
+  }
+
+  virtual bool hashable() const override {
+    return wrapped_tuple_hash<tuple_type>::hashable;
+  }
+
+  virtual std::size_t hash() const override {
+    return wrapped_tuple_hash<tuple_type>::hash(tuple_);
   }
 
   virtual std::size_t argument_count() const override {
@@ -80,12 +110,6 @@ class unknown_arguments_by_value_holder_tuple
     os << tuple_;
   }
 
- private:
-  /// Constructor
-  unknown_arguments_by_value_holder_tuple(tuple_type && tuple)
-      : tuple_(tuple)
-  {}
-
  private:
   tuple_type tuple_;
 };
@@ -101,6 +125,9 @@ class unknown_arguments_by_value_holder_tuple
  * functions are used in the implementation of check_called() and its
  * related assertion Mock.
  *
+ * The objects are held in a small_holder<>, so most captures do not
+ * allocate any memory beyond what the arguments themselves need.
+ *
  * @see unknown_arguments_by_value_holder_tuple
  * @see unknown_arguments_by_value_holder
  * @see report_with_check
@@ -108,23 +135,37 @@ class unknown_arguments_by_value_holder_tuple
  */
 struct unknown_arguments_capture_by_value {
   /// A single argument capture.
-  typedef unknown_arguments_by_value_holder::pointer value_type;
+  typedef unknown_arguments_by_value_holder::value value_type;
 
   /// The type representing a sequence of argument captures.
   typedef std::vector<value_type> capture_sequence;
 
   template<typename... arg_types>
   static value_type capture(arg_types&&... args) {
-    auto t = wrap_args_as_tuple(args...);
-    return unknown_arguments_by_value_holder_tuple<decltype(t)>::create(
-        std::move(t));
+    typedef typename wrapped_tuple<arg_types...>::type tuple_type;
+    return unknown_arguments_by_value_holder_tuple<tuple_type>::create(
+        tuple_type(std::forward<arg_types>(args)...));
+  }
+
+  /// Capture a set of arguments directly into a capture_buffer.
+  template<typename buffer_type, typename... arg_types>
+  static value_type & capture_into(buffer_type & buffer, arg_types&&... args) {
+    return buffer.push_back(capture(std::forward<arg_types>(args)...));
+  }
+
+  static bool equals(value_type const & lhs, value_type const & rhs) {
+    return lhs->equals(*rhs);
+  }
+
+  static bool hashable(value_type const & x) {
+    return x->hashable();
   }
 
-  static bool equals(value_type lhs, value_type rhs) {
-    return lhs->equals(rhs);
+  static std::size_t hash(value_type const & x) {
+    return x->hash();
   }
 
-  static void stream(std::ostream & os, value_type x) {
+  static void stream(std::ostream & os, value_type const & x) {
     x->stream(os);
   }
 };
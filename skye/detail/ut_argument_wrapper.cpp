@@ -3,6 +3,8 @@
 
 #include <boost/test/unit_test.hpp>
 
+#include <sstream>
+
 using namespace skye::detail;
 
 /**
@@ -258,3 +260,90 @@ BOOST_AUTO_TEST_CASE( wrap_no_copy ) {
                     "<[::place_holder::],[::place_holder::]"
                     ",[::place_holder::],1,2>");
 }
+
+/**
+ * Helper types for the hashing tests.
+ */
+namespace {
+struct not_hashable {
+  int x;
+};
+} // anonymous namespace
+
+/**
+ * @test Verify that wrapped argument tuples are hashed when possible.
+ */
+BOOST_AUTO_TEST_CASE( test_wrapped_tuple_hash ) {
+  auto t1 = wrap_args_as_tuple(1, std::string("foo"));
+  auto t2 = wrap_args_as_tuple(1, std::string("foo"));
+  typedef decltype(t1) t1_type;
+  BOOST_CHECK(wrapped_tuple_hash<t1_type>::hashable);
+  BOOST_CHECK_EQUAL(
+      wrapped_tuple_hash<t1_type>::hash(t1),
+      wrapped_tuple_hash<t1_type>::hash(t2));
+
+  auto t3 = wrap_args_as_tuple(1, not_hashable{2});
+  BOOST_CHECK(not wrapped_tuple_hash<decltype(t3)>::hashable);
+
+  auto t4 = wrap_args_as_tuple();
+  BOOST_CHECK(wrapped_tuple_hash<decltype(t4)>::hashable);
+}
+
+/**
+ * @test Verify that vectors are only compared if their elements can
+ * be compared.
+ */
+BOOST_AUTO_TEST_CASE( test_argument_wrapper_vector_compare ) {
+  BOOST_CHECK(is_equality_comparable<std::vector<int>>::value);
+  BOOST_CHECK(not is_equality_comparable<std::vector<not_hashable>>::value);
+
+  std::vector<not_hashable> v{not_hashable{1}};
+  auto a = make_arg_wrapper(v);
+  auto b = make_arg_wrapper(v);
+  BOOST_CHECK(not (a == b));
+
+  auto c = make_arg_wrapper(std::vector<int>{1, 2});
+  auto d = make_arg_wrapper(std::vector<int>{1, 2});
+  BOOST_CHECK(c == d);
+}
+
+/**
+ * @test Verify that tuples are streamed in order, including the
+ * corner cases.
+ */
+BOOST_AUTO_TEST_CASE( test_tuple_streaming ) {
+  std::ostringstream os;
+  os << std::make_tuple();
+  BOOST_CHECK_EQUAL(os.str(), "<>");
+
+  os.str("");
+  os << std::make_tuple(1);
+  BOOST_CHECK_EQUAL(os.str(), "<1>");
+
+  os.str("");
+  os << std::make_tuple(1, std::string("a"), 'b', 2.5);
+  BOOST_CHECK_EQUAL(os.str(), "<1,a,b,2.5>");
+}
+
+/**
+ * @test Verify the helpers used to expand tuples.
+ */
+BOOST_AUTO_TEST_CASE( test_index_list ) {
+  BOOST_CHECK((std::is_same<
+               make_index_list<0>::type, index_list<>>::value));
+  BOOST_CHECK((std::is_same<
+               make_index_list<3>::type, index_list<0,1,2>>::value));
+  BOOST_CHECK((all_true<>::value));
+  BOOST_CHECK((all_true<true, true>::value));
+  BOOST_CHECK((not all_true<true, false, true>::value));
+
+  // ... the hash only depends on the values, in order ...
+  auto t1 = wrap_args_as_tuple(1, 2);
+  auto t2 = wrap_args_as_tuple(2, 1);
+  typedef wrapped_tuple_hash<decltype(t1)> hash;
+  BOOST_CHECK_EQUAL(
+      hash::hash(t1),
+      hash_combine(hash_combine(0, std::hash<int>()(1)),
+                   std::hash<int>()(2)));
+  BOOST_CHECK_NE(hash::hash(t1), hash::hash(t2));
+}
@@ -0,0 +1,182 @@
+#include <skye/detail/buffered_assertion_reporting.hpp>
+#include <skye/mock_function.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <sstream>
+#include <thread>
+#include <vector>
+
+using namespace skye::detail;
+
+namespace {
+/// Redirect the assertion_log to a string for the duration of a test.
+struct capture_log {
+  capture_log()
+      : os() {
+    assertion_log::instance().set_stream(os);
+  }
+  ~capture_log() {
+    assertion_log::instance().set_log_successes(false);
+    assertion_log::instance().set_stream(std::cerr);
+  }
+
+  std::string str() {
+    assertion_log::instance().flush();
+    return os.str();
+  }
+
+  std::ostringstream os;
+};
+} // anonymous namespace
+
+/**
+ * @test Verify that mpsc_queue preserves the order of each producer.
+ */
+BOOST_AUTO_TEST_CASE( mpsc_queue_basic ) {
+  mpsc_queue<int> q;
+  int v = 0;
+  BOOST_CHECK(not q.pop(v));
+  q.push(1);
+  q.push(2);
+  BOOST_CHECK(q.pop(v));
+  BOOST_CHECK_EQUAL(v, 1);
+  q.push(3);
+  BOOST_CHECK(q.pop(v));
+  BOOST_CHECK_EQUAL(v, 2);
+  BOOST_CHECK(q.pop(v));
+  BOOST_CHECK_EQUAL(v, 3);
+  BOOST_CHECK(not q.pop(v));
+  q.push(4);
+  BOOST_CHECK(q.pop(v));
+  BOOST_CHECK_EQUAL(v, 4);
+}
+
+/**
+ * @test Verify that mpsc_queue works with concurrent producers.
+ */
+BOOST_AUTO_TEST_CASE( mpsc_queue_concurrent ) {
+  int const producers = 4;
+  int const count = 20000;
+  mpsc_queue<std::pair<int,int>> q;
+  std::vector<std::thread> threads;
+  for (int p = 0; p != producers; ++p) {
+    threads.emplace_back([&q, p]() {
+        for (int i = 0; i != count; ++i) {
+          q.push(std::make_pair(p, i));
+        }
+      });
+  }
+  std::vector<int> next(producers, 0);
+  int received = 0;
+  int out_of_order = 0;
+  std::pair<int,int> v;
+  while (received != producers * count) {
+    if (not q.pop(v)) {
+      std::this_thread::yield();
+      continue;
+    }
+    if (v.second != next[v.first]) {
+      ++out_of_order;
+    }
+    next[v.first] = v.second + 1;
+    ++received;
+  }
+  for (auto & t : threads) {
+    t.join();
+  }
+  BOOST_CHECK_EQUAL(out_of_order, 0);
+  BOOST_CHECK(not q.pop(v));
+}
+
+/**
+ * @test Verify that successes are counted and failures written
+ * immediately.
+ */
+BOOST_AUTO_TEST_CASE( buffered_reporting_basic ) {
+  capture_log log;
+  assertion_log & l = assertion_log::instance();
+  std::uint64_t const successes = l.successes();
+  std::uint64_t const failures = l.failures();
+
+  BOOST_CHECK(not buffered_check_reporting::success_logging_enabled());
+  buffered_check_reporting::report_success(SKYE_LOCATION, "ok");
+  BOOST_CHECK_EQUAL(l.successes(), successes + 1);
+  BOOST_CHECK_EQUAL(log.str(), "");
+
+  skye::detail::location where("f", "file.cpp", 42);
+  buffered_check_reporting::report_failure(where, "oops");
+  // ... the failure is in the stream before report_failure() returns
+  BOOST_CHECK_EQUAL(
+      log.os.str(), "checked assertion(file.cpp:42) failure: oops\n");
+  BOOST_CHECK_EQUAL(l.failures(), failures + 1);
+
+  BOOST_CHECK_THROW(
+      buffered_require_reporting::report_failure(where, "fatal"),
+      std::runtime_error);
+
+  l.set_log_successes(true);
+  BOOST_CHECK(buffered_check_reporting::success_logging_enabled());
+  buffered_check_reporting::report_success(where, "fine");
+  BOOST_CHECK_EQUAL(
+      log.str(),
+      "checked assertion(file.cpp:42) failure: oops\n"
+      "required assertion(file.cpp:42) failure: fatal\n"
+      "checked assertion(file.cpp:42) success: fine\n");
+
+  l.write_summary();
+  std::ostringstream summary;
+  summary << "assertion summary: " << successes + 2 << " success(es), "
+          << failures + 2 << " failure(s)\n";
+  BOOST_CHECK(log.os.str().find(summary.str()) != std::string::npos);
+}
+
+/**
+ * @test Verify that a log where every assertion passed writes its
+ * summary when destroyed.
+ */
+BOOST_AUTO_TEST_CASE( buffered_reporting_summary_all_pass ) {
+  std::ostringstream os;
+  {
+    assertion_log l;
+    l.set_stream(os);
+    skye::detail::location where("f", "file.cpp", 42);
+    l.success(where, "fine", "checked");
+    l.success(where, "fine", "checked");
+    BOOST_CHECK_EQUAL(os.str(), "");
+  }
+  BOOST_CHECK_EQUAL(
+      os.str(), "assertion summary: 2 success(es), 0 failure(s)\n");
+}
+
+/**
+ * @test Verify that mocks can report through the buffered log, from
+ * multiple threads.
+ */
+BOOST_AUTO_TEST_CASE( buffered_reporting_mock ) {
+  capture_log log;
+  assertion_log & l = assertion_log::instance();
+  std::uint64_t const successes = l.successes();
+
+  int const thread_count = 4;
+  int const count = 1000;
+  skye::mock_function<void(int)> f;
+  f(1);
+  std::vector<std::thread> threads;
+  for (int t = 0; t != thread_count; ++t) {
+    threads.emplace_back([&f]() {
+        for (int i = 0; i != count; ++i) {
+          f.make_assertion<buffered_check_reporting>(SKYE_LOCATION)
+              .once().with(1);
+        }
+      });
+  }
+  for (auto & t : threads) {
+    t.join();
+  }
+  BOOST_CHECK_EQUAL(l.successes(), successes + thread_count * count);
+  BOOST_CHECK_EQUAL(log.str(), "");
+
+  f.make_assertion<buffered_check_reporting>(SKYE_LOCATION).never();
+  BOOST_CHECK(log.os.str().find("failure: check_called()")
+              != std::string::npos);
+}
@@ -0,0 +1,167 @@
+#include <skye/detail/capture_buffer.hpp>
+
+#include <boost/test/unit_test.hpp>
+
+#include <thread>
+#include <vector>
+
+using namespace skye::detail;
+
+typedef capture_buffer<std::vector<int>> buffer_type;
+
+/**
+ * @test Verify that an unbounded capture_buffer retains all captures.
+ */
+BOOST_AUTO_TEST_CASE( capture_buffer_unbounded ) {
+  buffer_type buffer;
+  BOOST_CHECK(buffer.empty());
+  BOOST_CHECK_EQUAL(buffer.capacity(), 0);
+
+  for (int i = 0; i != 10; ++i) {
+    buffer.push_back(int(i));
+  }
+  BOOST_CHECK_EQUAL(buffer.call_count(), 10);
+  BOOST_CHECK_EQUAL(buffer.size(), 10);
+  BOOST_CHECK_EQUAL(buffer.dropped(), 0);
+  BOOST_CHECK_EQUAL(buffer.at(0), 0);
+  BOOST_CHECK_EQUAL(buffer.at(9), 9);
+}
+
+/**
+ * A capture that cannot be assigned, and whose move constructor may
+ * throw.
+ */
+namespace {
+struct fragile {
+  explicit fragile(int v)
+      : value(v)
+  {}
+  fragile(fragile const & rhs)
+      : value(rhs.value)
+  {}
+
+  int const value;
+};
+} // anonymous namespace
+
+/**
+ * @test Verify that captures that cannot be replaced safely are all
+ * retained.
+ */
+BOOST_AUTO_TEST_CASE( capture_buffer_not_overwritable ) {
+  capture_buffer<std::vector<fragile>> buffer;
+  buffer.set_capacity(2);
+  for (int i = 0; i != 5; ++i) {
+    buffer.emplace_back(i);
+  }
+  BOOST_CHECK_EQUAL(buffer.call_count(), 5);
+  BOOST_CHECK_EQUAL(buffer.size(), 5);
+  BOOST_CHECK_EQUAL(buffer.at(4).value, 4);
+}
+
+/**
+ * @test Verify that a bounded capture_buffer only retains the last
+ * captures, in call order.
+ */
+BOOST_AUTO_TEST_CASE( capture_buffer_bounded ) {
+  buffer_type buffer;
+  buffer.set_capacity(4);
+
+  for (int i = 0; i != 11; ++i) {
+    buffer.push_back(int(i));
+  }
+  BOOST_CHECK_EQUAL(buffer.call_count(), 11);
+  BOOST_CHECK_EQUAL(buffer.size(), 4);
+  BOOST_CHECK_EQUAL(buffer.dropped(), 7);
+
+  std::vector<int> expected{7, 8, 9, 10};
+  BOOST_CHECK_EQUAL_COLLECTIONS(
+      buffer.begin(), buffer.end(), expected.begin(), expected.end());
+
+  // ... the buffer keeps working after it is linearized ...
+  buffer.push_back(11);
+  buffer.push_back(12);
+  expected = std::vector<int>{9, 10, 11, 12};
+  BOOST_CHECK_EQUAL_COLLECTIONS(
+      buffer.begin(), buffer.end(), expected.begin(), expected.end());
+  BOOST_CHECK_EQUAL(buffer.at(0), 9);
+  BOOST_CHECK_EQUAL(buffer.dropped(), 9);
+
+  buffer.clear();
+  BOOST_CHECK(buffer.empty());
+  BOOST_CHECK_EQUAL(buffer.call_count(), 0);
+  BOOST_CHECK_EQUAL(buffer.capacity(), 4);
+}
+
+/**
+ * @test Verify that reducing the capacity drops the oldest captures.
+ */
+BOOST_AUTO_TEST_CASE( capture_buffer_shrink ) {
+  buffer_type buffer;
+  for (int i = 0; i != 6; ++i) {
+    buffer.push_back(int(i));
+  }
+  buffer.set_capacity(2);
+  BOOST_CHECK_EQUAL(buffer.call_count(), 6);
+  BOOST_CHECK_EQUAL(buffer.dropped(), 4);
+
+  std::vector<int> expected{4, 5};
+  BOOST_CHECK_EQUAL_COLLECTIONS(
+      buffer.begin(), buffer.end(), expected.begin(), expected.end());
+
+  buffer.set_capacity(0);
+  buffer.push_back(6);
+  BOOST_CHECK_EQUAL(buffer.size(), 3);
+}
+
+/**
+ * @test Verify that captures appended from multiple threads are
+ * merged in call order.
+ */
+BOOST_AUTO_TEST_CASE( capture_buffer_thread_safe ) {
+  capture_buffer<std::vector<int>> buffer;
+  buffer.set_thread_safe(true);
+  BOOST_CHECK(buffer.thread_safe());
+
+  buffer.append().push_back(-1);
+
+  int const thread_count = 4;
+  int const per_thread = 10000;
+  std::vector<std::thread> threads;
+  for (int t = 0; t != thread_count; ++t) {
+    threads.emplace_back([&buffer, t, per_thread]() {
+        for (int i = 0; i != per_thread; ++i) {
+          buffer.append().push_back(t * per_thread + i);
+        }
+      });
+  }
+  for (auto & t : threads) {
+    t.join();
+  }
+  buffer.append().push_back(-2);
+
+  BOOST_CHECK_EQUAL(buffer.call_count(), thread_count * per_thread + 2);
+  BOOST_CHECK_EQUAL(buffer.at(0), -1);
+  BOOST_CHECK_EQUAL(buffer.at(buffer.size() - 1), -2);
+
+  // ... the calls from each thread must appear in the order they were
+  // made ...
+  std::vector<int> last(thread_count, -1);
+  for (auto v : buffer.sequence()) {
+    if (v < 0) {
+      continue;
+    }
+    int t = v / per_thread;
+    BOOST_CHECK_LT(last[t], v);
+    last[t] = v;
+  }
+
+  // ... calls made after examining the captures are appended ...
+  std::thread([&buffer]() { buffer.append().push_back(-3); }).join();
+  BOOST_CHECK_EQUAL(buffer.size(), thread_count * per_thread + 3);
+  BOOST_CHECK_EQUAL(buffer.at(buffer.size() - 1), -3);
+
+  buffer.set_thread_safe(false);
+  BOOST_CHECK(not buffer.thread_safe());
+  BOOST_CHECK_EQUAL(buffer.size(), thread_count * per_thread + 3);
+}
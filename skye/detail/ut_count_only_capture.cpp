@@ -0,0 +1,48 @@
+#include <skye/detail/count_only_capture.hpp>
+#include <skye/detail/capture_buffer.hpp>
+
+#include <boost/test/unit_test.hpp>
+
+#include <string>
+
+using namespace skye::detail;
+
+/**
+ * @test Verify that counting_sequence behaves like a (very boring)
+ * container.
+ */
+BOOST_AUTO_TEST_CASE( counting_sequence_basic ) {
+  counting_sequence<call_marker> seq;
+  BOOST_CHECK(seq.empty());
+  BOOST_CHECK(seq.begin() == seq.end());
+
+  seq.push_back(call_marker());
+  seq.push_back(call_marker());
+  seq.push_back(call_marker());
+  BOOST_CHECK_EQUAL(seq.size(), 3);
+  BOOST_CHECK_EQUAL(std::distance(seq.begin(), seq.end()), 3);
+  BOOST_CHECK_THROW(seq.at(3), std::out_of_range);
+
+  counting_sequence<call_marker> tmp;
+  tmp.swap(seq);
+  BOOST_CHECK_EQUAL(tmp.size(), 3);
+  BOOST_CHECK(seq.empty());
+
+  tmp.erase(tmp.begin(), tmp.begin() + 2);
+  BOOST_CHECK_EQUAL(tmp.size(), 1);
+}
+
+/**
+ * @test Verify that count_only_capture works with a bounded
+ * capture_buffer.
+ */
+BOOST_AUTO_TEST_CASE( count_only_capture_bounded ) {
+  capture_buffer<count_only_capture::capture_sequence> buffer;
+  buffer.set_capacity(4);
+  for (int i = 0; i != 10; ++i) {
+    buffer.push_back(count_only_capture::capture(i, std::string("foo")));
+  }
+  BOOST_CHECK_EQUAL(buffer.call_count(), 10);
+  BOOST_CHECK_EQUAL(buffer.size(), 4);
+  BOOST_CHECK_EQUAL(buffer.dropped(), 6);
+}
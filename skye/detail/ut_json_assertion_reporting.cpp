@@ -0,0 +1,113 @@
+#include <skye/detail/json_assertion_reporting.hpp>
+#include <skye/mock_function.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <sstream>
+
+using namespace skye::detail;
+
+namespace {
+/// A base reporting strategy that counts the results.
+struct counting_reporting {
+  static int successes;
+  static int failures;
+
+  static void checkpoint(location const &) {
+  }
+  static bool success_logging_enabled() {
+    return false;
+  }
+  static void report_success(location const &, std::string const &) {
+    ++successes;
+  }
+  static void report_failure(location const &, std::string const &) {
+    ++failures;
+  }
+};
+
+int counting_reporting::successes = 0;
+int counting_reporting::failures = 0;
+
+typedef json_reporting<counting_reporting> reporting;
+
+/// Redirect the json_report to a string for the duration of a test.
+struct capture_report {
+  capture_report()
+      : os() {
+    json_report::instance().set_stream(&os);
+  }
+  ~capture_report() {
+    json_report::instance().set_stream(nullptr);
+  }
+
+  std::ostringstream os;
+};
+} // anonymous namespace
+
+/**
+ * @test Verify that json_escape() produces valid JSON strings.
+ */
+BOOST_AUTO_TEST_CASE( json_escape_basic ) {
+  std::ostringstream os;
+  json_escape(os, "a\"b\\c\nd\x01");
+  BOOST_CHECK_EQUAL(os.str(), "\"a\\\"b\\\\c\\nd\\u0001\"");
+}
+
+/**
+ * @test Verify that the strategy detection works.
+ */
+BOOST_AUTO_TEST_CASE( has_report_record_trait ) {
+  BOOST_CHECK(has_report_record<reporting>::value);
+  BOOST_CHECK(not has_report_record<counting_reporting>::value);
+}
+
+/**
+ * @test Verify that assertions produce one JSON line each, and still
+ * report to the base strategy.
+ */
+BOOST_AUTO_TEST_CASE( json_reporting_assertions ) {
+  capture_report report;
+  skye::mock_function<void(int)> f;
+  f(1);
+  f(2);
+  f(2);
+
+  location const where("my_test", "t.cpp", 42);
+  f.make_assertion<reporting>(where).exactly(2).with(2);
+  BOOST_CHECK_EQUAL(counting_reporting::successes, 1);
+  std::string const pass = report.os.str();
+  BOOST_CHECK_EQUAL(
+      pass.substr(0, pass.find("\"validation_ns\":")),
+      "{\"type\":\"assertion\",\"outcome\":\"pass\",\"file\":\"t.cpp\","
+      "\"line\":42,\"function\":\"my_test\",\"call_count\":3,"
+      "\"matched\":2,\"dropped\":0,");
+  BOOST_CHECK_EQUAL(pass.substr(pass.size() - 2), "}\n");
+  BOOST_CHECK_EQUAL(pass.find("message"), std::string::npos);
+
+  report.os.str("");
+  f.make_assertion<reporting>(where).never();
+  BOOST_CHECK_EQUAL(counting_reporting::failures, 1);
+  std::string const fail = report.os.str();
+  BOOST_CHECK(fail.find("\"outcome\":\"fail\"") != std::string::npos);
+  BOOST_CHECK(
+      fail.find("\"message\":\"check_called()failed validation")
+      != std::string::npos);
+
+  report.os.str("");
+  json_report_mock("f", f);
+  BOOST_CHECK_EQUAL(
+      report.os.str(),
+      "{\"type\":\"mock\",\"name\":\"f\",\"call_count\":3,\"dropped\":0}\n");
+}
+
+/**
+ * @test Verify that nothing is written when the report is disabled.
+ */
+BOOST_AUTO_TEST_CASE( json_reporting_disabled ) {
+  json_report::instance().set_stream(nullptr);
+  BOOST_CHECK(not json_report::instance().enabled());
+  skye::mock_function<void()> f;
+  int const failures = counting_reporting::failures;
+  f.make_assertion<reporting>(SKYE_LOCATION).once();
+  BOOST_CHECK_EQUAL(counting_reporting::failures, failures + 1);
+}
@@ -0,0 +1,80 @@
+#include <skye/detail/side_effect_table.hpp>
+#include <skye/detail/argument_wrapper.hpp>
+
+#include <boost/test/unit_test.hpp>
+
+#include <functional>
+#include <string>
+
+using namespace skye::detail;
+
+typedef known_arguments_capture_by_value<int,std::string> capture_strategy;
+typedef std::function<bool(int,std::string const &)> predicate;
+typedef std::function<int()> return_function;
+typedef side_effect_table<
+  capture_strategy, predicate, return_function> table_type;
+
+/**
+ * @test Verify that exact rules are found and obey registration order.
+ */
+BOOST_AUTO_TEST_CASE( side_effect_table_basic ) {
+  table_type table;
+  BOOST_CHECK(table.empty());
+
+  std::string foo("foo");
+  auto match = capture_strategy::capture(1, std::string(foo));
+  BOOST_CHECK(table.add_exact(match, []() { return 1; }));
+  table.add(
+      [](int x, std::string const &) { return x < 3; }, []() { return 2; });
+  BOOST_CHECK(table.add_exact(
+      capture_strategy::capture(2, std::string(foo)), []() { return 3; }));
+  BOOST_CHECK(table.add_exact(match, []() { return 4; }));
+  BOOST_CHECK_EQUAL(table.size(), 3);
+
+  auto c1 = capture_strategy::capture(1, std::string(foo));
+  auto a1 = table.find(c1, 1, foo);
+  BOOST_REQUIRE(a1 != nullptr);
+  BOOST_CHECK_EQUAL((*a1)(), 1);
+
+  auto c2 = capture_strategy::capture(2, std::string(foo));
+  auto a2 = table.find(c2, 2, foo);
+  BOOST_REQUIRE(a2 != nullptr);
+  BOOST_CHECK_EQUAL((*a2)(), 2);
+
+  auto c3 = capture_strategy::capture(7, std::string(foo));
+  BOOST_CHECK(table.find(c3, 7, foo) == nullptr);
+
+  table.clear();
+  BOOST_CHECK(table.empty());
+  BOOST_CHECK(table.find(c1, 1, foo) == nullptr);
+}
+
+/**
+ * @test Verify that the rules are found from the call arguments, and
+ * only the predicates registered before the exact match are checked.
+ */
+BOOST_AUTO_TEST_CASE( side_effect_table_find_arguments ) {
+  table_type table;
+  int checked = 0;
+  table.add(
+      [&checked](int x, std::string const &) { ++checked; return x < 0; },
+      []() { return 1; });
+  BOOST_CHECK(table.add_exact(
+      capture_strategy::capture(2, std::string("foo")), []() { return 2; }));
+  table.add(
+      [&checked](int, std::string const &) { ++checked; return true; },
+      []() { return 3; });
+
+  int x = 2;
+  std::string foo("foo");
+  auto a = table.find_arguments<int, std::string const &>(x, foo);
+  BOOST_REQUIRE(a != nullptr);
+  BOOST_CHECK_EQUAL((*a)(), 2);
+  BOOST_CHECK_EQUAL(checked, 1);
+
+  x = 7;
+  a = table.find_arguments<int, std::string const &>(x, foo);
+  BOOST_REQUIRE(a != nullptr);
+  BOOST_CHECK_EQUAL((*a)(), 3);
+  BOOST_CHECK_EQUAL(checked, 3);
+}
@@ -0,0 +1,143 @@
+#include <skye/detail/small_holder.hpp>
+
+#include <boost/test/unit_test.hpp>
+
+#include <string>
+#include <vector>
+
+using namespace skye::detail;
+
+/**
+ * Helper types for the small_holder tests.
+ */
+namespace {
+int live_objects = 0;
+
+struct shape {
+  shape() {
+    ++live_objects;
+  }
+  shape(shape const &) {
+    ++live_objects;
+  }
+  virtual ~shape() {
+    --live_objects;
+  }
+  virtual std::string name() const = 0;
+  virtual void const * type() const = 0;
+};
+
+struct small_shape : public shape {
+  explicit small_shape(std::string n)
+      : n(std::move(n))
+  {}
+  small_shape(small_shape const &) = default;
+  small_shape(small_shape && rhs) noexcept
+      : shape(rhs)
+      , n(std::move(rhs.n))
+  {}
+  virtual std::string name() const override {
+    return n;
+  }
+  virtual void const * type() const override {
+    return &type_tag<small_shape>::id;
+  }
+  std::string n;
+};
+
+struct large_shape : public shape {
+  explicit large_shape(std::string n)
+      : n(std::move(n))
+  {}
+  virtual std::string name() const override {
+    return n + "/" + std::to_string(sizeof(padding));
+  }
+  virtual void const * type() const override {
+    return &type_tag<large_shape>::id;
+  }
+  std::string n;
+  char padding[256];
+};
+
+typedef small_holder<shape> holder;
+} // anonymous namespace
+
+/**
+ * @test Verify that small objects are stored inline.
+ */
+BOOST_AUTO_TEST_CASE( small_holder_inline ) {
+  {
+    holder h = holder::create<small_shape>("small");
+    BOOST_CHECK(h.is_inline());
+    BOOST_CHECK_EQUAL(h->name(), "small");
+    BOOST_CHECK_EQUAL(live_objects, 1);
+
+    holder copy(h);
+    BOOST_CHECK(copy.is_inline());
+    BOOST_CHECK_EQUAL(copy->name(), "small");
+    BOOST_CHECK(copy.get() != h.get());
+    BOOST_CHECK_EQUAL(live_objects, 2);
+
+    holder moved(std::move(copy));
+    BOOST_CHECK(moved.is_inline());
+    BOOST_CHECK_EQUAL(moved->name(), "small");
+    BOOST_CHECK(not copy);
+    BOOST_CHECK_EQUAL(live_objects, 2);
+  }
+  BOOST_CHECK_EQUAL(live_objects, 0);
+}
+
+/**
+ * @test Verify that large objects are stored in the heap.
+ */
+BOOST_AUTO_TEST_CASE( small_holder_heap ) {
+  {
+    holder h = holder::create<large_shape>("large");
+    BOOST_CHECK(not h.is_inline());
+    BOOST_CHECK_EQUAL(h->name(), "large/256");
+
+    holder copy(h);
+    BOOST_CHECK(not copy.is_inline());
+    BOOST_CHECK(copy.get() != h.get());
+    BOOST_CHECK_EQUAL(live_objects, 2);
+
+    shape * p = copy.get();
+    holder moved(std::move(copy));
+    BOOST_CHECK_EQUAL(moved.get(), p);
+    BOOST_CHECK(not copy);
+    BOOST_CHECK_EQUAL(live_objects, 2);
+  }
+  BOOST_CHECK_EQUAL(live_objects, 0);
+}
+
+/**
+ * @test Verify that assignment works across storage modes, and that
+ * holders can be kept in a vector.
+ */
+BOOST_AUTO_TEST_CASE( small_holder_assignment ) {
+  {
+    std::vector<holder> v;
+    for (int i = 0; i != 16; ++i) {
+      if (i % 2 == 0) {
+        v.push_back(holder::create<small_shape>(std::to_string(i)));
+      } else {
+        v.push_back(holder::create<large_shape>(std::to_string(i)));
+      }
+    }
+    BOOST_CHECK_EQUAL(live_objects, 16);
+    BOOST_CHECK_EQUAL(v[4]->name(), "4");
+    BOOST_CHECK_EQUAL(v[5]->name(), "5/256");
+
+    v[0] = v[1];
+    BOOST_CHECK(not v[0].is_inline());
+    BOOST_CHECK_EQUAL(v[0]->name(), "1/256");
+    v[1] = std::move(v[2]);
+    BOOST_CHECK(v[1].is_inline());
+    BOOST_CHECK_EQUAL(v[1]->name(), "2");
+    BOOST_CHECK_EQUAL(live_objects, 15);
+
+    BOOST_CHECK(v[1]->type() == v[4]->type());
+    BOOST_CHECK(v[1]->type() != v[5]->type());
+  }
+  BOOST_CHECK_EQUAL(live_objects, 0);
+}
@@ -20,10 +20,28 @@ BOOST_AUTO_TEST_CASE( test_unknown_arguments_capture_by_value ) {
   c3->stream(os);
   BOOST_CHECK_EQUAL(os.str(), "<a,b,c>");
   auto c4 = unknown_arguments_capture_by_value::capture(a, b, c);
-  BOOST_CHECK(c3->equals(c4));
+  BOOST_CHECK(c3->equals(*c4));
   auto c5 = unknown_arguments_capture_by_value::capture(b, c, d);
-  BOOST_CHECK(not c3->equals(c5));
+  BOOST_CHECK(not c3->equals(*c5));
 
   c4 = unknown_arguments_capture_by_value::capture(a, b, c, 1, 2, 3, 4);
   BOOST_CHECK_EQUAL(c4->argument_count(), 7);
 }
+
+/**
+ * @test Verify that small captures are stored without allocations and
+ * that captures of different types never compare equal.
+ */
+BOOST_AUTO_TEST_CASE( test_unknown_arguments_capture_inline ) {
+  auto c1 = unknown_arguments_capture_by_value::capture(1, 2);
+  BOOST_CHECK(c1.is_inline());
+  auto c2 = unknown_arguments_capture_by_value::capture(1, 2L);
+  BOOST_CHECK(not unknown_arguments_capture_by_value::equals(c1, c2));
+  auto c3 = c1;
+  BOOST_CHECK(unknown_arguments_capture_by_value::equals(c1, c3));
+
+  std::string const s("abc");
+  auto c4 = unknown_arguments_capture_by_value::capture(s, s, s, s);
+  BOOST_CHECK(not c4.is_inline());
+  BOOST_CHECK_EQUAL(c4->argument_count(), 4);
+}
@@ -106,3 +106,24 @@ BOOST_AUTO_TEST_CASE( test_exactly_validator ) {
 }
 
 
+
+BOOST_AUTO_TEST_CASE( test_validator_single_pass ) {
+  capture_sequence seq{
+    std::make_tuple(1, "foo"),
+    std::make_tuple(2, "bar"),
+    std::make_tuple(1, "foo")};
+
+  auto filter = make_negative_filter<capture_sequence>(
+      std::string("1, 'foo'"),
+      [](arguments const & t) { return t != std::make_tuple(1, "foo"); });
+  BOOST_CHECK(filter->filters());
+  BOOST_CHECK(filter->accept(seq[0]));
+  BOOST_CHECK(not filter->accept(seq[1]));
+  BOOST_CHECK(filter->validate_count(0).pass);
+
+  exactly_validator<capture_sequence,false> v(2);
+  BOOST_CHECK(not v.filters());
+  BOOST_CHECK(v.accept(seq[1]));
+  BOOST_CHECK(v.validate_count(2).pass);
+  BOOST_CHECK(not v.validate_count(3).pass);
+}
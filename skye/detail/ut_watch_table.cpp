@@ -0,0 +1,78 @@
+#include <skye/detail/watch_table.hpp>
+#include <skye/detail/argument_wrapper.hpp>
+
+#include <boost/test/unit_test.hpp>
+
+#include <string>
+#include <vector>
+
+using namespace skye::detail;
+
+typedef known_arguments_capture_by_value<int,std::string> capture_strategy;
+typedef watch_table<capture_strategy> table_type;
+typedef std::vector<capture_strategy::value_type> sequence_type;
+
+/**
+ * @test Verify that watched values are counted, including the calls
+ * made before the value was watched.
+ */
+BOOST_AUTO_TEST_CASE( watch_table_basic ) {
+  sequence_type existing;
+  existing.push_back(capture_strategy::capture(1, std::string("foo")));
+  existing.push_back(capture_strategy::capture(2, std::string("bar")));
+  existing.push_back(capture_strategy::capture(1, std::string("foo")));
+
+  table_type table;
+  BOOST_CHECK(not table.active());
+  table.watch(capture_strategy::capture(1, std::string("foo")), existing);
+  BOOST_CHECK(table.active());
+
+  std::size_t count = 0;
+  auto foo = capture_strategy::capture(1, std::string("foo"));
+  BOOST_CHECK(table.lookup(foo, count));
+  BOOST_CHECK_EQUAL(count, 2);
+
+  auto bar = capture_strategy::capture(2, std::string("bar"));
+  BOOST_CHECK(not table.lookup(bar, count));
+
+  table.record(foo);
+  table.record(bar);
+  BOOST_CHECK(table.lookup(foo, count));
+  BOOST_CHECK_EQUAL(count, 3);
+
+  table.reset();
+  BOOST_CHECK(table.lookup(foo, count));
+  BOOST_CHECK_EQUAL(count, 0);
+
+  table.clear();
+  BOOST_CHECK(not table.active());
+  BOOST_CHECK(not table.lookup(foo, count));
+}
+
+/**
+ * @test Verify that histograms count every distinct value.
+ */
+BOOST_AUTO_TEST_CASE( watch_table_histogram ) {
+  sequence_type existing;
+  existing.push_back(capture_strategy::capture(1, std::string("foo")));
+  existing.push_back(capture_strategy::capture(2, std::string("bar")));
+
+  table_type table;
+  table.watch(capture_strategy::capture(1, std::string("foo")), existing);
+  table.watch_all(existing);
+  BOOST_CHECK(table.histogram());
+  BOOST_CHECK_EQUAL(table.size(), 2);
+
+  auto foo = capture_strategy::capture(1, std::string("foo"));
+  table.record(foo);
+
+  std::size_t count = 0;
+  BOOST_CHECK(table.lookup(foo, count));
+  BOOST_CHECK_EQUAL(count, 2);
+  BOOST_CHECK(
+      table.lookup(capture_strategy::capture(2, std::string("bar")), count));
+  BOOST_CHECK_EQUAL(count, 1);
+  BOOST_CHECK(
+      table.lookup(capture_strategy::capture(3, std::string("baz")), count));
+  BOOST_CHECK_EQUAL(count, 0);
+}
@@ -9,6 +9,7 @@
 #include <sstream>
 #include <iostream>
 #include <tuple>
+#include <utility>
 
 namespace skye {
 namespace detail {
@@ -98,23 +99,81 @@ inline std::ostream & operator<<(
  * x.check_called().once().with(1, "foo");
  * x.check_called().exactly(2);
  * @endcode
+ *
+ * Filters are predicates on a single capture (see accept()), and the
+ * other validators only examine the number of captures that pass all
+ * the filters (see validate_count()).  That allows function_assertion
+ * to validate a sequence in a single pass, without copying it.
+ *
+ * Formatting the assertion messages is expensive compared to the
+ * validation itself, so validate_count() does not produce a message,
+ * and describe() is only called when the message is going to be
+ * reported.
  */
 template<typename sequence_type>
 class validator {
  public:
+  typedef typename sequence_type::value_type value_type;
+
   validator() {}
   virtual ~validator() {}
 
+  /// Return true if the validator filters the captures.
+  virtual bool filters() const {
+    return false;
+  }
+
+  /// Return true if the capture passes the validator filter.
+  virtual bool accept(value_type const &) const {
+    return true;
+  }
+
+  /**
+   * Return the value matched by the filter, if the filter only
+   * accepts captures equal to a single value, nullptr otherwise.
+   */
+  virtual value_type const * exact_match() const {
+    return nullptr;
+  }
+
+  /**
+   * Verify that the number of captures after all filtering meets the
+   * validator requirements.
+   *
+   * The message in the result is always empty, use describe().
+   */
+  virtual validation_result validate_count(std::size_t count) const = 0;
+
+  /**
+   * Print the result of validate_count() for @a count captures.
+   */
+  virtual void describe(std::ostream & os, std::size_t count) const = 0;
+
   /**
    * Apply any filtering required by the validator
    */
-  virtual void filter(sequence_type & sequence) const = 0;
+  void filter(sequence_type & sequence) const {
+    if (not filters()) {
+      return;
+    }
+    sequence.erase(
+        std::remove_if(
+            sequence.begin(), sequence.end(),
+            [this](value_type const & x) { return not accept(x); }),
+        sequence.end());
+  }
 
   /**
    * Verify that the sequence after all filtering meets the validator
    * requirements.
    */
-  virtual validation_result validate(sequence_type const &) const = 0;
+  validation_result validate(sequence_type const & sequence) const {
+    validation_result r = validate_count(sequence.size());
+    std::ostringstream os;
+    describe(os, sequence.size());
+    r.msg = os.str();
+    return r;
+  }
 };
 
 /**
@@ -128,21 +187,17 @@ class at_least_validator : public validator<sequence_type> {
       : min_(min)
   {}
 
-  void filter(sequence_type & sequence) const override {
+  validation_result validate_count(std::size_t size) const override {
+    return validation_result{size >= min_, false, std::string()};
   }
-  validation_result validate(
-      sequence_type const & sequence) const override {
-    std::size_t size = sequence.size();
+  void describe(std::ostream & os, std::size_t size) const override {
     if (size >= min_) {
-      std::ostringstream os;
       os << ".at_least( " << min_ << " )";
-      return validation_result{true, false, os.str()};
+      return;
     }
-    std::ostringstream os;
     os << "failed validation, expected at least " 
        << min_ << " invocations, but only "
        << size << " where present.";
-    return validation_result{false, false, os.str()};
   }
 
  private:
@@ -160,21 +215,17 @@ class at_most_validator : public validator<sequence_type> {
       : max_(max)
   {}
 
-  void filter(sequence_type & sequence) const override {
+  validation_result validate_count(std::size_t size) const override {
+    return validation_result{size <= max_, false, std::string()};
   }
-  validation_result validate(
-      sequence_type const & sequence) const override {
-    std::size_t size = sequence.size();
+  void describe(std::ostream & os, std::size_t size) const override {
     if (size <= max_) {
-      std::ostringstream os;
       os << ".at_most( " << max_ << " )";
-      return validation_result{true, false, os.str()};
+      return;
     }
-    std::ostringstream os;
     os << "failed validation, expected at most " 
        << max_ << " invocations, but "
        << size << " where present.";
-    return validation_result{false, false, os.str()};
   }
 
  private:
@@ -195,25 +246,21 @@ class exactly_validator : public validator<sequence_type> {
       : expected_(expected)
   {}
 
-  void filter(sequence_type & sequence) const override {
+  validation_result validate_count(std::size_t size) const override {
+    return validation_result{size == expected_, short_circuit, std::string()};
   }
-  validation_result validate(
-      sequence_type const & sequence) const override {
-    std::size_t size = sequence.size();
+  void describe(std::ostream & os, std::size_t size) const override {
     if (size == expected_) {
-      std::ostringstream os;
       if (short_circuit && expected_ == 0) {
         os << ".never()";
       } else {
         os << ".exactly( " << expected_ << " )";
       }
-      return validation_result{true, short_circuit, os.str()};
+      return;
     }
-    std::ostringstream os;
     os << "failed validation, expected exactly " 
        << expected_ << " invocations, but "
        << size << " where present.";
-    return validation_result{false, short_circuit, os.str()};
   }
 
  private:
@@ -228,19 +275,22 @@ class negative_filter : public validator<sequence_type> {
  public:
   negative_filter(std::string const & description, predicate_type predicate)
       : description_(description)
-      , predicate_(predicate)
+      , predicate_(std::move(predicate))
   {}
 
-  void filter(sequence_type & sequence) const override {
-    sequence.erase(
-        std::remove_if(sequence.begin(), sequence.end(), predicate_),
-        sequence.end());
+  typedef typename validator<sequence_type>::value_type value_type;
+
+  bool filters() const override {
+    return true;
   }
-  validation_result validate(
-      sequence_type const & ) const override {
-    std::ostringstream os;
+  bool accept(value_type const & capture) const override {
+    return not predicate_(capture);
+  }
+  validation_result validate_count(std::size_t) const override {
+    return validation_result{true, false, std::string()};
+  }
+  void describe(std::ostream & os, std::size_t) const override {
     os << ".with( " << description_ << " )";
-    return validation_result{true, false, os.str()};
   }
   
  private:
@@ -257,9 +307,48 @@ make_negative_filter(
     std::string const & description, predicate_type predicate) {
   return std::shared_ptr<validator<sequence_type>>(
       new negative_filter<sequence_type,predicate_type>(
-          description, predicate) );
+          description, std::move(predicate)) );
 }
 
+/**
+ * Implement a filter that only accepts captures equal to a value.
+ *
+ * The value is only printed if the assertion message is needed.
+ *
+ * @tparam capture_strategy defines how to compare and print the
+ *   captures.
+ */
+template<typename sequence_type, typename capture_strategy>
+class match_filter : public validator<sequence_type> {
+ public:
+  typedef typename validator<sequence_type>::value_type value_type;
+
+  explicit match_filter(value_type && match)
+      : match_(std::move(match))
+  {}
+
+  bool filters() const override {
+    return true;
+  }
+  bool accept(value_type const & capture) const override {
+    return capture_strategy::equals(match_, capture);
+  }
+  value_type const * exact_match() const override {
+    return &match_;
+  }
+  validation_result validate_count(std::size_t) const override {
+    return validation_result{true, false, std::string()};
+  }
+  void describe(std::ostream & os, std::size_t) const override {
+    os << ".with( ";
+    capture_strategy::stream(os, match_);
+    os << " )";
+  }
+
+ private:
+  value_type match_;
+};
+
 } // namespace detail
 } // namespace skye
 
@@ -0,0 +1,210 @@
+#ifndef skye_detail_watch_table_hpp
+#define skye_detail_watch_table_hpp
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+
+namespace skye {
+namespace detail {
+
+/**
+ * Count the calls matching "watched" argument values.
+ *
+ * Tests that assert after every one of many thousands of calls, for
+ * example:
+ *
+ * @code
+ * for (auto const & packet : packets) {
+ *   process(packet);
+ *   f.check_called().with(packet.id).once();
+ * }
+ * @endcode
+ *
+ * would rescan the whole capture log on each assertion.  Instead, the
+ * test can register the values of interest (or all values, as a
+ * histogram) with the mock before exercising the code.  The mock
+ * updates the counters on each call, and function_assertion uses the
+ * counters instead of scanning the captures.
+ *
+ * Only values that can be hashed are counted, assertions on other
+ * values simply scan the captures.
+ *
+ * In thread-safe mode (see set_thread_safe()) record() may be called
+ * concurrently, the other member functions may not.
+ *
+ * @tparam capture_strategy how the mock captures its arguments,
+ *   provides the hash and equality functions.
+ */
+template<typename capture_strategy>
+class watch_table {
+ public:
+  typedef typename capture_strategy::value_type value_type;
+
+  watch_table()
+      : counters_()
+      , histogram_(false)
+      , mu_()
+  {}
+  watch_table(watch_table const & rhs)
+      : counters_(rhs.counters_)
+      , histogram_(rhs.histogram_)
+      , mu_(rhs.mu_ ? new std::mutex : nullptr)
+  {}
+  watch_table & operator=(watch_table const & rhs) {
+    counters_ = rhs.counters_;
+    histogram_ = rhs.histogram_;
+    mu_.reset(rhs.mu_ ? new std::mutex : nullptr);
+    return *this;
+  }
+
+  /// Enable (or disable) concurrent calls to record().
+  void set_thread_safe(bool enable) {
+    mu_.reset(enable ? new std::mutex : nullptr);
+  }
+
+  /**
+   * Start counting the calls matching @a match.
+   *
+   * @param existing the captures already recorded, they are counted
+   *   so the counter is consistent with the capture log.
+   */
+  template<typename sequence_type>
+  void watch(value_type && match, sequence_type const & existing) {
+    if (not capture_strategy::hashable(match)
+        or counters_.find(match) != counters_.end()) {
+      return;
+    }
+    std::size_t count = 0;
+    if (not histogram_) {
+      for (auto const & capture : existing) {
+        if (capture_strategy::equals(match, capture)) {
+          ++count;
+        }
+      }
+    }
+    counters_.emplace(std::move(match), count);
+  }
+
+  /**
+   * Count the calls for every distinct value.
+   *
+   * @param existing the captures already recorded.
+   */
+  template<typename sequence_type>
+  void watch_all(sequence_type const & existing) {
+    if (histogram_) {
+      return;
+    }
+    histogram_ = true;
+    for (auto & i : counters_) {
+      i.second = 0;
+    }
+    for (auto const & capture : existing) {
+      record(capture);
+    }
+  }
+
+  /// Update the counters for a new call.
+  void record(value_type const & capture) {
+    if (not capture_strategy::hashable(capture)) {
+      return;
+    }
+    std::unique_lock<std::mutex> lock;
+    if (mu_) {
+      lock = std::unique_lock<std::mutex>(*mu_);
+    }
+    if (histogram_) {
+      auto i = counters_.find(capture);
+      if (i == counters_.end()) {
+        counters_.emplace(capture, 1);
+      } else {
+        ++i->second;
+      }
+      return;
+    }
+    auto i = counters_.find(capture);
+    if (i != counters_.end()) {
+      ++i->second;
+    }
+  }
+
+  /**
+   * Find the number of calls matching @a match.
+   *
+   * @returns false if the value is not watched.
+   */
+  bool lookup(value_type const & match, std::size_t & count) const {
+    if (not active() or not capture_strategy::hashable(match)) {
+      return false;
+    }
+    auto i = counters_.find(match);
+    if (i != counters_.end()) {
+      count = i->second;
+      return true;
+    }
+    if (histogram_) {
+      count = 0;
+      return true;
+    }
+    return false;
+  }
+
+  /// Reset all the counters to zero, the watched values are kept.
+  void reset() {
+    if (histogram_) {
+      counters_.clear();
+      return;
+    }
+    for (auto & i : counters_) {
+      i.second = 0;
+    }
+  }
+
+  /// Stop watching any value.
+  void clear() {
+    counters_.clear();
+    histogram_ = false;
+  }
+
+  //@{
+  /**
+   * @name Accessors
+   */
+  /// Return true if any value is watched.
+  bool active() const {
+    return histogram_ or not counters_.empty();
+  }
+  bool histogram() const {
+    return histogram_;
+  }
+  /// The number of distinct values counted.
+  std::size_t size() const {
+    return counters_.size();
+  }
+  //@}
+
+ private:
+  struct hasher {
+    std::size_t operator()(value_type const & x) const {
+      return capture_strategy::hash(x);
+    }
+  };
+  struct key_equal {
+    bool operator()(value_type const & lhs, value_type const & rhs) const {
+      return capture_strategy::equals(lhs, rhs);
+    }
+  };
+
+ private:
+  std::unordered_map<value_type, std::size_t, hasher, key_equal> counters_;
+  bool histogram_;
+  std::unique_ptr<std::mutex> mu_;
+};
+
+} // namespace detail
+} // namespace skye
+
+#endif // skye_detail_watch_table_hpp
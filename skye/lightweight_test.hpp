@@ -0,0 +1,251 @@
+#ifndef skye_lightweight_test_hpp
+#define skye_lightweight_test_hpp
+
+#include <skye/detail/hook_assertion_reporting.hpp>
+
+#include <exception>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace skye {
+namespace detail {
+
+/// A test case registered with SKYE_TEST_CASE().
+struct lightweight_test_case {
+  char const * name;
+  void (*body)();
+  char const * file;
+  int line;
+};
+
+/**
+ * A minimal test runner, for tests that do not need Boost.Test.
+ *
+ * Boost.Test is a large dependency: each test translation unit
+ * includes its headers, and each test program links its library.
+ * This runner only uses the standard library, it registers the test
+ * cases (see SKYE_TEST_CASE()), provides a few check macros, and
+ * installs itself as the assertion_hooks, so the mock assertions
+ * fail the current test case.  Compile the tests with
+ * SKYE_USE_LIGHTWEIGHT_TEST_FRAMEWORK defined, so the mocks report
+ * through the hooks:
+ *
+ * @code
+ * #include <skye/lightweight_test.hpp>
+ * #include <skye/mock_function.hpp>
+ *
+ * SKYE_TEST_CASE( my_test ) {
+ *   skye::mock_function<int(int)> f;
+ *   SKYE_CHECK_EQUAL(f(1), 0);
+ *   f.check_called().once().with(1);
+ * }
+ *
+ * SKYE_LIGHTWEIGHT_TEST_MAIN
+ * @endcode
+ *
+ * The test program runs all the test cases, or only those whose name
+ * contains its first argument, and exits with a non-zero status if
+ * any of them failed.
+ */
+class lightweight_runner {
+ public:
+  typedef std::vector<lightweight_test_case> test_cases;
+
+  explicit lightweight_runner(std::ostream & os)
+      : os_(os)
+      , checks_(0)
+      , failed_checks_(0)
+      , current_failed_(false)
+  {}
+
+  /// The test cases registered with SKYE_TEST_CASE().
+  static test_cases & registry() {
+    static test_cases cases;
+    return cases;
+  }
+
+  /// Add a test case to the registry, returns a dummy value.
+  static int register_test(lightweight_test_case const & tc) {
+    registry().push_back(tc);
+    return 0;
+  }
+
+  /**
+   * Run the test cases in @a cases whose name contains @a filter.
+   *
+   * @returns the number of failed test cases.
+   */
+  std::size_t run(test_cases const & cases, std::string const & filter) {
+    auto const saved_report = assertion_hooks::report();
+    lightweight_runner * const saved_current = current();
+    assertion_hooks::report() = &lightweight_runner::report;
+    current() = this;
+
+    std::size_t count = 0;
+    std::size_t failed = 0;
+    for (auto const & tc : cases) {
+      if (std::string(tc.name).find(filter) == std::string::npos) {
+        continue;
+      }
+      ++count;
+      if (not run_one(tc)) {
+        ++failed;
+        os_ << tc.file << ":" << tc.line << ": test case " << tc.name
+            << " failed\n";
+      }
+    }
+    os_ << count << " test case(s), " << failed << " failed, "
+        << checks_ << " check(s), " << failed_checks_ << " failed"
+        << std::endl;
+
+    current() = saved_current;
+    assertion_hooks::report() = saved_report;
+    return failed;
+  }
+
+  /// Run the registered test cases, used by SKYE_LIGHTWEIGHT_TEST_MAIN.
+  static int main(int argc, char * argv[]) {
+    lightweight_runner runner(std::cout);
+    std::string const filter = argc > 1 ? argv[1] : "";
+    return runner.run(registry(), filter) == 0 ? 0 : 1;
+  }
+
+  /// The hook for assertion_hooks::report().
+  static void report(
+      location const & where, std::string const & msg, bool pass,
+      bool fatal) {
+    lightweight_runner * r = current();
+    if (r == nullptr) {
+      assertion_hooks::report_to_stderr(where, msg, pass, fatal);
+      return;
+    }
+    ++r->checks_;
+    if (pass) {
+      return;
+    }
+    ++r->failed_checks_;
+    r->current_failed_ = true;
+    r->os_ << where.file << ":" << where.line << ": "
+           << (fatal ? "required" : "checked")
+           << " assertion failure: " << msg << "\n";
+  }
+
+  //@{
+  /**
+   * @name Accessors
+   */
+  std::size_t checks() const {
+    return checks_;
+  }
+  std::size_t failed_checks() const {
+    return failed_checks_;
+  }
+  //@}
+
+ private:
+  static lightweight_runner * & current() {
+    static lightweight_runner * r = nullptr;
+    return r;
+  }
+
+  bool run_one(lightweight_test_case const & tc) {
+    current_failed_ = false;
+    try {
+      tc.body();
+    } catch (assertion_aborted const &) {
+      // ... already reported ...
+    } catch (std::exception const & ex) {
+      os_ << tc.file << ":" << tc.line << ": uncaught exception: "
+          << ex.what() << "\n";
+      current_failed_ = true;
+    } catch (...) {
+      os_ << tc.file << ":" << tc.line << ": uncaught exception\n";
+      current_failed_ = true;
+    }
+    return not current_failed_;
+  }
+
+ private:
+  std::ostream & os_;
+  std::size_t checks_;
+  std::size_t failed_checks_;
+  bool current_failed_;
+};
+
+/// Report a check made with the SKYE_CHECK*() macros.
+inline void lightweight_check(
+    bool pass, location const & where, char const * what, bool fatal) {
+  assertion_hooks::report()(where, what, pass, fatal);
+  if (not pass and fatal) {
+    throw assertion_aborted(what);
+  }
+}
+
+/// Report a check made with SKYE_CHECK_EQUAL().
+template<typename T, typename U>
+void lightweight_check_equal(
+    T const & lhs, U const & rhs, location const & where,
+    char const * lhs_expr, char const * rhs_expr) {
+  if (lhs == rhs) {
+    assertion_hooks::report()(where, lhs_expr, true, false);
+    return;
+  }
+  std::ostringstream os;
+  os << "SKYE_CHECK_EQUAL(" << lhs_expr << ", " << rhs_expr << ") ["
+     << lhs << " != " << rhs << "]";
+  assertion_hooks::report()(where, os.str(), false, false);
+}
+
+} // namespace detail
+} // namespace skye
+
+/**
+ * Define and register a test case.
+ */
+#define SKYE_TEST_CASE(name) \
+  static void name(); \
+  static int const skye_test_case_registration_##name = \
+      ::skye::detail::lightweight_runner::register_test( \
+          {#name, &name, __FILE__, __LINE__}); \
+  static void name()
+
+/// Check a condition, continue the test case if it fails.
+#define SKYE_CHECK(expr) \
+  ::skye::detail::lightweight_check( \
+      static_cast<bool>(expr), SKYE_LOCATION, "SKYE_CHECK(" #expr ")", \
+      false)
+
+/// Check a condition, abort the test case if it fails.
+#define SKYE_REQUIRE(expr) \
+  ::skye::detail::lightweight_check( \
+      static_cast<bool>(expr), SKYE_LOCATION, "SKYE_REQUIRE(" #expr ")", \
+      true)
+
+/// Check that two values are equal, the values must be streamable.
+#define SKYE_CHECK_EQUAL(lhs, rhs) \
+  ::skye::detail::lightweight_check_equal( \
+      (lhs), (rhs), SKYE_LOCATION, #lhs, #rhs)
+
+/// Check that a statement raises an exception of the given type.
+#define SKYE_CHECK_THROW(statement, exception_type) \
+  do { \
+    bool skye_thrown = false; \
+    try { \
+      statement; \
+    } catch (exception_type const &) { \
+      skye_thrown = true; \
+    } \
+    ::skye::detail::lightweight_check( \
+        skye_thrown, SKYE_LOCATION, \
+        "SKYE_CHECK_THROW(" #statement ", " #exception_type ")", false); \
+  } while (false)
+
+/// Define main() for a program using the lightweight runner.
+#define SKYE_LIGHTWEIGHT_TEST_MAIN \
+  int main(int argc, char * argv[]) { \
+    return ::skye::detail::lightweight_runner::main(argc, argv); \
+  }
+
+#endif // skye_lightweight_test_hpp
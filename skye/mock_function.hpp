@@ -2,12 +2,13 @@
 #define skye_mock_function_hpp
 
 #include <skye/detail/argument_wrapper.hpp>
+#include <skye/detail/capture_buffer.hpp>
 #include <skye/detail/default_return.hpp>
 #include <skye/detail/function_assertion.hpp>
 #include <skye/detail/assertion_reporting.hpp>
 #include <skye/detail/set_action_proxy.hpp>
-
-#include <list>
+#include <skye/detail/side_effect_table.hpp>
+#include <skye/detail/watch_table.hpp>
 
 namespace skye {
 
@@ -15,7 +16,10 @@ namespace skye {
  * Unimplemented, only the specialization for function signatures is
  * of any interest.
  */
-template<typename T>
+template<
+  typename T,
+  typename capture_strategy_T =
+      typename detail::default_capture_strategy<T>::type>
 class mock_function;
 
 /**
@@ -53,30 +57,37 @@ class mock_function;
  *   assert(std::get<0>(f1.at(0)) == 42);
  * }
  * @endcode
+ *
+ * @tparam capture_strategy_T define how arguments are to be captured,
+ *   by default they are captured by value.  The type must meet the
+ *   detail::capture_strategy_requirements interface.
  */
-template<typename return_type, typename... arg_types>
-class mock_function<return_type(arg_types...)> {
+template<
+  typename return_type, typename... arg_types, typename capture_strategy_T>
+class mock_function<return_type(arg_types...), capture_strategy_T> {
  public:
   //@{
   /**
    * @name Type traits
    */
-  /// Hardcoded capture strategy.
-  typedef detail::known_arguments_capture_by_value<arg_types...>
-    capture_strategy;
+  typedef capture_strategy_T capture_strategy;
   typedef typename capture_strategy::value_type value_type;
   typedef typename capture_strategy::capture_sequence capture_sequence;
+  typedef detail::capture_buffer<capture_sequence> capture_buffer;
   typedef typename capture_sequence::const_iterator iterator;
   typedef std::function<bool(arg_types&&...)> predicate;
   typedef detail::set_action_proxy<return_type,predicate> set_action_proxy;
   typedef typename set_action_proxy::return_function return_function;
   typedef typename set_action_proxy::callback callback;
-  typedef std::list<std::pair<predicate, return_function>> side_effects;
+  typedef detail::side_effect_table<
+    capture_strategy, predicate, return_function> side_effects;
+  typedef detail::watch_table<capture_strategy> watches;
   //@}
 
   mock_function()
       : captures_()
       , side_effects_()
+      , watches_()
       , default_return_(detail::default_return<return_type>) {
   }
 
@@ -88,12 +99,33 @@ class mock_function<return_type(arg_types...)> {
    * user has not set an specific functor or value to return.
    */
   return_type operator()(arg_types... args) {
-    auto v = capture_strategy::capture(std::forward<arg_types>(args)...);
-    captures_.push_back(v);
-    for (auto & i : side_effects_) {
-      if (i.first(std::forward<arg_types>(args)...)) {
-        return i.second();
+    if (side_effects_.empty()) {
+      {
+        auto appender = captures_.append();
+        auto & v = capture_strategy::capture_into(
+            appender, std::forward<arg_types>(args)...);
+        if (watches_.active()) {
+          watches_.record(v);
+        }
       }
+      return default_return_();
+    }
+    // The rules must examine the arguments before they are moved into
+    // the capture ...
+    return_function const * action =
+        side_effects_.template find_arguments<arg_types...>(args...);
+    {
+      auto appender = captures_.append();
+      auto & v = capture_strategy::capture_into(
+          appender, std::forward<arg_types>(args)...);
+      if (watches_.active()) {
+        watches_.record(v);
+      }
+    }
+    // ... the action runs without holding any locks, it may call the
+    // mock again ...
+    if (action != nullptr) {
+      return (*action)();
     }
     return default_return_();
   }
@@ -128,30 +160,79 @@ class mock_function<return_type(arg_types...)> {
   /// Prepare a proxy for a given predicate.
   set_action_proxy whenp(predicate p) {
     callback cb = [this,p](return_function f) mutable {
-      this->side_effects_.push_back(std::make_pair(p, f));
+      this->side_effects_.add(p, f);
     };
     return set_action_proxy(cb);
   }
 
-  /// Create a predicate that matches the arguments and returns a
-  /// proxy for it.
+  /**
+   * Create a rule that matches the arguments and returns a proxy for it.
+   *
+   * If the arguments can be hashed the rule is stored in a hash
+   * table, so calls find it in O(1) time, otherwise the rule is
+   * checked in order with the predicates set by whenp().
+   */
   set_action_proxy when(arg_types&&... args) {
+    static_assert(
+        detail::captures_arguments<capture_strategy>::value,
+        "when() requires a capture strategy that records the arguments");
     auto match = capture_strategy::capture(std::forward<arg_types>(args)...);
+    if (capture_strategy::hashable(match)) {
+      callback cb = [this,match](return_function f) mutable {
+        this->side_effects_.add_exact(match, f);
+      };
+      return set_action_proxy(cb);
+    }
     predicate p = [match](arg_types&&... args) {
-      auto v = capture_strategy::capture(std::forward<arg_types>(args)...);
-      return capture_strategy::equals(match, v);
+      return capture_strategy::matches(match, args...);
     };
     return whenp(p);
   }
 
+  /**
+   * Count the calls with the given arguments as they happen.
+   *
+   * Assertions such as check_called().with(args...).exactly(n) then
+   * use the counter instead of scanning all the captures.
+   */
+  template<typename... watch_types>
+  void watch(watch_types&&... args) {
+    static_assert(
+        detail::captures_arguments<capture_strategy>::value,
+        "watch() requires a capture strategy that records the arguments");
+    watches_.watch(
+        capture_strategy::capture(std::forward<watch_types>(args)...),
+        captures_);
+  }
+
+  /// Count the calls for each distinct set of arguments.
+  void watch_all() {
+    static_assert(
+        detail::captures_arguments<capture_strategy>::value,
+        "watch_all() requires a capture strategy that records the arguments");
+    watches_.watch_all(captures_);
+  }
+
+  /**
+   * Create a new function assertion, reporting its result with @a
+   * reporting_strategy.
+   *
+   * check() and require() use the default reporting strategies,
+   * tests and tools can provide their own.
+   */
+  template<typename reporting_strategy>
+  detail::function_assertion<capture_strategy, reporting_strategy>
+  make_assertion(detail::location const & where) {
+    return detail::function_assertion<capture_strategy, reporting_strategy>(
+        captures_.sequence(), captures_.dropped(), &watches_, where);
+  }
+
   /// Create a new function assertion, where failures do not terminate
   /// the current test.
   detail::function_assertion<
     capture_strategy, detail::default_check_reporting>
   check(detail::location const & where) {
-    return detail::function_assertion<
-      capture_strategy, detail::default_check_reporting>(
-          captures_, where);
+    return make_assertion<detail::default_check_reporting>(where);
   }
 
   /// Create a new function assertion, where failures terminate the
@@ -159,18 +240,16 @@ class mock_function<return_type(arg_types...)> {
   detail::function_assertion<
     capture_strategy, detail::default_require_reporting>
   require(detail::location const & where) {
-    return detail::function_assertion<
-      capture_strategy, detail::default_require_reporting>(
-          captures_, where);
+    return make_assertion<detail::default_require_reporting>(where);
   }
 
-
   /**
    * Reset the mock to its initial state.
    */
   void clear() {
     clear_captures();
     clear_returns();
+    watches_.clear();
   }
 
   /**
@@ -186,17 +265,56 @@ class mock_function<return_type(arg_types...)> {
    */
   void clear_captures() {
     captures_.clear();
+    watches_.reset();
+  }
+
+  /**
+   * Only retain the captures for the last @a capacity calls.
+   *
+   * Once the mock has been called @a capacity times each new call
+   * overwrites the oldest capture.  call_count() still counts every
+   * call, while begin(), end(), at() and the assertions created by
+   * check_called() or require_called() only see the retained
+   * captures.  A capacity of 0 (the default) retains all the
+   * captures.
+   */
+  void set_capture_capacity(std::size_t capacity) {
+    captures_.set_capacity(capacity);
+  }
+
+  /**
+   * Allow (or stop allowing) calls from multiple threads.
+   *
+   * In thread-safe mode each thread records its calls separately, and
+   * the captures are merged, in call order, when they are examined
+   * (by check_called(), begin(), at(), call_count() and so forth).
+   * Configure the mock (returns(), when(), watch(), etc.) before the
+   * threads start calling it, and examine the captures after they
+   * stop, or at least from a single thread.
+   */
+  void set_thread_safe(bool enable) {
+    captures_.set_thread_safe(enable);
+    watches_.set_thread_safe(enable);
   }
 
   //@{
   /**
    * @name Accessors
    */
+  bool thread_safe() const {
+    return captures_.thread_safe();
+  }
   bool has_calls() const {
-    return not captures_.empty();
+    return captures_.call_count() != 0;
   }
   std::size_t call_count() const {
-    return captures_.size();
+    return captures_.call_count();
+  }
+  std::size_t capture_capacity() const {
+    return captures_.capacity();
+  }
+  std::size_t dropped_calls() const {
+    return captures_.dropped();
   }
   iterator begin() const {
     return captures_.begin();
@@ -213,11 +331,16 @@ class mock_function<return_type(arg_types...)> {
   //@}
 
  private:
-  capture_sequence captures_;
+  capture_buffer captures_;
   side_effects side_effects_;
+  watches watches_;
   return_function default_return_;
 };
 
 } // namespace skye
 
+#if defined(SKYE_USE_COMPILED_LIBRARY)
+#  include <skye/detail/extern_templates.hpp>
+#endif // SKYE_USE_COMPILED_LIBRARY
+
 #endif // skye_mock_function_hpp
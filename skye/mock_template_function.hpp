@@ -2,13 +2,14 @@
 #define skye_mock_template_function_hpp
 
 #include <skye/detail/argument_wrapper.hpp>
+#include <skye/detail/capture_buffer.hpp>
 #include <skye/detail/unknown_arguments_capture_by_value.hpp>
 #include <skye/detail/default_return.hpp>
 #include <skye/detail/function_assertion.hpp>
 #include <skye/detail/assertion_reporting.hpp>
 #include <skye/detail/set_action_proxy.hpp>
-
-#include <list>
+#include <skye/detail/side_effect_table.hpp>
+#include <skye/detail/watch_table.hpp>
 
 namespace skye {
 
@@ -62,19 +63,25 @@ class mock_template_function {
   typedef capture_strategy_T capture_strategy;
   typedef typename capture_strategy::value_type value_type;
   typedef typename capture_strategy::capture_sequence capture_sequence;
+  typedef detail::capture_buffer<capture_sequence> capture_buffer;
   typedef typename capture_sequence::const_iterator iterator;
   typedef std::function<bool(value_type const &)> predicate;
   typedef detail::set_action_proxy<return_type,predicate> set_action_proxy;
   typedef typename set_action_proxy::return_function return_function;
   typedef typename set_action_proxy::callback callback;
-  typedef std::list<std::pair<predicate, return_function>> side_effects;
+  typedef detail::side_effect_table<
+    capture_strategy, predicate, return_function> side_effects;
+  typedef detail::watch_table<capture_strategy> watches;
+  typedef std::function<void(value_type const &)> capture_hook;
   //@}
 
   /// Constructor
   mock_template_function()
       : captures_()
       , side_effects_()
-      , default_return_(detail::default_return<return_type>) {
+      , watches_()
+      , default_return_(detail::default_return<return_type>)
+      , capture_hook_() {
   }
 
   /**
@@ -86,13 +93,26 @@ class mock_template_function {
    */
   template<typename... arg_types>
   return_type operator()(arg_types&&... args) {
-    auto v = capture_strategy::capture(args...);
-    captures_.push_back(v);
-    for (auto & i : side_effects_) {
-      if (i.first(v)) {
-        return i.second();
+    return_function const * action = nullptr;
+    {
+      auto appender = captures_.append();
+      auto & v = capture_strategy::capture_into(
+          appender, std::forward<arg_types>(args)...);
+      if (watches_.active()) {
+        watches_.record(v);
+      }
+      if (capture_hook_) {
+        capture_hook_(v);
+      }
+      if (not side_effects_.empty()) {
+        action = side_effects_.find(v, v);
       }
     }
+    // ... the action runs without holding any locks, it may call the
+    // mock again ...
+    if (action != nullptr) {
+      return (*action)();
+    }
     return default_return_();
   }
 
@@ -126,30 +146,93 @@ class mock_template_function {
   /// Prepare a proxy for a given predicate.
   set_action_proxy whenp(predicate p) {
     callback cb = [this,p](return_function f) mutable {
-      this->side_effects_.push_back(std::make_pair(p, f));
+      this->side_effects_.add(p, f);
     };
     return set_action_proxy(cb);
   }
 
-  /// Create a predicate that matches the arguments and returns a
-  /// proxy for it.
+  /**
+   * Create a rule that matches the arguments and returns a proxy for it.
+   *
+   * If the arguments can be hashed the rule is stored in a hash
+   * table, so calls find it in O(1) time, otherwise the rule is
+   * checked in order with the predicates set by whenp().
+   */
   template<typename... arg_types>
   set_action_proxy when(arg_types&&... args) {
+    static_assert(
+        detail::captures_arguments<capture_strategy>::value,
+        "when() requires a capture strategy that records the arguments");
     auto match = capture_strategy::capture(std::forward<arg_types>(args)...);
+    if (capture_strategy::hashable(match)) {
+      callback cb = [this,match](return_function f) mutable {
+        this->side_effects_.add_exact(match, f);
+      };
+      return set_action_proxy(cb);
+    }
     predicate p = [match](value_type const & v) {
       return capture_strategy::equals(match, v);
     };
     return whenp(p);
   }
 
+  /**
+   * Call @a hook with each new capture, before any action runs.
+   *
+   * Mocks of asynchronous operations use the hook to complete the
+   * operations automatically, see skye::asio::stream_engine.  The
+   * hook runs while the capture is recorded, it must not call the
+   * mock.  Pass a null hook to remove it.  clear() does not remove
+   * the hook.
+   */
+  void set_capture_hook(capture_hook hook) {
+    capture_hook_ = std::move(hook);
+  }
+
+  /**
+   * Count the calls with the given arguments as they happen.
+   *
+   * Assertions such as check_called().with(args...).exactly(n) then
+   * use the counter instead of scanning all the captures.
+   */
+  template<typename... arg_types>
+  void watch(arg_types&&... args) {
+    static_assert(
+        detail::captures_arguments<capture_strategy>::value,
+        "watch() requires a capture strategy that records the arguments");
+    watches_.watch(
+        capture_strategy::capture(std::forward<arg_types>(args)...),
+        captures_);
+  }
+
+  /// Count the calls for each distinct set of arguments.
+  void watch_all() {
+    static_assert(
+        detail::captures_arguments<capture_strategy>::value,
+        "watch_all() requires a capture strategy that records the arguments");
+    watches_.watch_all(captures_);
+  }
+
+  /**
+   * Create a new function assertion, reporting its result with @a
+   * reporting_strategy.
+   *
+   * check() and require() use the default reporting strategies,
+   * tests and tools can provide their own.
+   */
+  template<typename reporting_strategy>
+  detail::function_assertion<capture_strategy, reporting_strategy>
+  make_assertion(detail::location const & where) {
+    return detail::function_assertion<capture_strategy, reporting_strategy>(
+        captures_.sequence(), captures_.dropped(), &watches_, where);
+  }
+
   /// Create a new function assertion, where failures do not terminate
   /// the current test.
   detail::function_assertion<
     capture_strategy, detail::default_check_reporting>
   check(detail::location const & where) {
-    return detail::function_assertion<
-      capture_strategy, detail::default_check_reporting>(
-          captures_, where);
+    return make_assertion<detail::default_check_reporting>(where);
   }
 
   /// Create a new function assertion, where failures terminate the
@@ -157,9 +240,7 @@ class mock_template_function {
   detail::function_assertion<
     capture_strategy, detail::default_require_reporting>
   require(detail::location const & where) {
-    return detail::function_assertion<
-      capture_strategy, detail::default_require_reporting>(
-          captures_, where);
+    return make_assertion<detail::default_require_reporting>(where);
   }
 
   /**
@@ -168,6 +249,7 @@ class mock_template_function {
   void clear() {
     clear_captures();
     clear_returns();
+    watches_.clear();
   }
 
   /**
@@ -183,17 +265,54 @@ class mock_template_function {
    */
   void clear_captures() {
     captures_.clear();
+    watches_.reset();
+  }
+
+  /**
+   * Only retain the captures for the last @a capacity calls.
+   *
+   * Once the mock has been called @a capacity times each new call
+   * overwrites the oldest capture.  call_count() still counts every
+   * call, while begin(), end(), at() and the assertions created by
+   * check_called() or require_called() only see the retained
+   * captures.  A capacity of 0 (the default) retains all the
+   * captures.
+   */
+  void set_capture_capacity(std::size_t capacity) {
+    captures_.set_capacity(capacity);
+  }
+
+  /**
+   * Allow (or stop allowing) calls from multiple threads.
+   *
+   * See mock_function::set_thread_safe() for details.
+   */
+  void set_thread_safe(bool enable) {
+    captures_.set_thread_safe(enable);
+    watches_.set_thread_safe(enable);
   }
 
   //@{
   /**
    * @name Accessors
    */
+  bool thread_safe() const {
+    return captures_.thread_safe();
+  }
+  bool has_capture_hook() const {
+    return static_cast<bool>(capture_hook_);
+  }
   bool has_calls() const {
-    return not captures_.empty();
+    return captures_.call_count() != 0;
   }
   std::size_t call_count() const {
-    return captures_.size();
+    return captures_.call_count();
+  }
+  std::size_t capture_capacity() const {
+    return captures_.capacity();
+  }
+  std::size_t dropped_calls() const {
+    return captures_.dropped();
   }
   iterator begin() const {
     return captures_.begin();
@@ -210,11 +329,17 @@ class mock_template_function {
   //@}
 
  private:
-  capture_sequence captures_;
+  capture_buffer captures_;
   side_effects side_effects_;
+  watches watches_;
   return_function default_return_;
+  capture_hook capture_hook_;
 };
 
 } // namespace skye
 
+#if defined(SKYE_USE_COMPILED_LIBRARY)
+#  include <skye/detail/extern_templates.hpp>
+#endif // SKYE_USE_COMPILED_LIBRARY
+
 #endif // skye_mock_template_function_hpp
@@ -26,3 +26,52 @@ BOOST_AUTO_TEST_CASE(conditional_returns) {
   mock_function.returns( 42 );
   BOOST_CHECK_EQUAL(mock_function(6), 42);
 }
+
+/// @test Verify that many exact-value conditional returns are found.
+BOOST_AUTO_TEST_CASE(conditional_returns_many_rules) {
+  skye::mock_function<int(int,std::string const&)> mock_function;
+
+  for (int i = 0; i != 500; ++i) {
+    mock_function.when( int(i), std::string("foo") ).returns( 2 * i );
+  }
+  mock_function.returns( -1 );
+
+  BOOST_CHECK_EQUAL(mock_function(0, "foo"), 0);
+  BOOST_CHECK_EQUAL(mock_function(250, "foo"), 500);
+  BOOST_CHECK_EQUAL(mock_function(499, "foo"), 998);
+  BOOST_CHECK_EQUAL(mock_function(499, "bar"), -1);
+  BOOST_CHECK_EQUAL(mock_function(500, "foo"), -1);
+}
+
+/// @test Verify that the first matching conditional return wins.
+BOOST_AUTO_TEST_CASE(conditional_returns_registration_order) {
+  typedef skye::mock_function<int(int)> mock_type;
+
+  mock_type mock_function;
+  mock_function.when( 1 ).returns( 10 );
+  mock_function.whenp( [](int&& x) { return x < 3; } ).returns( 20 );
+  mock_function.when( 2 ).returns( 30 );
+  mock_function.when( 1 ).returns( 40 );
+  mock_function.when( 5 ).returns( 50 );
+
+  BOOST_CHECK_EQUAL(mock_function(1), 10);
+  BOOST_CHECK_EQUAL(mock_function(2), 20);
+  BOOST_CHECK_EQUAL(mock_function(0), 20);
+  BOOST_CHECK_EQUAL(mock_function(5), 50);
+  BOOST_CHECK_THROW(mock_function(7), std::exception);
+}
+
+/// @test Verify that predicates see the arguments before they are
+/// moved into the capture.
+BOOST_AUTO_TEST_CASE(conditional_returns_predicates_before_capture) {
+  skye::mock_function<int(std::string)> mock_function;
+  mock_function.whenp( [](std::string&& x) { return x == "foo"; } )
+      .returns( 1 );
+  mock_function.returns( 0 );
+
+  BOOST_CHECK_EQUAL(mock_function(std::string("foo")), 1);
+  BOOST_CHECK_EQUAL(mock_function(std::string("bar")), 0);
+  BOOST_REQUIRE_EQUAL(mock_function.call_count(), 2);
+  BOOST_CHECK_EQUAL(std::get<0>(mock_function.at(0)), "foo");
+  BOOST_CHECK_EQUAL(std::get<0>(mock_function.at(1)), "bar");
+}
@@ -26,3 +26,22 @@ BOOST_AUTO_TEST_CASE(template_conditional_returns) {
   mock_function.returns( 43 );
   BOOST_CHECK_EQUAL(mock_function(7), 43);
 }
+
+/// @test Verify that the first matching conditional return wins for
+/// mock templates.
+BOOST_AUTO_TEST_CASE(template_conditional_returns_registration_order) {
+  typedef skye::mock_template_function<int> mock_type;
+
+  mock_type mock_function;
+  mock_function.when( 1 ).returns( 10 );
+  mock_function.whenp(
+      [](mock_type::value_type const & v) {
+        return v->argument_count() == 2; } ).returns( 20 );
+  mock_function.when( 1, 2 ).returns( 30 );
+  mock_function.when( 3, 4, 5 ).returns( 40 );
+
+  BOOST_CHECK_EQUAL(mock_function(1), 10);
+  BOOST_CHECK_EQUAL(mock_function(1, 2), 20);
+  BOOST_CHECK_EQUAL(mock_function(3, 4, 5), 40);
+  BOOST_CHECK_THROW(mock_function(3, 4, 6), std::exception);
+}
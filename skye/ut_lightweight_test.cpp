@@ -0,0 +1,109 @@
+#include <skye/lightweight_test.hpp>
+#include <skye/mock_function.hpp>
+
+#include <sstream>
+#include <stdexcept>
+
+using namespace skye::detail;
+
+namespace {
+void passing_case() {
+  SKYE_CHECK(true);
+  SKYE_CHECK_EQUAL(2, 2);
+}
+
+void failing_check_case() {
+  SKYE_CHECK_EQUAL(1, 2);
+  SKYE_CHECK(true);
+}
+
+void failing_require_case() {
+  SKYE_REQUIRE(false);
+  throw std::logic_error("not reached");
+}
+
+void failing_mock_case() {
+  skye::mock_function<void(int)> f;
+  f(1);
+  f.check_called().once().with(2);
+}
+
+void throwing_case() {
+  throw std::runtime_error("boom");
+}
+} // anonymous namespace
+
+/**
+ * @test Verify that the lightweight runner records passing and
+ * failing test cases.
+ */
+SKYE_TEST_CASE( lightweight_runner_basic ) {
+  lightweight_runner::test_cases cases{
+    {"passing_case", &passing_case, "t.cpp", 1},
+    {"failing_check_case", &failing_check_case, "t.cpp", 2},
+    {"failing_require_case", &failing_require_case, "t.cpp", 3},
+    {"throwing_case", &throwing_case, "t.cpp", 4},
+  };
+
+  std::ostringstream os;
+  lightweight_runner runner(os);
+  SKYE_CHECK_EQUAL(runner.run(cases, ""), 3U);
+  SKYE_CHECK_EQUAL(runner.checks(), 5U);
+  SKYE_CHECK_EQUAL(runner.failed_checks(), 2U);
+
+  std::string const out = os.str();
+  SKYE_CHECK(out.find("SKYE_CHECK_EQUAL(1, 2) [1 != 2]") != std::string::npos);
+  SKYE_CHECK(out.find("required assertion failure: SKYE_REQUIRE(false)")
+             != std::string::npos);
+  SKYE_CHECK(out.find("not reached") == std::string::npos);
+  SKYE_CHECK(out.find("t.cpp:4: uncaught exception: boom")
+             != std::string::npos);
+  SKYE_CHECK(out.find("test case passing_case failed") == std::string::npos);
+  SKYE_CHECK(out.find("4 test case(s), 3 failed") != std::string::npos);
+}
+
+/**
+ * @test Verify that mock assertions fail the current test case.
+ */
+SKYE_TEST_CASE( lightweight_runner_mock ) {
+  lightweight_runner::test_cases cases{
+    {"passing_case", &passing_case, "t.cpp", 1},
+    {"failing_mock_case", &failing_mock_case, "t.cpp", 2},
+  };
+
+  std::ostringstream os;
+  lightweight_runner runner(os);
+  SKYE_CHECK_EQUAL(runner.run(cases, ""), 1U);
+  SKYE_CHECK(os.str().find("test case failing_mock_case failed")
+             != std::string::npos);
+
+  // ... the enclosing runner gets the hooks back ...
+  skye::mock_function<void(int)> f;
+  f(2);
+  f.check_called().once().with(2);
+}
+
+/**
+ * @test Verify that the runner filters the test cases by name.
+ */
+SKYE_TEST_CASE( lightweight_runner_filter ) {
+  lightweight_runner::test_cases cases{
+    {"passing_case", &passing_case, "t.cpp", 1},
+    {"failing_check_case", &failing_check_case, "t.cpp", 2},
+  };
+
+  std::ostringstream os;
+  lightweight_runner runner(os);
+  SKYE_CHECK_EQUAL(runner.run(cases, "passing"), 0U);
+  SKYE_CHECK(os.str().find("1 test case(s), 0 failed") != std::string::npos);
+}
+
+/**
+ * @test Verify SKYE_CHECK_THROW().
+ */
+SKYE_TEST_CASE( lightweight_check_throw ) {
+  SKYE_CHECK_THROW(throw std::runtime_error("x"), std::runtime_error);
+  SKYE_CHECK_THROW(throw std::runtime_error("x"), std::exception);
+}
+
+SKYE_LIGHTWEIGHT_TEST_MAIN
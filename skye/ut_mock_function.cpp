@@ -1,8 +1,13 @@
 #include <skye/mock_function.hpp>
+#include <skye/detail/count_only_capture.hpp>
 #include <skye/detail/tuple_streaming.hpp>
 
 #include <boost/test/unit_test.hpp>
 
+#include <string>
+#include <thread>
+#include <vector>
+
 using namespace skye;
 
 /// Helper objects and types for the test
@@ -245,3 +250,466 @@ BOOST_AUTO_TEST_CASE( mock_function_asserts ) {
   function.check_called().at_least( 3 ).with( 7, std::string("bar" ));
   function.check_called().with( 7, std::string("bar" ));
 }
+
+/**
+ * @test Verify that mock functions can retain only the most recent
+ * calls.
+ */
+BOOST_AUTO_TEST_CASE( mock_function_bounded_captures ) {
+  mock_function<void(int,std::string)> function;
+  function.set_capture_capacity(3);
+  BOOST_CHECK_EQUAL(function.capture_capacity(), 3);
+
+  for (int i = 0; i != 100; ++i) {
+    function(i, std::string("foo"));
+  }
+  BOOST_CHECK(function.has_calls());
+  BOOST_CHECK_EQUAL(function.call_count(), 100);
+  BOOST_CHECK_EQUAL(function.dropped_calls(), 97);
+  BOOST_CHECK_EQUAL(std::distance(function.begin(), function.end()), 3);
+  BOOST_CHECK_EQUAL(std::get<0>(function.at(0)), 97);
+  BOOST_CHECK_EQUAL(std::get<0>(function.at(2)), 99);
+
+  function.check_called().exactly( 3 );
+  function.check_called().once().with( 98, std::string("foo") );
+  function.check_called().never().with( 7, std::string("foo") );
+
+  function.clear_captures();
+  BOOST_CHECK(not function.has_calls());
+  BOOST_CHECK_EQUAL(function.dropped_calls(), 0);
+}
+
+/**
+ * Helper types to verify that arguments need not be assignable.
+ */
+namespace {
+/// A type with a user-provided copy constructor, and no assignment.
+struct not_assignable {
+  explicit not_assignable(int v)
+      : value(v)
+  {}
+  not_assignable(not_assignable const & rhs)
+      : value(rhs.value)
+  {}
+  not_assignable(not_assignable &&) = default;
+
+  bool operator==(not_assignable const & rhs) const {
+    return value == rhs.value;
+  }
+
+  int value;
+};
+
+std::ostream & operator<<(std::ostream & os, not_assignable const & x) {
+  return os << x.value;
+}
+} // anonymous namespace
+
+/**
+ * @test Verify that mock functions work with arguments that cannot
+ * be assigned, bounded or not.
+ */
+BOOST_AUTO_TEST_CASE( mock_function_not_assignable ) {
+  mock_function<void(not_assignable)> function;
+  function(not_assignable(1));
+  function(not_assignable(2));
+  function.check_called().exactly( 2 );
+  function.check_called().once().with( not_assignable(1) );
+
+  function.set_capture_capacity(2);
+  for (int i = 3; i != 10; ++i) {
+    function(not_assignable(i));
+  }
+  BOOST_CHECK_EQUAL(function.call_count(), 9);
+  BOOST_CHECK_EQUAL(function.dropped_calls(), 7);
+  BOOST_CHECK_EQUAL(std::get<0>(function.at(0)).value.value, 8);
+  BOOST_CHECK_EQUAL(std::get<0>(function.at(1)).value.value, 9);
+
+  function.set_capture_capacity(1);
+  BOOST_CHECK_EQUAL(std::get<0>(function.at(0)).value.value, 9);
+}
+
+/**
+ * @test Verify that mock functions can count calls without capturing
+ * the arguments.
+ */
+BOOST_AUTO_TEST_CASE( mock_function_count_only ) {
+  mock_function<int(std::string const&), detail::count_only_capture> function;
+  function.returns( 7 );
+
+  function.check_called().never();
+  std::string const large(1024, 'x');
+  for (int i = 0; i != 5; ++i) {
+    BOOST_CHECK_EQUAL(function(large), 7);
+  }
+  BOOST_CHECK_EQUAL(function.call_count(), 5);
+  function.check_called().exactly( 5 );
+  function.check_called().between( 2, 7 );
+}
+
+/**
+ * Helper types to verify how arguments are captured.
+ */
+namespace {
+/// Count how many times an object is copied and moved.
+struct copy_counter {
+  copy_counter()
+      : copies(0)
+      , moves(0)
+  {}
+  copy_counter(copy_counter const & rhs)
+      : copies(rhs.copies + 1)
+      , moves(rhs.moves)
+  {}
+  copy_counter(copy_counter && rhs)
+      : copies(rhs.copies)
+      , moves(rhs.moves + 1)
+  {}
+  copy_counter & operator=(copy_counter const &) = default;
+  copy_counter & operator=(copy_counter &&) = default;
+
+  bool operator==(copy_counter const &) const {
+    return true;
+  }
+
+  int copies;
+  int moves;
+};
+} // anonymous namespace
+
+/**
+ * @test Verify that arguments are moved (or copied) into the capture
+ * exactly once.
+ */
+BOOST_AUTO_TEST_CASE( mock_function_capture_moves_once ) {
+  mock_function<void(copy_counter)> by_value;
+  by_value(copy_counter());
+  // ... the temporary is constructed in the argument, and then moved
+  // into the capture ...
+  BOOST_CHECK_EQUAL(std::get<0>(by_value.at(0)).value.copies, 0);
+  BOOST_CHECK_EQUAL(std::get<0>(by_value.at(0)).value.moves, 1);
+
+  mock_function<void(copy_counter const&)> by_reference;
+  copy_counter original;
+  by_reference(original);
+  BOOST_CHECK_EQUAL(std::get<0>(by_reference.at(0)).value.copies, 1);
+  BOOST_CHECK_EQUAL(std::get<0>(by_reference.at(0)).value.moves, 0);
+}
+
+/**
+ * @test Verify that when() rules do not move from the arguments.
+ */
+BOOST_AUTO_TEST_CASE( mock_function_when_does_not_move_arguments ) {
+  mock_function<int(std::vector<int>)> function;
+  function.when( std::vector<int>{1, 2} ).returns( 7 );
+  function.when( std::vector<int>{3} ).returns( 8 );
+
+  BOOST_CHECK_EQUAL(function(std::vector<int>{3}), 8);
+  BOOST_CHECK_EQUAL(function(std::vector<int>{1, 2}), 7);
+  function.check_called().with( std::vector<int>{3} ).once();
+  function.check_called().with( std::vector<int>{1, 2} ).once();
+}
+
+/**
+ * @test Verify that whenp() predicates cannot move the arguments out
+ * of the capture.
+ */
+BOOST_AUTO_TEST_CASE( mock_function_whenp_does_not_move_arguments ) {
+  mock_function<int(std::string)> function;
+  function.returns( 0 );
+  function.whenp([](std::string s) {
+      std::string sink(std::move(s));
+      return sink == "abc";
+    }).returns( 1 );
+  function.whenp([](std::string s) { return s == "abc"; }).returns( 2 );
+
+  BOOST_CHECK_EQUAL(function(std::string("abc")), 1);
+  BOOST_CHECK_EQUAL(std::get<0>(function.at(0)).value, "abc");
+  function.check_called().with( std::string("abc") ).once();
+}
+
+/**
+ * Helper types to verify how captures are validated.
+ */
+namespace {
+/// Count how many objects of this type are copied.
+struct global_copy_counter {
+  static int copies;
+
+  explicit global_copy_counter(int v)
+      : value(v)
+  {}
+  global_copy_counter(global_copy_counter const & rhs)
+      : value(rhs.value) {
+    ++copies;
+  }
+  global_copy_counter(global_copy_counter &&) = default;
+  global_copy_counter & operator=(global_copy_counter const &) = default;
+  global_copy_counter & operator=(global_copy_counter &&) = default;
+
+  bool operator==(global_copy_counter const & rhs) const {
+    return value == rhs.value;
+  }
+
+  int value;
+};
+
+int global_copy_counter::copies = 0;
+
+std::ostream & operator<<(std::ostream & os, global_copy_counter const & x) {
+  return os << x.value;
+}
+} // anonymous namespace
+
+/**
+ * @test Verify that validation does not copy the captures.
+ */
+BOOST_AUTO_TEST_CASE( mock_function_validation_does_not_copy ) {
+  mock_function<void(global_copy_counter)> function;
+  for (int i = 0; i != 1000; ++i) {
+    function(global_copy_counter(i % 10));
+  }
+  BOOST_CHECK_EQUAL(global_copy_counter::copies, 0);
+
+  function.check_called().exactly( 1000 );
+  function.check_called().exactly( 100 ).with( global_copy_counter(3) );
+  function.check_called().never().with( global_copy_counter(42) );
+  BOOST_CHECK_EQUAL(global_copy_counter::copies, 0);
+}
+
+/**
+ * @test Verify that all the predicates share a single copy of the
+ * arguments.
+ */
+BOOST_AUTO_TEST_CASE( mock_function_predicates_copy_once ) {
+  global_copy_counter::copies = 0;
+  mock_function<int(global_copy_counter)> function;
+  function.returns( 0 );
+  for (int i = 0; i != 5; ++i) {
+    function.whenp([](global_copy_counter && x) { return x.value < 0; })
+        .returns( 1 );
+  }
+  BOOST_CHECK_EQUAL(function(global_copy_counter(1)), 0);
+  BOOST_CHECK_EQUAL(global_copy_counter::copies, 1);
+}
+
+/**
+ * @test Verify that predicates registered after a matching when() rule
+ * are not evaluated.
+ */
+BOOST_AUTO_TEST_CASE( mock_function_when_stops_predicates ) {
+  mock_function<int(int)> function;
+  function.returns( 0 );
+  int checked = 0;
+  function.when( 2 ).returns( 1 );
+  function.whenp([&checked](int &&) { ++checked; return true; })
+      .returns( 2 );
+
+  BOOST_CHECK_EQUAL(function(2), 1);
+  BOOST_CHECK_EQUAL(checked, 0);
+  BOOST_CHECK_EQUAL(function(3), 2);
+  BOOST_CHECK_EQUAL(checked, 1);
+}
+
+/**
+ * Helper types to verify when assertion messages are formatted.
+ */
+namespace {
+/// Count how many times an object is printed.
+struct stream_counter {
+  static int count;
+
+  bool operator==(stream_counter const &) const {
+    return true;
+  }
+};
+
+int stream_counter::count = 0;
+
+std::ostream & operator<<(std::ostream & os, stream_counter const &) {
+  ++stream_counter::count;
+  return os << "stream_counter";
+}
+
+/// A reporting strategy that records the last message.
+struct recording_reporting {
+  static bool log_success;
+  static bool last_pass;
+  static std::string last_msg;
+
+  static void checkpoint(detail::location const &) {
+  }
+  static bool success_logging_enabled() {
+    return log_success;
+  }
+  static void report_success(
+      detail::location const &, std::string const & msg) {
+    last_pass = true;
+    last_msg = msg;
+  }
+  static void report_failure(
+      detail::location const &, std::string const & msg) {
+    last_pass = false;
+    last_msg = msg;
+  }
+};
+
+bool recording_reporting::log_success = false;
+bool recording_reporting::last_pass = false;
+std::string recording_reporting::last_msg;
+} // anonymous namespace
+
+/**
+ * @test Verify that assertion messages are only formatted when needed.
+ */
+BOOST_AUTO_TEST_CASE( mock_function_lazy_messages ) {
+  typedef mock_function<void(stream_counter)>::capture_strategy strategy;
+  strategy::capture_sequence captures;
+  captures.push_back(strategy::capture(stream_counter()));
+  captures.push_back(strategy::capture(stream_counter()));
+
+  typedef detail::function_assertion<strategy, recording_reporting> assertion;
+
+  assertion(captures, SKYE_LOCATION)
+      .exactly( 2 ).with( stream_counter() );
+  BOOST_CHECK(recording_reporting::last_pass);
+  BOOST_CHECK_EQUAL(recording_reporting::last_msg, "check_called()");
+  BOOST_CHECK_EQUAL(stream_counter::count, 0);
+
+  recording_reporting::log_success = true;
+  assertion(captures, SKYE_LOCATION)
+      .exactly( 2 ).with( stream_counter() );
+  BOOST_CHECK(recording_reporting::last_pass);
+  BOOST_CHECK_EQUAL(
+      recording_reporting::last_msg,
+      "check_called().exactly( 2 ).with( <stream_counter> )");
+  BOOST_CHECK_EQUAL(stream_counter::count, 1);
+
+  recording_reporting::log_success = false;
+  assertion(captures, SKYE_LOCATION)
+      .at_least( 3 ).with( stream_counter() );
+  BOOST_CHECK(not recording_reporting::last_pass);
+  BOOST_CHECK_EQUAL(
+      recording_reporting::last_msg,
+      "check_called()failed validation, expected at least 3 invocations,"
+      " but only 2 where present.");
+  BOOST_CHECK_EQUAL(stream_counter::count, 1);
+}
+
+/**
+ * Helper types to verify watched assertions.
+ */
+namespace {
+/// Count how many times objects of this type are compared.
+struct compare_counter {
+  static int comparisons;
+
+  bool operator==(compare_counter const & rhs) const {
+    ++comparisons;
+    return value == rhs.value;
+  }
+
+  int value;
+};
+
+int compare_counter::comparisons = 0;
+
+std::ostream & operator<<(std::ostream & os, compare_counter const & x) {
+  return os << x.value;
+}
+} // anonymous namespace
+
+namespace std {
+template<>
+struct hash<compare_counter> {
+  std::size_t operator()(compare_counter const & x) const {
+    return std::hash<int>()(x.value);
+  }
+};
+} // namespace std
+
+/**
+ * @test Verify that watched values are asserted without scanning the
+ * captures.
+ */
+BOOST_AUTO_TEST_CASE( mock_function_watch ) {
+  mock_function<void(compare_counter)> function;
+  function(compare_counter{1});
+  function.watch(compare_counter{1});
+  function.watch(compare_counter{2});
+
+  for (int i = 0; i != 1000; ++i) {
+    function(compare_counter{i % 4});
+  }
+
+  compare_counter::comparisons = 0;
+  function.check_called().with( compare_counter{1} ).exactly( 251 );
+  function.check_called().with( compare_counter{2} ).exactly( 250 );
+  BOOST_CHECK_LE(compare_counter::comparisons, 2);
+
+  // ... values not watched still work, by scanning ...
+  function.check_called().with( compare_counter{3} ).exactly( 250 );
+  BOOST_CHECK_GE(compare_counter::comparisons, 1000);
+
+  function.clear_captures();
+  function.check_called().with( compare_counter{1} ).never();
+  function(compare_counter{1});
+  function.check_called().with( compare_counter{1} ).once();
+}
+
+/**
+ * @test Verify that histograms answer assertions for any value.
+ */
+BOOST_AUTO_TEST_CASE( mock_function_watch_all ) {
+  mock_function<void(compare_counter)> function;
+  function.watch_all();
+  for (int i = 0; i != 1000; ++i) {
+    function(compare_counter{i % 10});
+  }
+
+  compare_counter::comparisons = 0;
+  function.check_called().with( compare_counter{7} ).exactly( 100 );
+  function.check_called().with( compare_counter{42} ).never();
+  BOOST_CHECK_LE(compare_counter::comparisons, 1);
+
+  // ... bounded captures disable the counters ...
+  function.set_capture_capacity(10);
+  function.check_called().with( compare_counter{7} ).once();
+}
+
+/**
+ * @test Verify that mocks can be called from multiple threads.
+ */
+BOOST_AUTO_TEST_CASE( mock_function_thread_safe ) {
+  mock_function<int(int)> function;
+  function.set_thread_safe(true);
+  BOOST_CHECK(function.thread_safe());
+  function.returns( 7 );
+  function.when( 42 ).returns( 42 );
+  function.watch( 3 );
+
+  int const thread_count = 4;
+  int const per_thread = 5000;
+  std::vector<std::thread> threads;
+  std::vector<int> sums(thread_count, 0);
+  for (int t = 0; t != thread_count; ++t) {
+    threads.emplace_back([&function, &sums, t, per_thread]() {
+        for (int i = 0; i != per_thread; ++i) {
+          sums[t] += function(i % 50);
+        }
+      });
+  }
+  for (auto & t : threads) {
+    t.join();
+  }
+
+  int const per_value = thread_count * per_thread / 50;
+  for (int t = 0; t != thread_count; ++t) {
+    BOOST_CHECK_EQUAL(sums[t], (per_thread - per_thread / 50) * 7
+                      + (per_thread / 50) * 42);
+  }
+  BOOST_CHECK_EQUAL(function.call_count(), thread_count * per_thread);
+  function.check_called().exactly( thread_count * per_thread );
+  function.check_called().with( 3 ).exactly( per_value );
+  function.check_called().with( 42 ).exactly( per_value );
+}
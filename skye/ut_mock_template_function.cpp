@@ -1,4 +1,5 @@
 #include <skye/mock_template_function.hpp>
+#include <skye/detail/count_only_capture.hpp>
 
 #include <boost/test/unit_test.hpp>
 #include <sstream>
@@ -133,3 +134,84 @@ BOOST_AUTO_TEST_CASE( mock_template_function_asserts ) {
 
 }
 
+
+/**
+ * @test Verify that mock template functions can retain only the most
+ * recent calls.
+ */
+BOOST_AUTO_TEST_CASE( mock_template_function_bounded_captures ) {
+  mock_template_function<void> function;
+  function.set_capture_capacity(2);
+
+  for (int i = 0; i != 10; ++i) {
+    function(i, std::string("foo"));
+  }
+  BOOST_CHECK_EQUAL(function.call_count(), 10);
+  BOOST_CHECK_EQUAL(function.dropped_calls(), 8);
+
+  function.check_called().exactly( 2 );
+  function.check_called().once().with( 9, std::string("foo") );
+  function.check_called().never().with( 0, std::string("foo") );
+}
+
+/**
+ * @test Verify that mock template functions can count calls without
+ * capturing the arguments.
+ */
+BOOST_AUTO_TEST_CASE( mock_template_function_count_only ) {
+  mock_template_function<void, detail::count_only_capture> function;
+
+  function(42, std::string("foo"));
+  function(std::string("foo"));
+  function();
+  BOOST_CHECK_EQUAL(function.call_count(), 3);
+  function.check_called().exactly( 3 );
+  function.check_called().at_least( 1 ).at_most( 3 );
+}
+
+/**
+ * @test Verify that template mocks can watch values.
+ */
+BOOST_AUTO_TEST_CASE( mock_template_function_watch ) {
+  mock_template_function<void> function;
+  function(std::string("foo"));
+  function.watch(std::string("foo"));
+  function.watch_all();
+
+  for (int i = 0; i != 100; ++i) {
+    function(i % 5);
+  }
+  function(std::string("foo"));
+
+  function.check_called().with( std::string("foo") ).exactly( 2 );
+  function.check_called().with( 3 ).exactly( 20 );
+  function.check_called().with( 3L ).never();
+  function.check_called().exactly( 102 );
+}
+
+/**
+ * @test Verify that the capture hook sees each call.
+ */
+BOOST_AUTO_TEST_CASE( mock_template_function_capture_hook ) {
+  mock_template_function<int> function;
+  function.returns( 7 );
+  int hooked = 0;
+  function.set_capture_hook(
+      [&hooked](mock_template_function<int>::value_type const & v) {
+        ++hooked;
+      });
+
+  BOOST_CHECK_EQUAL(function(1, 2), 7);
+  BOOST_CHECK_EQUAL(function(std::string("foo")), 7);
+  BOOST_CHECK_EQUAL(hooked, 2);
+
+  function.clear();
+  function.returns( 8 );
+  BOOST_CHECK_EQUAL(function(3), 8);
+  BOOST_CHECK_EQUAL(hooked, 3);
+
+  function.set_capture_hook(nullptr);
+  function(4);
+  BOOST_CHECK_EQUAL(hooked, 3);
+  function.check_called().exactly( 2 );
+}